@@ -6,29 +6,29 @@
 #include <bench/bench.h>
 #include <consensus/validation.h>
 #include <crypto/sha256.h>
+#include <node/miner.h>
 #include <test/util/mining.h>
 #include <test/util/script.h>
 #include <test/util/setup_common.h>
 #include <test/util/wallet.h>
 #include <txmempool.h>
 #include <validation.h>
-
+#include <validationinterface.h>
 
 #include <vector>
 
-static void AssembleBlock(benchmark::Bench& bench)
+/** Fill the mempool with loose transactions that spend the coinbases of newly mined blocks. */
+static std::vector<CTransactionRef> FillMempool(const TestingSetup& test_setup)
 {
-    const auto test_setup = MakeNoLogFileContext<const TestingSetup>();
-
     CScriptWitness witness;
     witness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
 
     // Collect some loose transactions that spend the coinbases of our mined blocks
     constexpr size_t NUM_BLOCKS{200};
-    std::array<CTransactionRef, NUM_BLOCKS - COINBASE_MATURITY + 1> txs;
+    std::vector<CTransactionRef> txs(NUM_BLOCKS - COINBASE_MATURITY + 1);
     for (size_t b{0}; b < NUM_BLOCKS; ++b) {
         CMutableTransaction tx;
-        tx.vin.push_back(MineBlock(test_setup->m_node, P2WSH_OP_TRUE));
+        tx.vin.push_back(MineBlock(test_setup.m_node, P2WSH_OP_TRUE));
         tx.vin.back().scriptWitness = witness;
         tx.vout.emplace_back(1337, P2WSH_OP_TRUE);
         if (NUM_BLOCKS - b >= COINBASE_MATURITY)
@@ -38,14 +38,65 @@ static void AssembleBlock(benchmark::Bench& bench)
         LOCK(::cs_main);
 
         for (const auto& txr : txs) {
-            const MempoolAcceptResult res = test_setup->m_node.chainman->ProcessTransaction(txr);
+            const MempoolAcceptResult res = test_setup.m_node.chainman->ProcessTransaction(txr);
             assert(res.m_result_type == MempoolAcceptResult::ResultType::VALID);
         }
     }
+    return txs;
+}
+
+static void AssembleBlock(benchmark::Bench& bench)
+{
+    const auto test_setup = MakeNoLogFileContext<const TestingSetup>();
+    FillMempool(*test_setup);
 
     bench.run([&] {
         PrepareBlock(test_setup->m_node, P2WSH_OP_TRUE);
     });
 }
 
+/**
+ * Replace a mempool transaction before every template request, like a busy
+ * mempool does between getblocktemplate calls, and get a template either from
+ * a BlockTemplateCache or by assembling a new block.
+ */
+static void AssembleBlockChurn(benchmark::Bench& bench, bool cached)
+{
+    const auto test_setup = MakeNoLogFileContext<const TestingSetup>();
+    const std::vector<CTransactionRef> txs{FillMempool(*test_setup)};
+    CTxMemPool& mempool{*test_setup->m_node.mempool};
+    ChainstateManager& chainman{*test_setup->m_node.chainman};
+
+    node::BlockTemplateCache cache{chainman, mempool, P2WSH_OP_TRUE};
+    if (cached) RegisterValidationInterface(&cache);
+
+    size_t i{0};
+    bench.run([&] {
+        const CTransactionRef& tx{txs[i++ % txs.size()]};
+        {
+            LOCK(::cs_main);
+            WITH_LOCK(mempool.cs, mempool.removeRecursive(*tx, MemPoolRemovalReason::EXPIRY));
+            const MempoolAcceptResult res{chainman.ProcessTransaction(tx)};
+            assert(res.m_result_type == MempoolAcceptResult::ResultType::VALID);
+        }
+        // Wait for the notifications in both cases, so that only getting the
+        // template differs.
+        SyncWithValidationInterfaceQueue();
+        if (cached) {
+            assert(cache.Get()->block.vtx.size() == txs.size() + 1);
+        } else {
+            LOCK(::cs_main);
+            const auto block_template{node::BlockAssembler{chainman.ActiveChainstate(), &mempool}.CreateNewBlock(P2WSH_OP_TRUE)};
+            assert(block_template->block.vtx.size() == txs.size() + 1);
+        }
+    });
+
+    if (cached) UnregisterValidationInterface(&cache);
+}
+
+static void AssembleBlockChurnUncached(benchmark::Bench& bench) { AssembleBlockChurn(bench, /*cached=*/false); }
+static void AssembleBlockChurnCached(benchmark::Bench& bench) { AssembleBlockChurn(bench, /*cached=*/true); }
+
 BENCHMARK(AssembleBlock);
+BENCHMARK(AssembleBlockChurnUncached);
+BENCHMARK(AssembleBlockChurnCached);
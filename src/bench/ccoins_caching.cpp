@@ -5,10 +5,13 @@
 
 #include <bench/bench.h>
 #include <coins.h>
+#include <memusage.h>
 #include <policy/policy.h>
+#include <random.h>
 #include <script/signingprovider.h>
 #include <test/util/transaction_utils.h>
 
+#include <unordered_map>
 #include <vector>
 
 // Microbenchmark for simple accesses to a CCoinsViewCache database. Note from
@@ -52,3 +55,68 @@ static void CCoinsCaching(benchmark::Bench& bench)
 }
 
 BENCHMARK(CCoinsCaching);
+
+//! Memory budget the cache fill benchmarks try to stay within, similar to a small -dbcache.
+static constexpr size_t COINS_FILL_BUDGET_BYTES{8 << 20};
+
+static Coin MakeFillCoin(FastRandomContext& rng)
+{
+    CScript script;
+    script << OP_DUP << OP_HASH160 << rng.randbytes(20) << OP_EQUALVERIFY << OP_CHECKSIG;
+    return Coin{CTxOut{1 * COIN, script}, 1, false};
+}
+
+/**
+ * Insert coins into map until its accounted memory usage (map overhead plus the
+ * coins' own dynamic usage, as CCoinsViewCache::DynamicMemoryUsage() counts it)
+ * reaches COINS_FILL_BUDGET_BYTES. Returns the number of entries that fit.
+ */
+template <typename Map>
+static size_t FillCoinsMap(Map& map, FastRandomContext& rng)
+{
+    size_t coins_usage{0};
+    while (memusage::DynamicUsage(map) + coins_usage < COINS_FILL_BUDGET_BYTES) {
+        COutPoint outpoint{rng.rand256(), 0};
+        auto [it, inserted] = map.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint), std::forward_as_tuple(MakeFillCoin(rng)));
+        if (inserted) coins_usage += it->second.coin.DynamicMemoryUsage();
+    }
+    return map.size();
+}
+
+/**
+ * Fill a coins map up to the memory budget, as the tip cache does during IBD.
+ * The batch size is the number of entries that fit into the budget, so the
+ * entries-per-MiB of each allocator is batch / 8; it is recorded in the
+ * -output_json results, while the timings compare the fill throughput.
+ */
+static void CCoinsCacheFillStdAllocator(benchmark::Bench& bench)
+{
+    using StdCoinsMap = std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher>;
+    FastRandomContext rng{/*fDeterministic=*/true};
+    {
+        StdCoinsMap map;
+        bench.batch(FillCoinsMap(map, rng)).unit("coin");
+    }
+    bench.run([&] {
+        StdCoinsMap map;
+        FillCoinsMap(map, rng);
+    });
+}
+
+static void CCoinsCacheFillPoolAllocator(benchmark::Bench& bench)
+{
+    FastRandomContext rng{/*fDeterministic=*/true};
+    {
+        CCoinsMapMemoryResource resource;
+        CCoinsMap map{0, SaltedOutpointHasher{}, CCoinsMap::key_equal{}, &resource};
+        bench.batch(FillCoinsMap(map, rng)).unit("coin");
+    }
+    bench.run([&] {
+        CCoinsMapMemoryResource resource;
+        CCoinsMap map{0, SaltedOutpointHasher{}, CCoinsMap::key_equal{}, &resource};
+        FillCoinsMap(map, rng);
+    });
+}
+
+BENCHMARK(CCoinsCacheFillStdAllocator);
+BENCHMARK(CCoinsCacheFillPoolAllocator);
@@ -18,36 +18,32 @@ static const size_t BATCH_SIZE = 30;
 static const int PREVECTOR_SIZE = 28;
 static const unsigned int QUEUE_BATCH_SIZE = 128;
 
+struct PrevectorJob {
+    prevector<PREVECTOR_SIZE, uint8_t> p;
+    PrevectorJob() = default;
+    explicit PrevectorJob(FastRandomContext& insecure_rand){
+        p.resize(insecure_rand.randrange(PREVECTOR_SIZE*2));
+    }
+    bool operator()()
+    {
+        return true;
+    }
+    void swap(PrevectorJob& x) noexcept
+    {
+        p.swap(x.p);
+    };
+};
+
 // This Benchmark tests the CheckQueue with a slightly realistic workload,
 // where checks all contain a prevector that is indirect 50% of the time
 // and there is a little bit of work done between calls to Add.
-static void CCheckQueueSpeedPrevectorJob(benchmark::Bench& bench)
+static void RunCheckQueuePrevectorJob(benchmark::Bench& bench, int worker_threads)
 {
-    // We shouldn't ever be running with the checkqueue on a single core machine.
-    if (GetNumCores() <= 1) return;
-
     const ECCVerifyHandle verify_handle;
     ECC_Start();
 
-    struct PrevectorJob {
-        prevector<PREVECTOR_SIZE, uint8_t> p;
-        PrevectorJob() = default;
-        explicit PrevectorJob(FastRandomContext& insecure_rand){
-            p.resize(insecure_rand.randrange(PREVECTOR_SIZE*2));
-        }
-        bool operator()()
-        {
-            return true;
-        }
-        void swap(PrevectorJob& x) noexcept
-        {
-            p.swap(x.p);
-        };
-    };
     CCheckQueue<PrevectorJob> queue {QUEUE_BATCH_SIZE};
-    // The main thread should be counted to prevent thread oversubscription, and
-    // to decrease the variance of benchmark results.
-    queue.StartWorkerThreads(GetNumCores() - 1);
+    queue.StartWorkerThreads(worker_threads);
 
     // create all the data once, then submit copies in the benchmark.
     FastRandomContext insecure_rand(true);
@@ -71,4 +67,32 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::Bench& bench)
     queue.StopWorkerThreads();
     ECC_Stop();
 }
+
+static void CCheckQueueSpeedPrevectorJob(benchmark::Bench& bench)
+{
+    // We shouldn't ever be running with the checkqueue on a single core machine.
+    if (GetNumCores() <= 1) return;
+
+    // The main thread should be counted to prevent thread oversubscription, and
+    // to decrease the variance of benchmark results.
+    RunCheckQueuePrevectorJob(bench, GetNumCores() - 1);
+}
+
+// Show how the queue scales with the number of threads (including the
+// master), independent of the number of cores of the benchmarking machine.
+static void CCheckQueueSpeedPrevectorJob1Thread(benchmark::Bench& bench) { RunCheckQueuePrevectorJob(bench, 0); }
+static void CCheckQueueSpeedPrevectorJob2Threads(benchmark::Bench& bench) { RunCheckQueuePrevectorJob(bench, 1); }
+static void CCheckQueueSpeedPrevectorJob4Threads(benchmark::Bench& bench) { RunCheckQueuePrevectorJob(bench, 3); }
+static void CCheckQueueSpeedPrevectorJob8Threads(benchmark::Bench& bench) { RunCheckQueuePrevectorJob(bench, 7); }
+static void CCheckQueueSpeedPrevectorJob16Threads(benchmark::Bench& bench) { RunCheckQueuePrevectorJob(bench, 15); }
+static void CCheckQueueSpeedPrevectorJob32Threads(benchmark::Bench& bench) { RunCheckQueuePrevectorJob(bench, 31); }
+static void CCheckQueueSpeedPrevectorJob64Threads(benchmark::Bench& bench) { RunCheckQueuePrevectorJob(bench, 63); }
+
 BENCHMARK(CCheckQueueSpeedPrevectorJob);
+BENCHMARK(CCheckQueueSpeedPrevectorJob1Thread);
+BENCHMARK(CCheckQueueSpeedPrevectorJob2Threads);
+BENCHMARK(CCheckQueueSpeedPrevectorJob4Threads);
+BENCHMARK(CCheckQueueSpeedPrevectorJob8Threads);
+BENCHMARK(CCheckQueueSpeedPrevectorJob16Threads);
+BENCHMARK(CCheckQueueSpeedPrevectorJob32Threads);
+BENCHMARK(CCheckQueueSpeedPrevectorJob64Threads);
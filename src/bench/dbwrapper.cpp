@@ -0,0 +1,101 @@
+// Copyright (c) 2023-2023 The Koyotecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <dbwrapper.h>
+#include <fs.h>
+#include <hash.h>
+#include <random.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+#include <util/check.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+//! Entries in the database before lookups are measured
+static constexpr uint32_t PREFILLED_ENTRIES{200000};
+//! Lookups per measured iteration, half of them for missing keys
+static constexpr int LOOKUPS{1000};
+//! Entries per measured batch write
+static constexpr int WRITES{10000};
+//! Smaller than the database, so that lookups can't be served from the block cache alone
+static constexpr size_t CACHE_SIZE{1 << 20};
+
+namespace {
+//! Like the chainstate's coin entries: a txid and an output index as the key
+using Key = std::pair<uint256, uint32_t>;
+
+Key MakeKey(uint32_t i)
+{
+    const uint256 txid{(HashWriter{} << i).GetSHA256()};
+    return {txid, i % 4};
+}
+
+//! About the size of a serialized coin
+std::vector<unsigned char> MakeValue(uint32_t i)
+{
+    return std::vector<unsigned char>(40, static_cast<unsigned char>(i));
+}
+
+void Prefill(CDBWrapper& db)
+{
+    for (uint32_t start = 0; start < PREFILLED_ENTRIES; start += WRITES) {
+        CDBBatch batch{db};
+        for (uint32_t i = start; i < start + WRITES; ++i) batch.Write(MakeKey(i), MakeValue(i));
+        Assert(db.WriteBatch(batch));
+    }
+}
+
+/** Look up keys at random in a database with the given profile, like block validation does in the chainstate. */
+void Lookup(benchmark::Bench& bench, const std::string& profile_name)
+{
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>()};
+    CDBWrapper db{testing_setup->m_args.GetDataDirBase() / "db", CACHE_SIZE, /*fMemory=*/false, /*fWipe=*/true,
+                  /*obfuscate=*/true, *Assert(GetDBProfileByName(profile_name))};
+    Prefill(db);
+
+    FastRandomContext rand{/*fDeterministic=*/true};
+    bench.batch(LOOKUPS).unit("lookup").minEpochIterations(10).run([&] {
+        for (int i = 0; i < LOOKUPS; ++i) {
+            // Every other key was never written.
+            const uint32_t n{static_cast<uint32_t>(rand.randrange(PREFILLED_ENTRIES)) + (i % 2) * PREFILLED_ENTRIES};
+            std::vector<unsigned char> value;
+            const bool found{db.Read(MakeKey(n), value)};
+            assert(found == (n < PREFILLED_ENTRIES));
+        }
+    });
+}
+
+/** Write batches of new keys to a database with the given profile, like flushes and index syncs do. */
+void Write(benchmark::Bench& bench, const std::string& profile_name)
+{
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>()};
+    CDBWrapper db{testing_setup->m_args.GetDataDirBase() / "db", CACHE_SIZE, /*fMemory=*/false, /*fWipe=*/true,
+                  /*obfuscate=*/true, *Assert(GetDBProfileByName(profile_name))};
+
+    uint32_t next{0};
+    bench.batch(WRITES).unit("write").minEpochIterations(10).run([&] {
+        CDBBatch batch{db};
+        for (int i = 0; i < WRITES; ++i, ++next) batch.Write(MakeKey(next), MakeValue(next));
+        Assert(db.WriteBatch(batch));
+    });
+}
+} // namespace
+
+static void DBLookupDefault(benchmark::Bench& bench) { Lookup(bench, "default"); }
+static void DBLookupLookup(benchmark::Bench& bench) { Lookup(bench, "lookup"); }
+static void DBLookupBulk(benchmark::Bench& bench) { Lookup(bench, "bulk"); }
+static void DBWriteDefault(benchmark::Bench& bench) { Write(bench, "default"); }
+static void DBWriteLookup(benchmark::Bench& bench) { Write(bench, "lookup"); }
+static void DBWriteBulk(benchmark::Bench& bench) { Write(bench, "bulk"); }
+
+BENCHMARK(DBLookupDefault);
+BENCHMARK(DBLookupLookup);
+BENCHMARK(DBLookupBulk);
+BENCHMARK(DBWriteDefault);
+BENCHMARK(DBWriteLookup);
+BENCHMARK(DBWriteBulk);
@@ -0,0 +1,119 @@
+// Copyright (c) 2023-2023 The Koyotecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <coins.h>
+#include <fs.h>
+#include <kernel/coinstats.h>
+#include <node/utxo_snapshot.h>
+#include <random.h>
+#include <rpc/blockchain.h>
+#include <script/script.h>
+#include <streams.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <txdb.h>
+#include <univalue.h>
+#include <util/check.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <optional>
+#include <utility>
+#include <vector>
+
+//! Coins in the snapshot, a few chunks' worth
+static constexpr size_t SNAPSHOT_COINS{500000};
+
+static std::vector<std::pair<COutPoint, Coin>> MakeSnapshotCoins()
+{
+    FastRandomContext rand{/*fDeterministic=*/true};
+    std::vector<std::pair<COutPoint, Coin>> coins;
+    while (coins.size() < SNAPSHOT_COINS) {
+        const uint256 txid{rand.rand256()};
+        for (uint32_t n = 0, outputs = 1 + rand.randrange(3); n < outputs; ++n) {
+            CScript script;
+            script << OP_DUP << OP_HASH160 << rand.randbytes(20) << OP_EQUALVERIFY << OP_CHECKSIG;
+            coins.emplace_back(COutPoint{txid, n}, Coin{CTxOut{CAmount(rand.randrange(COIN)), script}, /*nHeightIn=*/0, /*fCoinBaseIn=*/false});
+        }
+    }
+    coins.resize(SNAPSHOT_COINS);
+    std::sort(coins.begin(), coins.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    return coins;
+}
+
+//! Put the coins into the active chainstate, on top of the genesis block.
+static void AddSnapshotCoins(const TestingSetup& testing_setup)
+{
+    const auto coins{MakeSnapshotCoins()};
+    LOCK(cs_main);
+    Chainstate& chainstate{testing_setup.m_node.chainman->ActiveChainstate()};
+    for (const auto& [outpoint, coin] : coins) {
+        chainstate.CoinsTip().AddCoin(outpoint, Coin{coin}, /*possible_overwrite=*/false);
+    }
+    Assert(chainstate.CoinsTip().Flush());
+}
+
+static void LoadSnapshot(benchmark::Bench& bench, const TestingSetup& testing_setup, const fs::path& path)
+{
+    bench.batch(SNAPSHOT_COINS).unit("coin").run([&] {
+        AutoFile file{fsbridge::fopen(path, "rb")};
+        node::SnapshotMetadata metadata;
+        file >> metadata;
+        CCoinsViewDB db{testing_setup.m_args.GetDataDirBase() / "snapshot_db", 8 << 20, /*fMemory=*/true, /*fWipe=*/false};
+        std::optional<kernel::CCoinsStats> stats;
+        Assert(LoadSnapshotCoins(file, metadata, /*base_height=*/0, db, stats));
+        assert(stats);
+    });
+}
+
+/** Load an unchunked snapshot of P2PKH coins, sorted in database order, into an in-memory coins database. */
+static void LoadSnapshotCoinsBench(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<const TestingSetup>()};
+    const uint256 base_hash{testing_setup->m_node.chainman->GetParams().GenesisBlock().GetHash()};
+    const auto coins{MakeSnapshotCoins()};
+
+    const fs::path path{testing_setup->m_args.GetDataDirBase() / "snapshot.dat"};
+    {
+        AutoFile file{fsbridge::fopen(path, "wb")};
+        node::SnapshotMetadata metadata{base_hash, coins.size(), /*nchaintx=*/0};
+        metadata.m_version = node::SNAPSHOT_VERSION_UNCHUNKED;
+        file << metadata;
+        for (const auto& [outpoint, coin] : coins) file << outpoint << coin;
+    }
+    LoadSnapshot(bench, *testing_setup, path);
+}
+
+/** Load a snapshot of the same coins as dumped by dumptxoutset, in chunks with their own checksum. */
+static void LoadChunkedSnapshotCoinsBench(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<TestingSetup>()};
+    AddSnapshotCoins(*testing_setup);
+
+    const fs::path path{testing_setup->m_args.GetDataDirBase() / "snapshot.dat"};
+    {
+        AutoFile file{fsbridge::fopen(path, "wb")};
+        CreateUTXOSnapshot(testing_setup->m_node, testing_setup->m_node.chainman->ActiveChainstate(), file, path, path);
+    }
+    LoadSnapshot(bench, *testing_setup, path);
+}
+
+/** Dump the coins of a chainstate into a chunked snapshot, like dumptxoutset does. */
+static void DumpSnapshotCoinsBench(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<TestingSetup>()};
+    AddSnapshotCoins(*testing_setup);
+
+    const fs::path path{testing_setup->m_args.GetDataDirBase() / "snapshot.dat"};
+    bench.batch(SNAPSHOT_COINS).unit("coin").run([&] {
+        AutoFile file{fsbridge::fopen(path, "wb")};
+        const UniValue result{CreateUTXOSnapshot(testing_setup->m_node, testing_setup->m_node.chainman->ActiveChainstate(), file, path, path)};
+        assert(result["coins_written"].getInt<uint64_t>() == SNAPSHOT_COINS);
+    });
+}
+
+BENCHMARK(LoadSnapshotCoinsBench);
+BENCHMARK(LoadChunkedSnapshotCoinsBench);
+BENCHMARK(DumpSnapshotCoinsBench);
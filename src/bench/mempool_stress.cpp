@@ -6,6 +6,7 @@
 #include <bench/bench.h>
 #include <policy/policy.h>
 #include <test/util/setup_common.h>
+#include <tinyformat.h>
 #include <txmempool.h>
 #include <validation.h>
 
@@ -100,6 +101,31 @@ static void ComplexMemPool(benchmark::Bench& bench)
     });
 }
 
+/**
+ * Fill the mempool with the transactions of ComplexMemPool and clear it again,
+ * and report how many transactions fit in a MB of mempool memory usage.
+ */
+static void MempoolFill(benchmark::Bench& bench)
+{
+    FastRandomContext det_rand{true};
+    std::vector<CTransactionRef> ordered_coins = CreateOrderedCoins(det_rand, /*childTxs=*/800, /*min_ancestors=*/1);
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(CBaseChainParams::MAIN);
+    CTxMemPool& pool = *testing_setup.get()->m_node.mempool;
+    LOCK2(cs_main, pool.cs);
+    size_t usage{0};
+    bench.batch(ordered_coins.size()).unit("tx").run([&]() NO_THREAD_SAFETY_ANALYSIS {
+        for (auto& tx : ordered_coins) {
+            AddTx(tx, pool);
+        }
+        usage = pool.DynamicMemoryUsage();
+        pool.clear();
+    });
+    if (bench.output()) {
+        *bench.output() << strprintf("MempoolFill: %u transactions, %.0f transactions per MB of memory usage\n",
+                                     ordered_coins.size(), ordered_coins.size() * 1e6 / usage);
+    }
+}
+
 static void MempoolCheck(benchmark::Bench& bench)
 {
     FastRandomContext det_rand{true};
@@ -116,4 +142,5 @@ static void MempoolCheck(benchmark::Bench& bench)
 }
 
 BENCHMARK(ComplexMemPool);
+BENCHMARK(MempoolFill);
 BENCHMARK(MempoolCheck);
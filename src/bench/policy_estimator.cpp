@@ -0,0 +1,78 @@
+// Copyright (c) 2023-2023 The Koyotecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <policy/fees.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <vector>
+
+//! Transactions seen per block while building up the estimator's history
+static constexpr int TXS_PER_BLOCK{100};
+
+static const CTxMemPoolEntry& AddEntry(std::deque<CTxMemPoolEntry>& entries, FastRandomContext& rand, unsigned int height)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout.hash = rand.rand256();
+    tx.vout.resize(1);
+    const CAmount fee{1000 + (CAmount)rand.randrange(100000)};
+    return entries.emplace_back(MakeTransactionRef(tx), fee, /*time=*/0, height, /*spends_coinbase=*/false, /*sigops_cost=*/4, LockPoints{});
+}
+
+/**
+ * Ask for smart fee estimates at common targets while another thread keeps
+ * feeding mempool transactions to the estimator, like net processing does.
+ */
+static void EstimateSmartFeeUnderLoad(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<const TestingSetup>()};
+    CBlockPolicyEstimator& estimator{*testing_setup->m_node.fee_estimator};
+    FastRandomContext rand{/*fDeterministic=*/true};
+
+    // Record the history of 200 blocks which confirm the better paying half
+    // of the transactions seen since the previous one.
+    std::deque<CTxMemPoolEntry> entries;
+    unsigned int height{0};
+    for (; height < 200; ++height) {
+        std::vector<const CTxMemPoolEntry*> block;
+        for (int i = 0; i < TXS_PER_BLOCK; ++i) {
+            const CTxMemPoolEntry& entry{AddEntry(entries, rand, height)};
+            estimator.processTransaction(entry, /*validFeeEstimate=*/true);
+            if (entry.GetFee() > 50000) block.push_back(&entry);
+        }
+        estimator.processBlock(height + 1, block);
+    }
+
+    std::deque<CTxMemPoolEntry> load;
+    for (int i = 0; i < 1000; ++i) AddEntry(load, rand, height);
+    std::atomic<bool> stop{false};
+    std::thread load_thread{[&] {
+        while (!stop) {
+            for (const CTxMemPoolEntry& entry : load) {
+                estimator.processTransaction(entry, /*validFeeEstimate=*/true);
+            }
+            for (const CTxMemPoolEntry& entry : load) {
+                estimator.removeTx(entry.GetTx().GetHash(), /*inBlock=*/false);
+            }
+        }
+    }};
+
+    const std::vector<int> targets{2, 3, 6, 12, 24, 48, 144, 504, 1008};
+    bench.batch(targets.size()).unit("estimate").run([&] {
+        for (int target : targets) {
+            FeeCalculation fee_calc;
+            (void)estimator.estimateSmartFee(target, &fee_calc, /*conservative=*/false);
+        }
+    });
+
+    stop = true;
+    load_thread.join();
+}
+
+BENCHMARK(EstimateSmartFeeUnderLoad);
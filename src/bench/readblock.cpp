@@ -0,0 +1,55 @@
+// Copyright (c) 2023-2023 The Koyotecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <test/util/mining.h>
+#include <test/util/script.h>
+#include <test/util/setup_common.h>
+#include <undo.h>
+#include <validation.h>
+
+#include <cassert>
+#include <vector>
+
+static void ReadBlocks(benchmark::Bench& bench, bool mmap)
+{
+    // Use small block files, so that the first one is finished after a few
+    // hundred blocks.
+    const auto testing_setup{MakeNoLogFileContext<const TestingSetup>(CBaseChainParams::REGTEST, {"-fastprune", mmap ? "-blocksmmap=1" : "-blocksmmap=0"})};
+    for (int i = 0; i < 400; ++i) {
+        MineBlock(testing_setup->m_node, P2WSH_OP_TRUE);
+    }
+
+    std::vector<const CBlockIndex*> blocks;
+    {
+        LOCK(cs_main);
+        const CChain& chain{testing_setup->m_node.chainman->ActiveChain()};
+        assert(chain.Tip()->GetBlockPos().nFile > 0);
+        for (int height = 1; height <= chain.Height() && chain[height]->GetBlockPos().nFile == 0; ++height) {
+            blocks.push_back(chain[height]);
+        }
+    }
+
+    const Consensus::Params& params{Params().GetConsensus()};
+    node::BlockManager& blockman{testing_setup->m_node.chainman->m_blockman};
+    bench.batch(blocks.size()).unit("block").run([&] {
+        for (const CBlockIndex* pindex : blocks) {
+            CBlock block;
+            bool ok{blockman.ReadBlockFromDisk(block, pindex, params)};
+            assert(ok);
+            CBlockUndo blockundo;
+            ok = blockman.UndoReadFromDisk(blockundo, pindex);
+            assert(ok);
+        }
+    });
+}
+
+static void ReadBlocksFile(benchmark::Bench& bench) { ReadBlocks(bench, false); }
+static void ReadBlocksMmap(benchmark::Bench& bench) { ReadBlocks(bench, true); }
+
+BENCHMARK(ReadBlocksFile);
+BENCHMARK(ReadBlocksMmap);
@@ -0,0 +1,96 @@
+// Copyright (c) 2023-2023 The Koyotecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <consensus/validation.h>
+#include <key.h>
+#include <script/sigcache.h>
+#include <script/sign.h>
+#include <script/signingprovider.h>
+#include <script/standard.h>
+#include <test/util/mining.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+#include <util/check.h>
+#include <util/translation.h>
+#include <validation.h>
+
+#include <map>
+#include <vector>
+
+//! Depth of the reorg; the transactions of up to 10 disconnected blocks are re-added to the mempool
+static constexpr int REORG_BLOCKS{10};
+//! Signed transactions in every disconnected block
+static constexpr int TXS_PER_BLOCK{50};
+
+/**
+ * Disconnect blocks full of signed transactions, which puts them back into the
+ * mempool, and connect the blocks again. The signature cache is emptied every
+ * time, like it would be for transactions that were mined long ago.
+ */
+static void ReorgMempoolReadd(benchmark::Bench& bench)
+{
+    const auto test_setup{MakeNoLogFileContext<const TestingSetup>()};
+    const node::NodeContext& node{test_setup->m_node};
+    ChainstateManager& chainman{*node.chainman};
+    CTxMemPool& mempool{*node.mempool};
+
+    CKey key;
+    key.MakeNewKey(/*fCompressed=*/true);
+    FillableSigningProvider keystore;
+    keystore.AddKey(key);
+    const CScript script_pub_key{GetScriptForDestination(WitnessV0KeyHash{key.GetPubKey()})};
+
+    const auto sign_and_submit{[&](CMutableTransaction& tx) {
+        LOCK(cs_main);
+        std::map<COutPoint, Coin> coins;
+        {
+            LOCK(mempool.cs);
+            CCoinsViewMemPool view{&chainman.ActiveChainstate().CoinsTip(), mempool};
+            for (const CTxIn& txin : tx.vin) Assert(view.GetCoin(txin.prevout, coins[txin.prevout]));
+        }
+        std::map<int, bilingual_str> input_errors;
+        Assert(SignTransaction(tx, &keystore, coins, SIGHASH_ALL, input_errors));
+        const MempoolAcceptResult res{chainman.ProcessTransaction(MakeTransactionRef(tx))};
+        assert(res.m_result_type == MempoolAcceptResult::ResultType::VALID);
+    }};
+
+    const CTxIn coinbase{MineBlock(node, script_pub_key)};
+    for (int i = 0; i < COINBASE_MATURITY; ++i) MineBlock(node, script_pub_key);
+
+    // Split the coinbase into an output for every transaction.
+    CMutableTransaction fan_out;
+    fan_out.vin.push_back(coinbase);
+    const CAmount coinbase_value{WITH_LOCK(cs_main, return chainman.ActiveChainstate().CoinsTip().AccessCoin(coinbase.prevout).out.nValue)};
+    const CAmount value{coinbase_value / (REORG_BLOCKS * TXS_PER_BLOCK + 1)};
+    fan_out.vout.resize(REORG_BLOCKS * TXS_PER_BLOCK, CTxOut{value, script_pub_key});
+    sign_and_submit(fan_out);
+    MineBlock(node, script_pub_key);
+
+    const int fork_height{WITH_LOCK(cs_main, return chainman.ActiveChain().Height())};
+    for (int b = 0; b < REORG_BLOCKS; ++b) {
+        for (int i = 0; i < TXS_PER_BLOCK; ++i) {
+            CMutableTransaction tx;
+            tx.vin.emplace_back(fan_out.GetHash(), b * TXS_PER_BLOCK + i);
+            tx.vout.emplace_back(value - 1000, script_pub_key);
+            sign_and_submit(tx);
+        }
+        MineBlock(node, script_pub_key);
+    }
+    assert(mempool.size() == 0);
+    CBlockIndex* first_block{WITH_LOCK(cs_main, return chainman.ActiveChain()[fork_height + 1])};
+
+    bench.batch(REORG_BLOCKS * TXS_PER_BLOCK).unit("tx").run([&] {
+        Assert(InitSignatureCache(DEFAULT_MAX_SIG_CACHE_BYTES));
+        BlockValidationState state;
+        chainman.ActiveChainstate().InvalidateBlock(state, first_block);
+        assert(mempool.size() == REORG_BLOCKS * TXS_PER_BLOCK);
+
+        WITH_LOCK(cs_main, chainman.ActiveChainstate().ResetBlockFailureFlags(first_block));
+        chainman.ActiveChainstate().ActivateBestChain(state);
+        assert(mempool.size() == 0);
+    });
+}
+
+BENCHMARK(ReorgMempoolReadd);
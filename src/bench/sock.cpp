@@ -0,0 +1,65 @@
+// Copyright (c) 2023-2023 The Koyotecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <compat/compat.h>
+#include <util/sock.h>
+#include <util/system.h>
+
+#include <cassert>
+#include <memory>
+#include <vector>
+
+#ifndef WIN32 // Windows does not have socketpair(2).
+
+//! Number of simulated connections, all but one of which stay idle.
+static constexpr size_t NUM_CONNECTIONS{2000};
+
+/**
+ * Wait on many connections of which only one has data to receive, either
+ * passing all of them to `Sock::WaitMany()` in every iteration, or through a
+ * `SockWaitSet` they were added to once, like CConnman::SocketHandler() does.
+ */
+static void WaitIdleSockets(benchmark::Bench& bench, bool persistent)
+{
+    const int fds_needed = 2 * NUM_CONNECTIONS + 64;
+    if (RaiseFileDescriptorLimit(fds_needed) < fds_needed) {
+        return;
+    }
+
+    std::vector<std::shared_ptr<const Sock>> local;
+    std::vector<std::shared_ptr<const Sock>> remote;
+    for (size_t i = 0; i < NUM_CONNECTIONS; ++i) {
+        int s[2];
+        assert(socketpair(AF_UNIX, SOCK_STREAM, 0, s) == 0);
+        local.push_back(std::make_shared<const Sock>(s[0]));
+        remote.push_back(std::make_shared<const Sock>(s[1]));
+    }
+    assert(remote.back()->Send("a", 1, 0) == 1);
+
+    SockWaitSet wait_set;
+    for (const auto& sock : local) {
+        wait_set.Set(sock, Sock::RECV);
+    }
+    bench.run([&] {
+        Sock::EventsPerSock events_per_sock;
+        if (persistent) {
+            assert(wait_set.Wait(0ms, events_per_sock));
+            assert(events_per_sock.size() == 1);
+        } else {
+            for (const auto& sock : local) {
+                events_per_sock.emplace(sock, Sock::Events{Sock::RECV});
+            }
+            assert(events_per_sock.begin()->first->WaitMany(0ms, events_per_sock));
+        }
+    });
+}
+
+static void SockWaitManyIdle(benchmark::Bench& bench) { WaitIdleSockets(bench, /*persistent=*/false); }
+static void SockWaitSetIdle(benchmark::Bench& bench) { WaitIdleSockets(bench, /*persistent=*/true); }
+
+BENCHMARK(SockWaitManyIdle);
+BENCHMARK(SockWaitSetIdle);
+
+#endif // WIN32
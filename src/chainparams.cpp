@@ -419,7 +419,13 @@ public:
                 {0, uint256S("0x0x57aa7c2bd78478eaef97ceb42e378e4dec8851902bcfccd393c9d32725337ac7")},
             }};
 
-        m_assumeutxo_data = MapAssumeutxo{};
+        m_assumeutxo_data = MapAssumeutxo{
+            {
+                // 199 blocks mined to raw(51), see feature_assumeutxo.py
+                199,
+                {AssumeutxoHash{uint256S("0xb3b33b135ceef5f57043e91168d2ca657ad41efeafbd7233b5e90fad4cf61f07")}, 200},
+            },
+        };
 
         chainTxData = ChainTxData{
             0,
@@ -12,6 +12,11 @@
 #include <util/threadnames.h>
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
 #include <vector>
 
 template <typename T>
@@ -26,12 +31,23 @@ class CCheckQueueControl;
   * onto the queue, where they are processed by N-1 worker threads. When
   * the master is done adding work, it temporarily joins the worker pool
   * as an N'th worker, until all jobs are done.
+  *
+  * Every thread has its own deque of verifications, which the master fills
+  * in turns. Threads take work from the back of their own deque, and once it
+  * is empty steal from the front of the others', so that there is no single
+  * lock all threads contend on.
   */
 template <typename T>
 class CCheckQueue
 {
 private:
-    //! Mutex to protect the inner state
+    //! Verifications queued for one thread, stolen from by the others.
+    struct WorkQueue {
+        Mutex m_mutex;
+        std::deque<T> m_checks GUARDED_BY(m_mutex);
+    };
+
+    //! Mutex to protect the waiting of the threads
     Mutex m_mutex;
 
     //! Worker threads block on this when out of work
@@ -40,25 +56,29 @@ private:
     //! Master thread blocks on this when out of work
     std::condition_variable m_master_cv;
 
-    //! The queue of elements to be processed.
-    //! As the order of booleans doesn't matter, it is used as a LIFO (stack)
-    std::vector<T> queue GUARDED_BY(m_mutex);
+    //! The work queues of the master (index 0) and the worker threads.
+    //! Only resized while no worker thread runs.
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
 
-    //! The number of workers (including the master) that are idle.
-    int nIdle GUARDED_BY(m_mutex){0};
+    //! The queue the next call to Add() starts filling.
+    size_t m_next_queue{0};
 
-    //! The total number of workers (including the master).
-    int nTotal GUARDED_BY(m_mutex){0};
+    //! Incremented whenever work is added, so that idle threads notice it.
+    uint64_t m_work_generation GUARDED_BY(m_mutex){0};
 
     //! The temporary evaluation result.
-    bool fAllOk GUARDED_BY(m_mutex){true};
+    std::atomic<bool> m_all_ok{true};
+
+    //! Whether checks still run after one of them failed, set by the
+    //! CCheckQueueControl that owns the queue.
+    std::atomic<bool> m_run_all{false};
 
     /**
      * Number of verifications that haven't completed yet.
-     * This includes elements that are no longer queued, but still in the
-     * worker's own batches.
+     * This includes elements that are no longer queued, but still in a
+     * thread's own batch.
      */
-    unsigned int nTodo GUARDED_BY(m_mutex){0};
+    std::atomic<size_t> m_todo{0};
 
     //! The maximum number of elements to be processed in one batch
     const unsigned int nBatchSize;
@@ -66,95 +86,113 @@ private:
     std::vector<std::thread> m_worker_threads;
     bool m_request_stop GUARDED_BY(m_mutex){false};
 
+    /**
+     * Move a batch of verifications to vChecks: from the back of the own
+     * queue if it has work, otherwise half of what the first non-empty other
+     * queue holds, taken from its front. Batches get smaller as the queues
+     * drain, so that all threads finish approximately simultaneously.
+     */
+    void TakeWork(size_t self, std::vector<T>& vChecks)
+    {
+        {
+            WorkQueue& own = *m_queues[self];
+            LOCK(own.m_mutex);
+            if (!own.m_checks.empty()) {
+                const size_t nNow{std::clamp<size_t>(own.m_checks.size() / 2, 1, nBatchSize)};
+                vChecks.resize(nNow);
+                for (T& check : vChecks) {
+                    // We want the lock to be held as short as possible, so swap
+                    // jobs from the queue to the local batch instead of copying.
+                    check.swap(own.m_checks.back());
+                    own.m_checks.pop_back();
+                }
+                return;
+            }
+        }
+        for (size_t i = 1; i < m_queues.size(); ++i) {
+            WorkQueue& victim = *m_queues[(self + i) % m_queues.size()];
+            LOCK(victim.m_mutex);
+            if (victim.m_checks.empty()) continue;
+            const size_t nNow{std::clamp<size_t>((victim.m_checks.size() + 1) / 2, 1, nBatchSize)};
+            vChecks.resize(nNow);
+            for (T& check : vChecks) {
+                check.swap(victim.m_checks.front());
+                victim.m_checks.pop_front();
+            }
+            return;
+        }
+    }
+
     /** Internal function that does bulk of the verification work. */
-    bool Loop(bool fMaster) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    bool Loop(size_t self) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
-        std::condition_variable& cond = fMaster ? m_master_cv : m_worker_cv;
+        const bool fMaster{self == 0};
         std::vector<T> vChecks;
         vChecks.reserve(nBatchSize);
-        unsigned int nNow = 0;
-        bool fOk = true;
-        do {
-            {
+        while (true) {
+            const uint64_t generation{WITH_LOCK(m_mutex, return m_work_generation)};
+            TakeWork(self, vChecks);
+            if (vChecks.empty()) {
                 WAIT_LOCK(m_mutex, lock);
-                // first do the clean-up of the previous loop run (allowing us to do it in the same critsect)
-                if (nNow) {
-                    fAllOk &= fOk;
-                    nTodo -= nNow;
-                    if (nTodo == 0 && !fMaster)
-                        // We processed the last element; inform the master it can exit and return the result
-                        m_master_cv.notify_one();
-                } else {
-                    // first iteration
-                    nTotal++;
-                }
-                // logically, the do loop starts here
-                while (queue.empty() && !m_request_stop) {
-                    if (fMaster && nTodo == 0) {
-                        nTotal--;
-                        bool fRet = fAllOk;
-                        // reset the status for new work later
-                        fAllOk = true;
-                        // return the current status
-                        return fRet;
-                    }
-                    nIdle++;
-                    cond.wait(lock); // wait
-                    nIdle--;
-                }
-                if (m_request_stop) {
-                    return false;
-                }
-
-                // Decide how many work units to process now.
-                // * Do not try to do everything at once, but aim for increasingly smaller batches so
-                //   all workers finish approximately simultaneously.
-                // * Try to account for idle jobs which will instantly start helping.
-                // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
-                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (nTotal + nIdle + 1)));
-                vChecks.resize(nNow);
-                for (unsigned int i = 0; i < nNow; i++) {
-                    // We want the lock on the m_mutex to be as short as possible, so swap jobs from the global
-                    // queue to the local batch vector instead of copying.
-                    vChecks[i].swap(queue.back());
-                    queue.pop_back();
+                if (fMaster) {
+                    // All work has been handed out; wait for it to complete.
+                    m_master_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_todo == 0 || m_request_stop; });
+                    if (m_request_stop) return false;
+                    // reset the status for new work later, and return the current one
+                    return m_all_ok.exchange(true);
                 }
-                // Check whether we need to do work at all
-                fOk = fAllOk;
+                m_worker_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_work_generation != generation || m_request_stop; });
+                if (m_request_stop) return false;
+                continue;
             }
+
+            // Check whether we need to do work at all
+            bool fOk{m_all_ok};
+            const bool run_all{m_run_all};
             // execute work
             for (T& check : vChecks)
-                if (fOk)
-                    fOk = check();
+                if (fOk || run_all)
+                    fOk = check() && fOk;
+            if (!fOk) m_all_ok = false;
+            const size_t nNow{vChecks.size()};
+            // Checks must be destroyed before they are reported as done.
             vChecks.clear();
-        } while (true);
+            if (m_todo.fetch_sub(nNow) == nNow) {
+                // We processed the last element; inform the master it can exit and return the result
+                LOCK(m_mutex);
+                m_master_cv.notify_one();
+            }
+        }
     }
 
 public:
     //! Mutex to ensure only one concurrent CCheckQueueControl
     Mutex m_control_mutex;
 
+    //! Keep running all checks after one failed, rather than skipping the
+    //! remaining ones. Only to be called by the owner of m_control_mutex.
+    void SetRunAll(bool run_all) { m_run_all = run_all; }
+
     //! Create a new check queue
     explicit CCheckQueue(unsigned int nBatchSizeIn)
         : nBatchSize(nBatchSizeIn)
     {
+        m_queues.push_back(std::make_unique<WorkQueue>());
     }
 
     //! Create a pool of new worker threads.
     void StartWorkerThreads(const int threads_num) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
-        {
-            LOCK(m_mutex);
-            nIdle = 0;
-            nTotal = 0;
-            fAllOk = true;
-        }
+        m_all_ok = true;
         assert(m_worker_threads.empty());
+        for (int n = 0; n < threads_num; ++n) {
+            m_queues.push_back(std::make_unique<WorkQueue>());
+        }
         for (int n = 0; n < threads_num; ++n) {
             m_worker_threads.emplace_back([this, n]() {
                 util::ThreadRename(strprintf("scriptch.%i", n));
                 SetSyscallSandboxPolicy(SyscallSandboxPolicy::VALIDATION_SCRIPT_CHECK);
-                Loop(false /* worker thread */);
+                Loop(n + 1 /* worker thread */);
             });
         }
     }
@@ -162,7 +200,7 @@ public:
     //! Wait until execution finishes, and return whether all evaluations were successful.
     bool Wait() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
-        return Loop(true /* master thread */);
+        return Loop(0 /* master thread */);
     }
 
     //! Add a batch of checks to the queue
@@ -172,14 +210,21 @@ public:
             return;
         }
 
-        {
-            LOCK(m_mutex);
-            for (T& check : vChecks) {
-                queue.emplace_back();
-                check.swap(queue.back());
+        // Count the checks before any thread can take (and complete) them.
+        m_todo += vChecks.size();
+        // Spread the checks over the queues in contiguous chunks, starting
+        // where the previous call left off.
+        const size_t chunk{(vChecks.size() + m_queues.size() - 1) / m_queues.size()};
+        for (size_t pos = 0; pos < vChecks.size(); pos += chunk) {
+            WorkQueue& queue = *m_queues[m_next_queue];
+            m_next_queue = (m_next_queue + 1) % m_queues.size();
+            LOCK(queue.m_mutex);
+            for (size_t i = pos; i < std::min(pos + chunk, vChecks.size()); ++i) {
+                queue.m_checks.emplace_back();
+                vChecks[i].swap(queue.m_checks.back());
             }
-            nTodo += vChecks.size();
         }
+        WITH_LOCK(m_mutex, ++m_work_generation);
 
         if (vChecks.size() == 1) {
             m_worker_cv.notify_one();
@@ -197,6 +242,8 @@ public:
             t.join();
         }
         m_worker_threads.clear();
+        m_queues.resize(1);
+        m_next_queue = 0;
         WITH_LOCK(m_mutex, m_request_stop = false);
     }
 
@@ -210,6 +257,10 @@ public:
 /**
  * RAII-style controller object for a CCheckQueue that guarantees the passed
  * queue is finished before continuing.
+ *
+ * With run_all, every check added is run even once one of them failed, for
+ * callers that are after the side effects of the checks rather than a single
+ * verdict over all of them.
  */
 template <typename T>
 class CCheckQueueControl
@@ -222,11 +273,12 @@ public:
     CCheckQueueControl() = delete;
     CCheckQueueControl(const CCheckQueueControl&) = delete;
     CCheckQueueControl& operator=(const CCheckQueueControl&) = delete;
-    explicit CCheckQueueControl(CCheckQueue<T> * const pqueueIn) : pqueue(pqueueIn), fDone(false)
+    explicit CCheckQueueControl(CCheckQueue<T> * const pqueueIn, bool run_all = false) : pqueue(pqueueIn), fDone(false)
     {
         // passed queue is supposed to be unused, or nullptr
         if (pqueue != nullptr) {
             ENTER_CRITICAL_SECTION(pqueue->m_control_mutex);
+            pqueue->SetRunAll(run_all);
         }
     }
 
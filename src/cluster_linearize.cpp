@@ -0,0 +1,165 @@
+// Copyright (c) 2023-2023 The Koyotecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <cluster_linearize.h>
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <optional>
+
+namespace cluster_linearize {
+namespace {
+/**
+ * Topologically sort the transactions. Of the transactions whose parents
+ * have all been included, the one that comes first according to better is
+ * included next.
+ */
+template <typename Better>
+std::vector<uint32_t> TopologicalOrder(const std::vector<std::vector<uint32_t>>& parents, Better better)
+{
+    const size_t n{parents.size()};
+    std::vector<std::vector<uint32_t>> children(n);
+    std::vector<size_t> missing(n);
+    std::vector<uint32_t> ready;
+    for (uint32_t i = 0; i < n; ++i) {
+        missing[i] = parents[i].size();
+        for (uint32_t parent : parents[i]) children[parent].push_back(i);
+        if (missing[i] == 0) ready.push_back(i);
+    }
+    // std::push_heap() keeps the greatest element at the front.
+    const auto worse{[&](uint32_t a, uint32_t b) { return better(b, a); }};
+    std::make_heap(ready.begin(), ready.end(), worse);
+
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    while (!ready.empty()) {
+        std::pop_heap(ready.begin(), ready.end(), worse);
+        const uint32_t i{ready.back()};
+        ready.pop_back();
+        order.push_back(i);
+        for (uint32_t child : children[i]) {
+            if (--missing[child] == 0) {
+                ready.push_back(child);
+                std::push_heap(ready.begin(), ready.end(), worse);
+            }
+        }
+    }
+    assert(order.size() == n);
+    return order;
+}
+
+/** Set of transactions of a cluster, indexed by position in a topological order. */
+class BitSet
+{
+    std::vector<uint64_t> m_words;
+
+public:
+    explicit BitSet(size_t size) : m_words((size + 63) / 64) {}
+
+    bool Has(size_t i) const { return (m_words[i / 64] >> (i % 64)) & 1; }
+    void Set(size_t i) { m_words[i / 64] |= uint64_t{1} << (i % 64); }
+    void Reset(size_t i) { m_words[i / 64] &= ~(uint64_t{1} << (i % 64)); }
+    BitSet& operator|=(const BitSet& other)
+    {
+        for (size_t w = 0; w < m_words.size(); ++w) m_words[w] |= other.m_words[w];
+        return *this;
+    }
+};
+} // namespace
+
+std::vector<Chunk> ChunkLinearization(Span<const uint32_t> order, Span<const CAmount> fees, Span<const int64_t> sizes)
+{
+    std::vector<Chunk> chunks;
+    for (uint32_t i : order) {
+        chunks.push_back({1, fees[i], sizes[i]});
+        // Merge the new chunk into its predecessor as long as it does not pay
+        // less than the predecessor, since they'd rather be mined together.
+        while (chunks.size() >= 2) {
+            Chunk& last{chunks.back()};
+            Chunk& prev{chunks[chunks.size() - 2]};
+            if (HigherFeerate(prev.fee, prev.size, last.fee, last.size)) break;
+            prev.count += last.count;
+            prev.fee += last.fee;
+            prev.size += last.size;
+            chunks.pop_back();
+        }
+    }
+    return chunks;
+}
+
+Linearization Linearize(Span<const CAmount> fees, Span<const int64_t> sizes, const std::vector<std::vector<uint32_t>>& parents)
+{
+    const size_t n{parents.size()};
+    assert(fees.size() == n && sizes.size() == n);
+    Linearization ret;
+
+    if (n > MAX_ANCESTOR_SET_LINEARIZATION) {
+        ret.order = TopologicalOrder(parents, [&](uint32_t a, uint32_t b) {
+            return HigherFeerate(fees[a], sizes[a], fees[b], sizes[b]);
+        });
+        ret.chunks = ChunkLinearization(ret.order, fees, sizes);
+        return ret;
+    }
+
+    // Work on positions in a topological order, so that iterating over
+    // positions visits parents before children.
+    const std::vector<uint32_t> topo{TopologicalOrder(parents, std::less<uint32_t>{})};
+    std::vector<uint32_t> pos(n);
+    for (uint32_t p = 0; p < n; ++p) pos[topo[p]] = p;
+
+    // Ancestor sets (including the transaction itself) and their fees and
+    // sizes, restricted to the transactions that haven't been included yet.
+    std::vector<BitSet> ancestors(n, BitSet{n});
+    std::vector<CAmount> anc_fee(n, 0);
+    std::vector<int64_t> anc_size(n, 0);
+    for (uint32_t p = 0; p < n; ++p) {
+        ancestors[p].Set(p);
+        for (uint32_t parent : parents[topo[p]]) ancestors[p] |= ancestors[pos[parent]];
+        for (uint32_t q = 0; q <= p; ++q) {
+            if (ancestors[p].Has(q)) {
+                anc_fee[p] += fees[topo[q]];
+                anc_size[p] += sizes[topo[q]];
+            }
+        }
+    }
+
+    BitSet remaining{n};
+    for (uint32_t p = 0; p < n; ++p) remaining.Set(p);
+    std::vector<uint32_t> included;
+    ret.order.reserve(n);
+    while (ret.order.size() < n) {
+        std::optional<uint32_t> best;
+        for (uint32_t p = 0; p < n; ++p) {
+            if (!remaining.Has(p)) continue;
+            if (!best || HigherFeerate(anc_fee[p], anc_size[p], anc_fee[*best], anc_size[*best])) best = p;
+        }
+
+        // Include the best ancestor set, in topological order.
+        included.clear();
+        for (uint32_t p = 0; p <= *best; ++p) {
+            if (remaining.Has(p) && ancestors[*best].Has(p)) {
+                included.push_back(p);
+                remaining.Reset(p);
+                ret.order.push_back(topo[p]);
+            }
+        }
+
+        // Descendants of the included transactions no longer need them.
+        for (uint32_t p = included.front() + 1; p < n; ++p) {
+            if (!remaining.Has(p)) continue;
+            for (uint32_t q : included) {
+                if (ancestors[p].Has(q)) {
+                    anc_fee[p] -= fees[topo[q]];
+                    anc_size[p] -= sizes[topo[q]];
+                }
+            }
+        }
+    }
+
+    ret.chunks = ChunkLinearization(ret.order, fees, sizes);
+    return ret;
+}
+
+} // namespace cluster_linearize
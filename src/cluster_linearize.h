@@ -0,0 +1,69 @@
+// Copyright (c) 2023-2023 The Koyotecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KOYOTECOIN_CLUSTER_LINEARIZE_H
+#define KOYOTECOIN_CLUSTER_LINEARIZE_H
+
+#include <consensus/amount.h>
+#include <span.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cluster_linearize {
+
+/**
+ * Clusters larger than this are linearized with a cheaper heuristic: the
+ * ancestor set search below is quadratic in the size of the cluster.
+ */
+static constexpr size_t MAX_ANCESTOR_SET_LINEARIZATION{1000};
+
+/** A group of consecutive transactions of a linearization that is best included together. */
+struct Chunk {
+    //! Number of transactions in the chunk
+    size_t count;
+    //! Sum of their fees
+    CAmount fee;
+    //! Sum of their sizes
+    int64_t size;
+};
+
+/** Whether a has a higher feerate than b. */
+inline bool HigherFeerate(CAmount fee_a, int64_t size_a, CAmount fee_b, int64_t size_b)
+{
+    // Like CompareTxMemPoolEntryByAncestorFee, use doubles so that the products cannot overflow.
+    return double(fee_a) * size_b > double(fee_b) * size_a;
+}
+
+struct Linearization {
+    //! Indices of the transactions, in a topologically valid order
+    std::vector<uint32_t> order;
+    //! Chunks of order, in order, with strictly decreasing feerates
+    std::vector<Chunk> chunks;
+};
+
+/**
+ * Order the transactions of a cluster for mining.
+ *
+ * The result is topologically valid (parents before children) and is built
+ * by repeatedly picking the not yet included transaction whose remaining
+ * ancestor set has the highest feerate, and including that set. It is then
+ * split into chunks: a transaction that pays more than the transactions
+ * before it is merged with them, so that the chunks' feerates decrease and
+ * every prefix of whole chunks is a good block candidate.
+ *
+ * @param[in] fees     (Modified) fee of every transaction.
+ * @param[in] sizes    Virtual size of every transaction.
+ * @param[in] parents  Indices of the direct parents of every transaction,
+ *                     which must form an acyclic graph.
+ */
+Linearization Linearize(Span<const CAmount> fees, Span<const int64_t> sizes, const std::vector<std::vector<uint32_t>>& parents);
+
+/** Split a topologically valid order into chunks of decreasing feerate. */
+std::vector<Chunk> ChunkLinearization(Span<const uint32_t> order, Span<const CAmount> fees, Span<const int64_t> sizes);
+
+} // namespace cluster_linearize
+
+#endif // KOYOTECOIN_CLUSTER_LINEARIZE_H
@@ -110,6 +110,11 @@ typedef char* sockopt_arg_type;
 #define USE_POLL
 #endif
 
+// Wait on long-lived sets of sockets through epoll(7) where it is available.
+#if defined(__linux__)
+#define USE_EPOLL
+#endif
+
 bool static inline IsSelectableSocket(const SOCKET& s) {
 #if defined(USE_POLL) || defined(WIN32)
     return true;
@@ -111,12 +111,61 @@ static void SetMaxOpenFiles(leveldb::Options *options) {
              options->max_open_files, default_open_files);
 }
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+//! Databases -dbprofile can select a profile for
+static const std::vector<std::string> DB_PROFILE_DATABASES{"chainstate", "blockindex", "txindex", "blockfilterindex", "coinstatsindex"};
+
+std::optional<DBProfile> GetDBProfileByName(const std::string& name)
+{
+    if (name == "default") return DBProfile{};
+    if (name == "lookup") {
+        return DBProfile{.block_size = 2 << 10, .bloom_bits = 16, .write_buffer_percent = 25, .max_file_size = 2 << 20};
+    }
+    if (name == "bulk") {
+        return DBProfile{.block_size = 16 << 10, .bloom_bits = 10, .write_buffer_percent = 30, .max_file_size = 8 << 20};
+    }
+    return std::nullopt;
+}
+
+/** Split a -dbprofile value into the database and profile names. */
+static std::optional<std::pair<std::string, DBProfile>> ParseDBProfileArg(const std::string& value)
+{
+    const auto sep{value.find(':')};
+    if (sep == std::string::npos) return std::nullopt;
+    const std::string db_name{value.substr(0, sep)};
+    if (std::find(DB_PROFILE_DATABASES.begin(), DB_PROFILE_DATABASES.end(), db_name) == DB_PROFILE_DATABASES.end()) return std::nullopt;
+    const auto profile{GetDBProfileByName(value.substr(sep + 1))};
+    if (!profile) return std::nullopt;
+    return std::make_pair(db_name, *profile);
+}
+
+DBProfile GetDBProfile(const ArgsManager& args, const std::string& db_name)
+{
+    DBProfile profile;
+    // The last one given wins, like for other options.
+    for (const std::string& value : args.GetArgs("-dbprofile")) {
+        const auto parsed{ParseDBProfileArg(value)};
+        if (parsed && parsed->first == db_name) profile = parsed->second;
+    }
+    return profile;
+}
+
+std::optional<std::string> CheckDBProfileArgs(const ArgsManager& args)
+{
+    for (const std::string& value : args.GetArgs("-dbprofile")) {
+        if (!ParseDBProfileArg(value)) return value;
+    }
+    return std::nullopt;
+}
+
+static leveldb::Options GetOptions(size_t nCacheSize, const DBProfile& profile)
 {
     leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
+    // up to two write buffers may be held in memory simultaneously
+    options.write_buffer_size = nCacheSize * profile.write_buffer_percent / 100;
+    options.block_cache = leveldb::NewLRUCache(nCacheSize - 2 * options.write_buffer_size);
+    options.block_size = profile.block_size;
+    options.max_file_size = profile.max_file_size;
+    options.filter_policy = leveldb::NewBloomFilterPolicy(profile.bloom_bits);
     options.compression = leveldb::kNoCompression;
     options.info_log = new CKoyotecoinLevelDBLogger();
     if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
@@ -128,7 +177,7 @@ static leveldb::Options GetOptions(size_t nCacheSize)
     return options;
 }
 
-CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate)
+CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate, const DBProfile& profile)
     : m_name{fs::PathToString(path.stem())}
 {
     penv = nullptr;
@@ -136,7 +185,9 @@ CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bo
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    options = GetOptions(nCacheSize, profile);
+    LogPrint(BCLog::LEVELDB, "LevelDB in %s using block_size=%u bloom_bits=%d write_buffer_size=%u max_file_size=%u\n",
+             fs::PathToString(path), options.block_size, profile.bloom_bits, options.write_buffer_size, options.max_file_size);
     options.create_if_missing = true;
     if (fMemory) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
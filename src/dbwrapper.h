@@ -22,6 +22,7 @@
 #include <leveldb/slice.h>
 #include <leveldb/status.h>
 #include <leveldb/write_batch.h>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -29,9 +30,51 @@ namespace leveldb {
 class Env;
 }
 
+class ArgsManager;
+
 static const size_t DBWRAPPER_PREALLOC_KEY_SIZE = 64;
 static const size_t DBWRAPPER_PREALLOC_VALUE_SIZE = 1024;
 
+/**
+ * LevelDB settings for the access pattern of a database. Changing them
+ * doesn't change the format of the data; tables written with other settings
+ * stay readable.
+ */
+struct DBProfile {
+    //! Approximate size of the user data packed into a table block
+    size_t block_size{4 << 10};
+    //! Bits per key of the bloom filters, which spare the disk reads for most
+    //! keys that are not in a table
+    int bloom_bits{10};
+    //! Share of the cache, in percent, used by each of the up to two write
+    //! buffers; the block cache gets the rest
+    int write_buffer_percent{25};
+    //! Size of the table files
+    size_t max_file_size{2 << 20};
+};
+
+/**
+ * Get a profile by name:
+ * - "default": the settings used for all databases before there were profiles.
+ * - "lookup": for point lookups of random or often missing keys, like the
+ *   chainstate or txindex get: smaller blocks and larger bloom filters, so
+ *   that less is read per lookup and fewer lookups of missing keys hit disk.
+ * - "bulk": for large sequential writes and range reads, like filter and
+ *   block index databases get: larger blocks, write buffers and files, so
+ *   that there is less compaction work per byte written.
+ */
+std::optional<DBProfile> GetDBProfileByName(const std::string& name);
+
+/**
+ * Get the profile selected with -dbprofile=<db>:<profile> for a database
+ * ("chainstate", "blockindex", "txindex", "blockfilterindex" or
+ * "coinstatsindex"), or the default profile.
+ */
+DBProfile GetDBProfile(const ArgsManager& args, const std::string& db_name);
+
+/** Return the first -dbprofile value that doesn't name a known database and profile, if any. */
+std::optional<std::string> CheckDBProfileArgs(const ArgsManager& args);
+
 class dbwrapper_error : public std::runtime_error
 {
 public:
@@ -228,8 +271,9 @@ public:
      * @param[in] fWipe       If true, remove all existing data.
      * @param[in] obfuscate   If true, store data obfuscated via simple XOR. If false, XOR
      *                        with a zero'd byte array.
+     * @param[in] profile     LevelDB settings for the access pattern of the database.
      */
-    CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false);
+    CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false, const DBProfile& profile = {});
     ~CDBWrapper();
 
     CDBWrapper(const CDBWrapper&) = delete;
@@ -7,10 +7,12 @@
 #ifndef KOYOTECOIN_FLATFILE_H
 #define KOYOTECOIN_FLATFILE_H
 
+#include <memory>
 #include <string>
 
 #include <fs.h>
 #include <serialize.h>
+#include <span.h>
 
 struct FlatFilePos
 {
@@ -40,6 +42,34 @@ struct FlatFilePos
     std::string ToString() const;
 };
 
+/**
+ * A read-only memory mapping of a whole file.
+ *
+ * The mapping reflects later writes to the file, but not its growth. The
+ * file must not be truncated while the mapping is in use.
+ */
+class MappedFile
+{
+private:
+    const unsigned char* const m_data;
+    const size_t m_size;
+
+    MappedFile(const unsigned char* data, size_t size) : m_data(data), m_size(size) {}
+
+public:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    /**
+     * Map the file at the given path. Returns nullptr if the file is empty or
+     * cannot be mapped, or memory mapping is not supported on this platform.
+     */
+    static std::unique_ptr<MappedFile> Open(const fs::path& path);
+
+    Span<const unsigned char> Data() const { return {m_data, m_size}; }
+};
+
 /**
  * FlatFileSeq represents a sequence of numbered files storing raw data. This class facilitates
  * access to and efficient management of these files.
@@ -67,6 +97,9 @@ public:
     /** Open a handle to the file at the given position. */
     FILE* Open(const FlatFilePos& pos, bool read_only = false);
 
+    /** Map the whole file containing the given position into memory, read-only. */
+    std::unique_ptr<MappedFile> Map(const FlatFilePos& pos) const;
+
     /**
      * Allocate additional space in a file after the given starting position. The amount allocated
      * will be the minimum multiple of the sequence chunk size greater than add_size.
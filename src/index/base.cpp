@@ -11,7 +11,9 @@
 #include <node/context.h>
 #include <node/interface_ui.h>
 #include <shutdown.h>
+#include <sync.h>
 #include <tinyformat.h>
+#include <undo.h>
 #include <util/syscall_sandbox.h>
 #include <util/system.h>
 #include <util/thread.h>
@@ -19,15 +21,25 @@
 #include <validation.h> // For g_chainman
 #include <warnings.h>
 
+#include <algorithm>
+#include <any>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <optional>
 #include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
-using node::ReadBlockFromDisk;
 
 constexpr uint8_t DB_BEST_BLOCK{'B'};
 
 constexpr auto SYNC_LOG_INTERVAL{30s};
 constexpr auto SYNC_LOCATOR_WRITE_INTERVAL{30s};
+//! Indexes syncing further apart than this many blocks don't share block reads
+constexpr int SYNC_SHARED_READ_RANGE{1000};
 
 template <typename... Args>
 static void FatalError(const char* fmt, const Args&... args)
@@ -48,8 +60,8 @@ CBlockLocator GetLocator(interfaces::Chain& chain, const uint256& block_hash)
     return locator;
 }
 
-BaseIndex::DB::DB(const fs::path& path, size_t n_cache_size, bool f_memory, bool f_wipe, bool f_obfuscate) :
-    CDBWrapper(path, n_cache_size, f_memory, f_wipe, f_obfuscate)
+BaseIndex::DB::DB(const fs::path& path, size_t n_cache_size, bool f_memory, bool f_wipe, bool f_obfuscate, const DBProfile& profile) :
+    CDBWrapper(path, n_cache_size, f_memory, f_wipe, f_obfuscate, profile)
 {}
 
 bool BaseIndex::DB::ReadBestBlock(CBlockLocator& locator) const
@@ -147,15 +159,168 @@ static const CBlockIndex* NextSyncBlock(const CBlockIndex* pindex_prev, CChain&
     return chain.Next(chain.FindFork(pindex_prev));
 }
 
+namespace {
+/**
+ * Blocks and undo data read by the sync of one index, kept for the other
+ * indexes that sync right behind it, so that indexes which are synced at the
+ * same time read and deserialize every block only once. To keep them
+ * together, an index that gets more than a batch ahead of another syncing
+ * index within SYNC_SHARED_READ_RANGE blocks waits for it.
+ */
+class SharedBlockReader
+{
+    struct Entry {
+        int height;
+        std::shared_ptr<const CBlock> block;
+        std::shared_ptr<const CBlockUndo> undo;
+    };
+
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    //! Height of the next block each syncing index appends
+    std::map<const BaseIndex*, int> m_next_heights GUARDED_BY(m_mutex);
+    std::map<uint256, Entry> m_entries GUARDED_BY(m_mutex);
+    //! Blocks and undo data read from disk, rather than taken from m_entries
+    std::atomic<uint64_t> m_block_reads{0};
+    std::atomic<uint64_t> m_undo_reads{0};
+
+    //! Drop the entries no syncing index is going to need anymore.
+    void Prune() EXCLUSIVE_LOCKS_REQUIRED(m_mutex)
+    {
+        AssertLockHeld(m_mutex);
+        std::optional<int> min_height;
+        for (const auto& [index, height] : m_next_heights) {
+            if (!min_height || height < *min_height) min_height = height;
+        }
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            if (!min_height || it->second.height < *min_height) {
+                it = m_entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    //! Whether another syncing index is going to need the block at this height.
+    bool IsNeededByOthers(const BaseIndex& index, int height) const EXCLUSIVE_LOCKS_REQUIRED(m_mutex)
+    {
+        AssertLockHeld(m_mutex);
+        for (const auto& [other, next_height] : m_next_heights) {
+            if (other != &index && next_height <= height && height - next_height <= SYNC_SHARED_READ_RANGE) return true;
+        }
+        return false;
+    }
+
+public:
+    void SetNextHeight(const BaseIndex& index, int next_height) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        {
+            LOCK(m_mutex);
+            m_next_heights[&index] = next_height;
+            Prune();
+        }
+        m_cv.notify_all();
+    }
+
+    void Remove(const BaseIndex& index) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        {
+            LOCK(m_mutex);
+            m_next_heights.erase(&index);
+            Prune();
+        }
+        m_cv.notify_all();
+    }
+
+    /** Wait until no other syncing index is more than max_lead blocks behind this one, within the shared range. */
+    void WaitForOthers(const BaseIndex& index, int next_height, int max_lead, const CThreadInterrupt& interrupt) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        WAIT_LOCK(m_mutex, lock);
+        while (!interrupt) {
+            const bool others_behind{std::any_of(m_next_heights.begin(), m_next_heights.end(), [&](const auto& other) {
+                const int lead{next_height - other.second};
+                return other.first != &index && lead > max_lead && lead <= SYNC_SHARED_READ_RANGE;
+            })};
+            if (!others_behind) break;
+            // Also wake up now and then to notice an interrupt.
+            m_cv.wait_for(lock, 100ms);
+        }
+    }
+
+    /**
+     * Get a block, and its undo data if requested, from the blocks kept for
+     * this index or from disk. Returns a null block if it cannot be read; a
+     * null undo means that the index has to try reading it itself.
+     */
+    Entry Read(const BaseIndex& index, node::BlockManager& blockman, const CBlockIndex& block_index, bool with_undo, const Consensus::Params& consensus_params) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        with_undo = with_undo && block_index.nHeight > 0;
+        const uint256 hash{block_index.GetBlockHash()};
+        Entry entry{block_index.nHeight, nullptr, nullptr};
+        {
+            LOCK(m_mutex);
+            const auto it{m_entries.find(hash)};
+            if (it != m_entries.end()) entry = it->second;
+        }
+        const bool was_cached{entry.block && (entry.undo || !with_undo)};
+        if (!entry.block) {
+            auto block{std::make_shared<CBlock>()};
+            ++m_block_reads;
+            if (!blockman.ReadBlockFromDisk(*block, &block_index, consensus_params)) return entry;
+            entry.block = std::move(block);
+        }
+        if (with_undo && !entry.undo) {
+            auto undo{std::make_shared<CBlockUndo>()};
+            ++m_undo_reads;
+            if (blockman.UndoReadFromDisk(*undo, &block_index)) entry.undo = std::move(undo);
+        }
+        if (!was_cached) {
+            LOCK(m_mutex);
+            if (IsNeededByOthers(index, entry.height)) {
+                Entry& cached{m_entries[hash]};
+                cached.height = entry.height;
+                if (!cached.block) cached.block = entry.block;
+                if (!cached.undo) cached.undo = entry.undo;
+            }
+        }
+        return entry;
+    }
+
+    IndexSyncReads GetReads() const
+    {
+        return {m_block_reads.load(), m_undo_reads.load()};
+    }
+};
+
+SharedBlockReader g_shared_block_reader;
+} // namespace
+
+IndexSyncReads GetIndexSyncReads()
+{
+    return g_shared_block_reader.GetReads();
+}
+
 void BaseIndex::ThreadSync()
 {
     SetSyscallSandboxPolicy(SyscallSandboxPolicy::TX_INDEX);
     const CBlockIndex* pindex = m_best_block_index.load();
     if (!m_synced) {
         auto& consensus_params = Params().GetConsensus();
+        const size_t num_threads{size_t(std::max(GetNumCores(), 1))};
+        const bool parallel{AllowParallelSync()};
+        const bool with_undo{RequiresUndoData()};
+        const size_t batch_size{SYNC_BATCH_BLOCKS_PER_THREAD * num_threads};
+        // Let the sync of other indexes share this one's block reads, and
+        // the other way round.
+        g_shared_block_reader.SetNextHeight(*this, pindex ? pindex->nHeight + 1 : 0);
+        struct ReaderRemover {
+            const BaseIndex& index;
+            ~ReaderRemover() { g_shared_block_reader.Remove(index); }
+        } reader_remover{*this};
 
         std::chrono::steady_clock::time_point last_log_time{0s};
         std::chrono::steady_clock::time_point last_locator_write_time{0s};
+        std::vector<const CBlockIndex*> batch;
         while (true) {
             if (m_interrupt) {
                 SetBestBlockIndex(pindex);
@@ -166,6 +331,9 @@ void BaseIndex::ThreadSync()
                 return;
             }
 
+            g_shared_block_reader.WaitForOthers(*this, pindex ? pindex->nHeight + 1 : 0, batch_size, m_interrupt);
+            if (m_interrupt) continue;
+
             {
                 LOCK(cs_main);
                 const CBlockIndex* pindex_next = NextSyncBlock(pindex, m_chainstate->m_chain);
@@ -181,37 +349,74 @@ void BaseIndex::ThreadSync()
                                __func__, GetName());
                     return;
                 }
-                pindex = pindex_next;
+                batch.assign(1, pindex_next);
+                while (batch.size() < batch_size) {
+                    const CBlockIndex* next{m_chainstate->m_chain.Next(batch.back())};
+                    if (!next) break;
+                    batch.push_back(next);
+                }
             }
 
-            auto current_time{std::chrono::steady_clock::now()};
-            if (last_log_time + SYNC_LOG_INTERVAL < current_time) {
-                LogPrintf("Syncing %s with block chain from height %d\n",
-                          GetName(), pindex->nHeight);
-                last_log_time = current_time;
+            // Read (and process) the blocks of the batch on one thread per
+            // core. Errors are reported below, in block order.
+            std::vector<std::shared_ptr<const CBlock>> blocks(batch.size());
+            std::vector<std::shared_ptr<const CBlockUndo>> undos(batch.size());
+            std::vector<interfaces::BlockInfo> block_infos;
+            block_infos.reserve(batch.size());
+            for (const CBlockIndex* block_index : batch) {
+                block_infos.push_back(kernel::MakeBlockInfo(block_index));
             }
-
-            if (last_locator_write_time + SYNC_LOCATOR_WRITE_INTERVAL < current_time) {
-                SetBestBlockIndex(pindex->pprev);
-                last_locator_write_time = current_time;
-                // No need to handle errors in Commit. See rationale above.
-                Commit();
+            std::vector<std::any> entries(batch.size());
+            std::atomic<size_t> next{0};
+            const auto work{[&] {
+                for (size_t i; (i = next++) < batch.size();) {
+                    auto read{g_shared_block_reader.Read(*this, m_chainstate->m_blockman, *batch[i], with_undo, consensus_params)};
+                    if (!read.block) continue;
+                    blocks[i] = std::move(read.block);
+                    undos[i] = std::move(read.undo);
+                    block_infos[i].data = blocks[i].get();
+                    block_infos[i].undo_data = undos[i].get();
+                    if (parallel) entries[i] = CustomProcessBlock(block_infos[i]);
+                }
+            }};
+            std::vector<std::thread> threads;
+            for (size_t i = 1; i < std::min(num_threads, batch.size()); ++i) {
+                threads.emplace_back(work);
             }
-
-            CBlock block;
-            interfaces::BlockInfo block_info = kernel::MakeBlockInfo(pindex);
-            if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
-                FatalError("%s: Failed to read block %s from disk",
-                           __func__, pindex->GetBlockHash().ToString());
-                return;
-            } else {
-                block_info.data = &block;
+            work();
+            for (std::thread& thread : threads) {
+                thread.join();
             }
-            if (!CustomAppend(block_info)) {
-                FatalError("%s: Failed to write block %s to index database",
-                           __func__, pindex->GetBlockHash().ToString());
-                return;
+
+            for (size_t i = 0; i < batch.size(); ++i) {
+                pindex = batch[i];
+
+                auto current_time{std::chrono::steady_clock::now()};
+                if (last_log_time + SYNC_LOG_INTERVAL < current_time) {
+                    LogPrintf("Syncing %s with block chain from height %d\n",
+                              GetName(), pindex->nHeight);
+                    last_log_time = current_time;
+                }
+
+                if (last_locator_write_time + SYNC_LOCATOR_WRITE_INTERVAL < current_time) {
+                    SetBestBlockIndex(pindex->pprev);
+                    last_locator_write_time = current_time;
+                    // No need to handle errors in Commit. See rationale above.
+                    Commit();
+                }
+
+                if (!block_infos[i].data) {
+                    FatalError("%s: Failed to read block %s from disk",
+                               __func__, pindex->GetBlockHash().ToString());
+                    return;
+                }
+                if (!(parallel ? CustomWriteBlock(block_infos[i], entries[i]) : CustomAppend(block_infos[i]))) {
+                    FatalError("%s: Failed to write block %s to index database",
+                               __func__, pindex->GetBlockHash().ToString());
+                    return;
+                }
             }
+            g_shared_block_reader.SetNextHeight(*this, pindex->nHeight + 1);
         }
     }
 
@@ -11,6 +11,8 @@
 #include <threadinterrupt.h>
 #include <validationinterface.h>
 
+#include <any>
+#include <cstdint>
 #include <string>
 
 class CBlock;
@@ -20,12 +22,24 @@ namespace interfaces {
 class Chain;
 } // namespace interfaces
 
+//! Blocks read ahead during the sync for every core
+static constexpr size_t SYNC_BATCH_BLOCKS_PER_THREAD{4};
+
 struct IndexSummary {
     std::string name;
     bool synced{false};
     int best_block_height{0};
 };
 
+//! Blocks and undo data read from disk by the syncs of all indexes
+struct IndexSyncReads {
+    uint64_t blocks{0};
+    uint64_t undos{0};
+};
+
+/** Get the number of reads from disk of all index syncs so far, for tests. */
+IndexSyncReads GetIndexSyncReads();
+
 /**
  * Base class for indices of blockchain data. This implements
  * CValidationInterface and ensures blocks are indexed sequentially according
@@ -45,7 +59,8 @@ protected:
     {
     public:
         DB(const fs::path& path, size_t n_cache_size,
-           bool f_memory = false, bool f_wipe = false, bool f_obfuscate = false);
+           bool f_memory = false, bool f_wipe = false, bool f_obfuscate = false,
+           const DBProfile& profile = {});
 
         /// Read block locator of the chain that the index is in sync with.
         bool ReadBestBlock(CBlockLocator& locator) const;
@@ -78,6 +93,11 @@ private:
     /// interrupted with m_interrupt. Once the index gets in sync, the m_synced
     /// flag is set and the BlockConnected ValidationInterface callback takes
     /// over and the sync thread exits.
+    ///
+    /// Blocks are synced in batches: the blocks of a batch are read from disk
+    /// (and processed, if AllowParallelSync()) on one thread per core, then
+    /// appended to the index one after the other on the sync thread. Indexes
+    /// syncing at the same time share the blocks they read.
     void ThreadSync();
 
     /// Write the current index state (eg. chain block locator and subclass-specific items) to disk.
@@ -110,6 +130,28 @@ protected:
     /// Write update index entries for a newly connected block.
     [[nodiscard]] virtual bool CustomAppend(const interfaces::BlockInfo& block) { return true; }
 
+    /// Whether the index needs the undo data of the blocks it appends. The
+    /// sync then reads it along with the block, once for all indexes, and
+    /// passes it in interfaces::BlockInfo::undo_data. Otherwise, and when
+    /// that is null, the index has to read it itself.
+    virtual bool RequiresUndoData() const { return false; }
+
+    /// Whether the index entries of a block can be computed independently of
+    /// other blocks and of the index state, by CustomProcessBlock(). The sync
+    /// then computes them for several blocks at once on worker threads and
+    /// only writes them in order, with CustomWriteBlock(), instead of calling
+    /// CustomAppend().
+    virtual bool AllowParallelSync() const { return false; }
+
+    /// Compute the index entries of a block without writing them. May be
+    /// called concurrently for different blocks. An empty result means that
+    /// this failed.
+    virtual std::any CustomProcessBlock(const interfaces::BlockInfo& block) const { return {}; }
+
+    /// Write the index entries CustomProcessBlock() computed for a block. It
+    /// is called in block order, like CustomAppend().
+    [[nodiscard]] virtual bool CustomWriteBlock(const interfaces::BlockInfo& block, const std::any& entries) { return true; }
+
     /// Virtual method called internally by Commit that can be overridden to atomically
     /// commit more index state.
     virtual bool CustomCommit(CDBBatch& batch) { return true; }
@@ -12,7 +12,6 @@
 #include <util/system.h>
 #include <validation.h>
 
-using node::UndoReadFromDisk;
 
 /* The index database stores three items for each block: the disk location of the encoded filter,
  * its dSHA256 hash, and the header. Those belonging to blocks on the active chain are indexed by
@@ -107,7 +106,8 @@ BlockFilterIndex::BlockFilterIndex(std::unique_ptr<interfaces::Chain> chain, Blo
     fs::path path = gArgs.GetDataDirNet() / "indexes" / "blockfilter" / fs::u8path(filter_name);
     fs::create_directories(path);
 
-    m_db = std::make_unique<BaseIndex::DB>(path / "db", n_cache_size, f_memory, f_wipe);
+    m_db = std::make_unique<BaseIndex::DB>(path / "db", n_cache_size, f_memory, f_wipe,
+                                           /*f_obfuscate=*/false, GetDBProfile(gArgs, "blockfilterindex"));
     m_filter_fileseq = std::make_unique<FlatFileSeq>(std::move(path), "fltr", FLTR_FILE_CHUNK_SIZE);
 }
 
@@ -218,17 +218,31 @@ size_t BlockFilterIndex::WriteFilterToDisk(FlatFilePos& pos, const BlockFilter&
 
 bool BlockFilterIndex::CustomAppend(const interfaces::BlockInfo& block)
 {
-    CBlockUndo block_undo;
-    uint256 prev_header;
+    return CustomWriteBlock(block, CustomProcessBlock(block));
+}
 
-    if (block.height > 0) {
+std::any BlockFilterIndex::CustomProcessBlock(const interfaces::BlockInfo& block) const
+{
+    CBlockUndo block_undo;
+    if (block.height > 0 && !block.undo_data) {
         // pindex variable gives indexing code access to node internals. It
         // will be removed in upcoming commit
         const CBlockIndex* pindex = WITH_LOCK(cs_main, return m_chainstate->m_blockman.LookupBlockIndex(block.hash));
-        if (!UndoReadFromDisk(block_undo, pindex)) {
-            return false;
+        if (!m_chainstate->m_blockman.UndoReadFromDisk(block_undo, pindex)) {
+            return {};
         }
+    }
+    return BlockFilter(m_filter_type, *Assert(block.data), block.undo_data ? *block.undo_data : block_undo);
+}
 
+bool BlockFilterIndex::CustomWriteBlock(const interfaces::BlockInfo& block, const std::any& entries)
+{
+    const BlockFilter* filter_ptr{std::any_cast<BlockFilter>(&entries)};
+    if (!filter_ptr) return false;
+    const BlockFilter& filter{*filter_ptr};
+    uint256 prev_header;
+
+    if (block.height > 0) {
         std::pair<uint256, DBVal> read_out;
         if (!m_db->Read(DBHeightKey(block.height - 1), read_out)) {
             return false;
@@ -243,8 +257,6 @@ bool BlockFilterIndex::CustomAppend(const interfaces::BlockInfo& block)
         prev_header = read_out.second.header;
     }
 
-    BlockFilter filter(m_filter_type, *Assert(block.data), block_undo);
-
     size_t bytes_written = WriteFilterToDisk(m_next_filter_pos, filter);
     if (bytes_written == 0) return false;
 
@@ -48,6 +48,16 @@ protected:
 
     bool CustomAppend(const interfaces::BlockInfo& block) override;
 
+    bool RequiresUndoData() const override { return true; }
+
+    bool AllowParallelSync() const override { return true; }
+
+    /** Read the block's undo data and build its filter. */
+    std::any CustomProcessBlock(const interfaces::BlockInfo& block) const override;
+
+    /** Chain the filter's header to the previous one and write both. */
+    bool CustomWriteBlock(const interfaces::BlockInfo& block, const std::any& entries) override;
+
     bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override;
 
     BaseIndex::DB& GetDB() const LIFETIMEBOUND override { return *m_db; }
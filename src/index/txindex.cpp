@@ -32,7 +32,8 @@ public:
 };
 
 TxIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
-    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txindex", n_cache_size, f_memory, f_wipe)
+    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txindex", n_cache_size, f_memory, f_wipe,
+                  /*f_obfuscate=*/false, GetDBProfile(gArgs, "txindex"))
 {}
 
 bool TxIndex::DB::ReadTxPos(const uint256 &txid, CDiskTxPos& pos) const
@@ -57,9 +58,11 @@ TxIndex::~TxIndex() = default;
 
 bool TxIndex::CustomAppend(const interfaces::BlockInfo& block)
 {
-    // Exclude genesis block transaction because outputs are not spendable.
-    if (block.height == 0) return true;
+    return CustomWriteBlock(block, CustomProcessBlock(block));
+}
 
+std::any TxIndex::CustomProcessBlock(const interfaces::BlockInfo& block) const
+{
     assert(block.data);
     CDiskTxPos pos({block.file_number, block.data_pos}, GetSizeOfCompactSize(block.data->vtx.size()));
     std::vector<std::pair<uint256, CDiskTxPos>> vPos;
@@ -68,7 +71,16 @@ bool TxIndex::CustomAppend(const interfaces::BlockInfo& block)
         vPos.emplace_back(tx->GetHash(), pos);
         pos.nTxOffset += ::GetSerializeSize(*tx, CLIENT_VERSION);
     }
-    return m_db->WriteTxs(vPos);
+    return vPos;
+}
+
+bool TxIndex::CustomWriteBlock(const interfaces::BlockInfo& block, const std::any& entries)
+{
+    // Exclude genesis block transaction because outputs are not spendable.
+    if (block.height == 0) return true;
+
+    const auto* vPos{std::any_cast<std::vector<std::pair<uint256, CDiskTxPos>>>(&entries)};
+    return vPos && m_db->WriteTxs(*vPos);
 }
 
 BaseIndex::DB& TxIndex::GetDB() const { return *m_db; }
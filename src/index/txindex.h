@@ -26,6 +26,12 @@ private:
 protected:
     bool CustomAppend(const interfaces::BlockInfo& block) override;
 
+    bool AllowParallelSync() const override { return true; }
+
+    std::any CustomProcessBlock(const interfaces::BlockInfo& block) const override;
+
+    bool CustomWriteBlock(const interfaces::BlockInfo& block, const std::any& entries) override;
+
     BaseIndex::DB& GetDB() const override;
 
 public:
@@ -0,0 +1,126 @@
+// Copyright (c) 2023-2023 The Koyotecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <inputfetcher.h>
+
+#include <primitives/block.h>
+#include <tinyformat.h>
+#include <util/hasher.h>
+#include <util/threadnames.h>
+
+#include <stdexcept>
+#include <unordered_set>
+
+size_t InputFetcher::Work(const CCoinsView& db)
+{
+    size_t done{0};
+    for (size_t i{m_next.fetch_add(1, std::memory_order_relaxed)}; i < m_outpoints.size(); i = m_next.fetch_add(1, std::memory_order_relaxed)) {
+        Coin coin;
+        try {
+            if (db.GetCoin(m_outpoints[i], coin)) m_coins[i] = std::move(coin);
+        } catch (const std::runtime_error&) {
+            // Leave the input to the validation thread, whose view of the
+            // database knows how to report read errors.
+        }
+        ++done;
+    }
+    return done;
+}
+
+void InputFetcher::Loop()
+{
+    uint64_t generation{0};
+    while (true) {
+        const CCoinsView* db;
+        {
+            WAIT_LOCK(m_mutex, lock);
+            m_worker_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_request_stop || m_generation != generation; });
+            if (m_request_stop) return;
+            generation = m_generation;
+            // The block may have been completed before this thread woke up.
+            if (m_db == nullptr) continue;
+            db = m_db;
+            ++m_active;
+        }
+        const size_t done{Work(*db)};
+        {
+            LOCK(m_mutex);
+            m_todo -= done;
+            --m_active;
+            if (m_todo == 0 && m_active == 0) m_master_cv.notify_one();
+        }
+    }
+}
+
+void InputFetcher::StartWorkerThreads(const int threads_num)
+{
+    assert(m_worker_threads.empty());
+    for (int n = 0; n < threads_num; ++n) {
+        m_worker_threads.emplace_back([this, n]() {
+            util::ThreadRename(strprintf("inputfetch.%i", n));
+            Loop();
+        });
+    }
+}
+
+void InputFetcher::StopWorkerThreads()
+{
+    WITH_LOCK(m_mutex, m_request_stop = true);
+    m_worker_cv.notify_all();
+    for (std::thread& t : m_worker_threads) {
+        t.join();
+    }
+    m_worker_threads.clear();
+    WITH_LOCK(m_mutex, m_request_stop = false);
+}
+
+void InputFetcher::FetchInputs(CCoinsViewCache& cache, const CCoinsView& db, const CBlock& block)
+{
+    // Outputs created within the block are not in the database yet.
+    std::unordered_set<uint256, SaltedTxidHasher> txids;
+    txids.reserve(block.vtx.size());
+    for (const auto& tx : block.vtx) {
+        txids.insert(tx->GetHash());
+    }
+
+    std::vector<COutPoint> outpoints;
+    for (const auto& tx : block.vtx) {
+        if (tx->IsCoinBase()) continue;
+        for (const CTxIn& txin : tx->vin) {
+            if (txids.count(txin.prevout.hash)) continue;
+            if (cache.HaveCoinInCache(txin.prevout)) {
+                ++m_hits;
+                continue;
+            }
+            outpoints.push_back(txin.prevout);
+        }
+    }
+    m_misses += outpoints.size();
+    if (outpoints.empty()) return;
+
+    {
+        LOCK(m_mutex);
+        m_outpoints = std::move(outpoints);
+        m_coins.assign(m_outpoints.size(), std::nullopt);
+        m_next = 0;
+        m_todo = m_outpoints.size();
+        m_db = &db;
+        ++m_generation;
+    }
+    m_worker_cv.notify_all();
+
+    const size_t done{Work(db)};
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_todo -= done;
+        m_master_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_todo == 0 && m_active == 0; });
+        m_db = nullptr;
+    }
+
+    for (size_t i = 0; i < m_outpoints.size(); ++i) {
+        if (m_coins[i]) cache.EmplaceCoinFromBase(m_outpoints[i], std::move(*m_coins[i]));
+    }
+    m_outpoints.clear();
+    m_coins.clear();
+}
@@ -0,0 +1,116 @@
+// Copyright (c) 2023-2023 The Koyotecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KOYOTECOIN_INPUTFETCHER_H
+#define KOYOTECOIN_INPUTFETCHER_H
+
+#include <coins.h>
+#include <primitives/transaction.h>
+#include <sync.h>
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <vector>
+
+class CBlock;
+
+/**
+ * Reads the inputs of a block from the coins database on a pool of worker
+ * threads, so that they are in the UTXO cache before ConnectBlock() needs
+ * them.
+ *
+ * The validation thread (the master) collects the prevouts of the block
+ * that are neither in the cache nor created by the block itself, and then
+ * joins the workers in reading them from the database. Once all reads have
+ * completed, the master adds the coins that were found to the cache as
+ * clean entries. Only the master ever touches the cache, so it does not
+ * have to be thread-safe; the database view must be safe to read from
+ * several threads at once (as CCoinsViewDB is) and must not be written to
+ * while FetchInputs() runs.
+ */
+class InputFetcher
+{
+private:
+    //! Mutex to protect the inner state
+    Mutex m_mutex;
+
+    //! Worker threads block on this when out of work
+    std::condition_variable m_worker_cv;
+
+    //! Master thread blocks on this until all reads have completed
+    std::condition_variable m_master_cv;
+
+    //! Prevouts to read for the current block. Only modified by the master
+    //! while no worker is active.
+    std::vector<COutPoint> m_outpoints;
+
+    //! Coins read for m_outpoints, std::nullopt if not found.
+    std::vector<std::optional<Coin>> m_coins;
+
+    //! Index of the next element of m_outpoints to read.
+    std::atomic<size_t> m_next{0};
+
+    //! Database to read from, nullptr while there is no block in progress.
+    const CCoinsView* m_db GUARDED_BY(m_mutex){nullptr};
+
+    //! Incremented for every block so that workers notice new work.
+    uint64_t m_generation GUARDED_BY(m_mutex){0};
+
+    //! Number of reads that haven't completed yet.
+    size_t m_todo GUARDED_BY(m_mutex){0};
+
+    //! Number of workers currently reading for the block in progress.
+    int m_active GUARDED_BY(m_mutex){0};
+
+    std::vector<std::thread> m_worker_threads;
+    bool m_request_stop GUARDED_BY(m_mutex){false};
+
+    //! Inputs that were already in the cache.
+    std::atomic<uint64_t> m_hits{0};
+
+    //! Inputs that had to be read from the database.
+    std::atomic<uint64_t> m_misses{0};
+
+    /** Read prevouts until there are none left, returning how many were read. */
+    size_t Work(const CCoinsView& db);
+
+    /** Main loop of a worker thread. */
+    void Loop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+public:
+    InputFetcher() = default;
+    InputFetcher(const InputFetcher&) = delete;
+    InputFetcher& operator=(const InputFetcher&) = delete;
+
+    //! Create a pool of new worker threads.
+    void StartWorkerThreads(int threads_num) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    //! Stop all of the worker threads.
+    void StopWorkerThreads() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Warm cache with the inputs of block, reading the ones it does not hold
+     * from db in parallel. Inputs that are not found in db are left alone,
+     * so ConnectBlock() still sees (and reports) them as missing.
+     */
+    void FetchInputs(CCoinsViewCache& cache, const CCoinsView& db, const CBlock& block) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    //! Number of inputs that were already cached when their block was fetched.
+    uint64_t GetHits() const { return m_hits; }
+
+    //! Number of inputs that had to be read from the database.
+    uint64_t GetMisses() const { return m_misses; }
+
+    ~InputFetcher()
+    {
+        assert(m_worker_threads.empty());
+    }
+};
+
+#endif // KOYOTECOIN_INPUTFETCHER_H
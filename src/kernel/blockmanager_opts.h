@@ -0,0 +1,23 @@
+// Copyright (c) 2023-2023 The Koyotecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KOYOTECOIN_KERNEL_BLOCKMANAGER_OPTS_H
+#define KOYOTECOIN_KERNEL_BLOCKMANAGER_OPTS_H
+
+/** Default for -blocksmmap, if finished block and undo files are read through memory mappings */
+static constexpr bool DEFAULT_BLOCKSMMAP{false};
+
+namespace kernel {
+
+/**
+ * An options struct for `BlockManager`, more ergonomically referred to as
+ * `BlockManager::Options` due to the using-declaration in `BlockManager`.
+ */
+struct BlockManagerOpts {
+    bool use_mmap{DEFAULT_BLOCKSMMAP};
+};
+
+} // namespace kernel
+
+#endif // KOYOTECOIN_KERNEL_BLOCKMANAGER_OPTS_H
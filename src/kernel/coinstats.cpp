@@ -201,4 +201,34 @@ static void FinalizeHash(MuHash3072& muhash, CCoinsStats& stats)
 }
 static void FinalizeHash(std::nullptr_t, CCoinsStats& stats) {}
 
+CoinsStatsBuilder::CoinsStatsBuilder(int block_height, const uint256& block_hash)
+    : m_stats{block_height, block_hash}
+{
+    PrepareHash(m_hash_writer, m_stats);
+}
+
+bool CoinsStatsBuilder::Add(const COutPoint& outpoint, Coin coin)
+{
+    if (!m_outputs.empty() && outpoint.hash != m_txid) {
+        if (outpoint.hash < m_txid) return false;
+        ApplyStats(m_stats, m_txid, m_outputs);
+        ApplyHash(m_hash_writer, m_txid, m_outputs);
+        m_outputs.clear();
+    }
+    m_txid = outpoint.hash;
+    if (!m_outputs.emplace(outpoint.n, std::move(coin)).second) return false;
+    ++m_stats.coins_count;
+    return true;
+}
+
+CCoinsStats CoinsStatsBuilder::Finalize()
+{
+    if (!m_outputs.empty()) {
+        ApplyStats(m_stats, m_txid, m_outputs);
+        ApplyHash(m_hash_writer, m_txid, m_outputs);
+        m_outputs.clear();
+    }
+    FinalizeHash(m_hash_writer, m_stats);
+    return m_stats;
+}
 } // namespace kernel
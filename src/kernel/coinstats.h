@@ -6,16 +6,18 @@
 #ifndef KOYOTECOIN_KERNEL_COINSTATS_H
 #define KOYOTECOIN_KERNEL_COINSTATS_H
 
+#include <coins.h>
 #include <consensus/amount.h>
+#include <hash.h>
 #include <streams.h>
 #include <uint256.h>
 
 #include <cstdint>
 #include <functional>
+#include <map>
 #include <optional>
 
 class CCoinsView;
-class Coin;
 class COutPoint;
 class CScript;
 namespace node {
@@ -76,6 +78,33 @@ uint64_t GetBogoSize(const CScript& script_pub_key);
 CDataStream TxOutSer(const COutPoint& outpoint, const Coin& coin);
 
 std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsView* view, node::BlockManager& blockman, const std::function<void()>& interruption_point = {});
+
+/**
+ * Computes the same HASH_SERIALIZED statistics as ComputeUTXOStats() from
+ * coins that are passed one by one instead of read from a view, e.g. while
+ * they are loaded from a UTXO snapshot. The coins must come sorted by txid;
+ * the outputs of a transaction may come in any order.
+ */
+class CoinsStatsBuilder
+{
+    CCoinsStats m_stats;
+    HashWriter m_hash_writer{};
+    //! Transaction whose outputs are being collected
+    uint256 m_txid;
+    std::map<uint32_t, Coin> m_outputs;
+
+public:
+    CoinsStatsBuilder(int block_height, const uint256& block_hash);
+
+    /**
+     * Add the next coin.
+     * @returns false if the coin is out of order or was already added, after
+     *          which the statistics are meaningless.
+     */
+    [[nodiscard]] bool Add(const COutPoint& outpoint, Coin coin);
+
+    CCoinsStats Finalize();
+};
 } // namespace kernel
 
 #endif // KOYOTECOIN_KERNEL_COINSTATS_H
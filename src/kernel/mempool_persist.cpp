@@ -7,11 +7,16 @@
 
 #include <clientversion.h>
 #include <consensus/amount.h>
+#include <consensus/consensus.h>
+#include <consensus/validation.h>
 #include <fs.h>
+#include <hash.h>
 #include <logging.h>
+#include <policy/policy.h>
 #include <primitives/transaction.h>
 #include <serialize.h>
 #include <shutdown.h>
+#include <span.h>
 #include <streams.h>
 #include <sync.h>
 #include <txmempool.h>
@@ -20,6 +25,8 @@
 #include <util/time.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <cstdio>
@@ -29,6 +36,8 @@
 #include <memory>
 #include <set>
 #include <stdexcept>
+#include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -36,13 +45,85 @@ using fsbridge::FopenFn;
 
 namespace kernel {
 
-static const uint64_t MEMPOOL_DUMP_VERSION = 1;
+static const uint64_t MEMPOOL_DUMP_VERSION_UNCHUNKED{1};
+static const uint64_t MEMPOOL_DUMP_VERSION{2};
 
-bool LoadMempool(CTxMemPool& pool, const fs::path& load_path, Chainstate& active_chainstate, FopenFn mockable_fopen_function)
+//! Maximum number of transactions in a chunk of a dump
+static constexpr uint32_t MEMPOOL_DUMP_CHUNK_TXS{500};
+//! A chunk of a dump is closed once its transactions take up this many bytes
+static constexpr size_t MEMPOOL_DUMP_CHUNK_BYTES{4 << 20};
+//! Upper bound for the size of a chunk. A chunk is closed early rather than
+//! let a transaction take it past this, and a chunk of any single transaction
+//! that fits into a block stays below it.
+static constexpr size_t MEMPOOL_DUMP_MAX_CHUNK_BYTES{MEMPOOL_DUMP_CHUNK_BYTES + MAX_STANDARD_TX_WEIGHT + 2 * sizeof(int64_t)};
+static_assert(MAX_BLOCK_SERIALIZED_SIZE + 2 * sizeof(int64_t) <= MEMPOOL_DUMP_MAX_CHUNK_BYTES);
+
+namespace {
+/** A transaction as it is persisted, with the time it entered the mempool and its fee delta. */
+struct PersistedTx {
+    CTransactionRef tx;
+    int64_t time;
+    int64_t fee_delta;
+};
+
+/** Header of a chunk of a version 2 dump, which is followed by the chunk's serialized transactions. */
+struct ChunkHeader {
+    uint32_t tx_count;
+    uint32_t size;
+    //! Hash of the serialized transactions
+    uint256 checksum;
+
+    SERIALIZE_METHODS(ChunkHeader, obj) { READWRITE(obj.tx_count, obj.size, obj.checksum); }
+};
+
+struct Chunk {
+    ChunkHeader header;
+    std::vector<unsigned char> data;
+    std::vector<PersistedTx> txs;
+    //! Why the chunk could not be used, if it couldn't
+    std::string error;
+};
+
+/** Verify and deserialize chunks, spreading them over one thread per core. */
+void DeserializeChunks(std::vector<Chunk>& chunks)
+{
+    std::atomic<size_t> next{0};
+    const auto work{[&] {
+        for (size_t i; (i = next++) < chunks.size();) {
+            Chunk& chunk{chunks[i]};
+            if (Hash(chunk.data) != chunk.header.checksum) {
+                chunk.error = "checksum mismatch";
+                continue;
+            }
+            try {
+                SpanReader stream{SER_DISK, CLIENT_VERSION, chunk.data};
+                chunk.txs.resize(chunk.header.tx_count);
+                for (PersistedTx& ptx : chunk.txs) {
+                    stream >> ptx.tx >> ptx.time >> ptx.fee_delta;
+                }
+                if (!stream.empty()) chunk.error = "trailing data";
+            } catch (const std::exception& e) {
+                chunk.error = e.what();
+            }
+        }
+    }};
+    const size_t num_threads{std::min<size_t>(std::max(GetNumCores(), 1), chunks.size())};
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; ++i) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+} // namespace
+
+bool LoadMempool(CTxMemPool& pool, const fs::path& load_path, Chainstate& active_chainstate, ImportMempoolOptions&& opts)
 {
     if (load_path.empty()) return false;
 
-    FILE* filestr{mockable_fopen_function(load_path, "rb")};
+    FILE* filestr{opts.mockable_fopen_function(load_path, "rb")};
     CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
     if (file.IsNull()) {
         LogPrintf("Failed to open mempool file from disk. Continuing anyway.\n");
@@ -54,50 +135,95 @@ bool LoadMempool(CTxMemPool& pool, const fs::path& load_path, Chainstate& active
     int64_t failed = 0;
     int64_t already_there = 0;
     int64_t unbroadcast = 0;
+    int64_t scripts_skipped = 0;
     auto now = NodeClock::now();
 
+    const auto accept{[&](const PersistedTx& ptx, bool skip_script_checks) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
+        const CTransactionRef& tx{ptx.tx};
+        CAmount amountdelta = ptx.fee_delta;
+        if (amountdelta) {
+            pool.PrioritiseTransaction(tx->GetHash(), amountdelta);
+        }
+        if (ptx.time > TicksSinceEpoch<std::chrono::seconds>(now - pool.m_expiry)) {
+            const auto& accepted = AcceptToMemoryPool(active_chainstate, tx, ptx.time, /*bypass_limits=*/false, /*test_accept=*/false, skip_script_checks);
+            if (accepted.m_result_type == MempoolAcceptResult::ResultType::VALID) {
+                ++count;
+                if (skip_script_checks) ++scripts_skipped;
+            } else {
+                // mempool may contain the transaction already, e.g. from
+                // wallet(s) having loaded it while we were processing
+                // mempool transactions; consider these as valid, instead of
+                // failed, but mark them as 'already there'
+                if (pool.exists(GenTxid::Txid(tx->GetHash()))) {
+                    ++already_there;
+                } else {
+                    ++failed;
+                }
+            }
+        } else {
+            ++expired;
+        }
+    }};
+
     try {
         uint64_t version;
         file >> version;
-        if (version != MEMPOOL_DUMP_VERSION) {
-            return false;
-        }
-        uint64_t num;
-        file >> num;
-        while (num) {
-            --num;
-            CTransactionRef tx;
-            int64_t nTime;
-            int64_t nFeeDelta;
-            file >> tx;
-            file >> nTime;
-            file >> nFeeDelta;
-
-            CAmount amountdelta = nFeeDelta;
-            if (amountdelta) {
-                pool.PrioritiseTransaction(tx->GetHash(), amountdelta);
+        if (version == MEMPOOL_DUMP_VERSION_UNCHUNKED) {
+            uint64_t num;
+            file >> num;
+            while (num) {
+                --num;
+                PersistedTx ptx;
+                file >> ptx.tx >> ptx.time >> ptx.fee_delta;
+                WITH_LOCK(cs_main, accept(ptx, /*skip_script_checks=*/false));
+                if (ShutdownRequested())
+                    return false;
             }
-            if (nTime > TicksSinceEpoch<std::chrono::seconds>(now - pool.m_expiry)) {
-                LOCK(cs_main);
-                const auto& accepted = AcceptToMemoryPool(active_chainstate, tx, nTime, /*bypass_limits=*/false, /*test_accept=*/false);
-                if (accepted.m_result_type == MempoolAcceptResult::ResultType::VALID) {
-                    ++count;
-                } else {
-                    // mempool may contain the transaction already, e.g. from
-                    // wallet(s) having loaded it while we were processing
-                    // mempool transactions; consider these as valid, instead of
-                    // failed, but mark them as 'already there'
-                    if (pool.exists(GenTxid::Txid(tx->GetHash()))) {
-                        ++already_there;
-                    } else {
-                        ++failed;
+        } else if (version == MEMPOOL_DUMP_VERSION) {
+            uint256 tip_hash;
+            uint32_t script_flags;
+            uint64_t num;
+            file >> tip_hash >> script_flags >> num;
+            // Scripts that were verified with the same flags on top of the
+            // same tip need not be verified again.
+            const bool skip_script_checks{opts.skip_script_checks && script_flags == STANDARD_SCRIPT_VERIFY_FLAGS};
+            // Read a few chunks per core at a time, so that all of them can
+            // be deserialized in parallel while memory use stays bounded.
+            const size_t window{4 * size_t(std::max(GetNumCores(), 1))};
+            while (num) {
+                std::vector<Chunk> chunks;
+                while (num && chunks.size() < window) {
+                    Chunk& chunk{chunks.emplace_back()};
+                    file >> chunk.header;
+                    if (chunk.header.tx_count == 0 || chunk.header.tx_count > std::min<uint64_t>(num, MEMPOOL_DUMP_CHUNK_TXS) || chunk.header.size > MEMPOOL_DUMP_MAX_CHUNK_BYTES) {
+                        throw std::runtime_error("invalid chunk header");
                     }
+                    num -= chunk.header.tx_count;
+                    chunk.data.resize(chunk.header.size);
+                    file.read(MakeWritableByteSpan(chunk.data));
+                }
+                DeserializeChunks(chunks);
+
+                for (const Chunk& chunk : chunks) {
+                    if (!chunk.error.empty()) {
+                        LogPrintf("Skipping %u unreadable mempool transactions: %s\n", chunk.header.tx_count, chunk.error);
+                        failed += chunk.header.tx_count;
+                        continue;
+                    }
+                    // Accept the transactions of a chunk in one go, rather
+                    // than taking cs_main for each one of them.
+                    LOCK(cs_main);
+                    const CBlockIndex* tip{active_chainstate.m_chain.Tip()};
+                    const bool same_tip{tip && tip->GetBlockHash() == tip_hash};
+                    for (const PersistedTx& ptx : chunk.txs) {
+                        accept(ptx, skip_script_checks && same_tip);
+                    }
+                    if (ShutdownRequested())
+                        return false;
                 }
-            } else {
-                ++expired;
             }
-            if (ShutdownRequested())
-                return false;
+        } else {
+            return false;
         }
         std::map<uint256, CAmount> mapDeltas;
         file >> mapDeltas;
@@ -119,11 +245,11 @@ bool LoadMempool(CTxMemPool& pool, const fs::path& load_path, Chainstate& active
         return false;
     }
 
-    LogPrintf("Imported mempool transactions from disk: %i succeeded, %i failed, %i expired, %i already there, %i waiting for initial broadcast\n", count, failed, expired, already_there, unbroadcast);
+    LogPrintf("Imported mempool transactions from disk: %i succeeded (%i without script checks), %i failed, %i expired, %i already there, %i waiting for initial broadcast\n", count, scripts_skipped, failed, expired, already_there, unbroadcast);
     return true;
 }
 
-bool DumpMempool(const CTxMemPool& pool, const fs::path& dump_path, FopenFn mockable_fopen_function, bool skip_file_commit)
+bool DumpMempool(const CTxMemPool& pool, const fs::path& dump_path, const Chainstate& active_chainstate, FopenFn mockable_fopen_function, bool skip_file_commit)
 {
     auto start = SteadyClock::now();
 
@@ -134,14 +260,22 @@ bool DumpMempool(const CTxMemPool& pool, const fs::path& dump_path, FopenFn mock
     static Mutex dump_mutex;
     LOCK(dump_mutex);
 
+    uint256 tip_hash;
+
     {
-        LOCK(pool.cs);
+        LOCK2(cs_main, pool.cs);
+        if (const CBlockIndex* tip{active_chainstate.m_chain.Tip()}) tip_hash = tip->GetBlockHash();
         for (const auto &i : pool.mapDeltas) {
             mapDeltas[i.first] = i.second;
         }
         vinfo = pool.infoAll();
         unbroadcast_txids = pool.GetUnbroadcastTxs();
     }
+    // A transaction heavier than a block can never be mined, and would not fit
+    // into a chunk.
+    vinfo.erase(std::remove_if(vinfo.begin(), vinfo.end(), [](const TxMempoolInfo& info) {
+        return GetTransactionWeight(*info.tx) > MAX_BLOCK_WEIGHT;
+    }), vinfo.end());
 
     auto mid = SteadyClock::now();
 
@@ -156,12 +290,33 @@ bool DumpMempool(const CTxMemPool& pool, const fs::path& dump_path, FopenFn mock
         uint64_t version = MEMPOOL_DUMP_VERSION;
         file << version;
 
+        file << tip_hash;
+        file << uint32_t{STANDARD_SCRIPT_VERIFY_FLAGS};
+
         file << (uint64_t)vinfo.size();
-        for (const auto& i : vinfo) {
-            file << *(i.tx);
-            file << int64_t{count_seconds(i.m_time)};
-            file << int64_t{i.nFeeDelta};
-            mapDeltas.erase(i.tx->GetHash());
+        CDataStream chunk{SER_DISK, CLIENT_VERSION};
+        uint32_t chunk_txs{0};
+        const auto write_chunk{[&] {
+            file << ChunkHeader{chunk_txs, uint32_t(chunk.size()), Hash(chunk)};
+            file.write(MakeByteSpan(chunk));
+            chunk.clear();
+            chunk_txs = 0;
+        }};
+        for (size_t i = 0; i < vinfo.size(); ++i) {
+            const TxMempoolInfo& info{vinfo[i]};
+            // Non-standard transactions can be much larger than the room
+            // MEMPOOL_DUMP_MAX_CHUNK_BYTES leaves past MEMPOOL_DUMP_CHUNK_BYTES.
+            const size_t tx_bytes{GetSerializeSize(*info.tx, CLIENT_VERSION) + 2 * sizeof(int64_t)};
+            if (chunk_txs > 0 && chunk.size() + tx_bytes > MEMPOOL_DUMP_MAX_CHUNK_BYTES) write_chunk();
+            chunk << *(info.tx);
+            chunk << int64_t{count_seconds(info.m_time)};
+            chunk << int64_t{info.nFeeDelta};
+            ++chunk_txs;
+            mapDeltas.erase(info.tx->GetHash());
+
+            if (chunk_txs == MEMPOOL_DUMP_CHUNK_TXS || chunk.size() >= MEMPOOL_DUMP_CHUNK_BYTES || i + 1 == vinfo.size()) {
+                write_chunk();
+            }
         }
 
         file << mapDeltas;
@@ -13,15 +13,29 @@ class CTxMemPool;
 
 namespace kernel {
 
-/** Dump the mempool to disk. */
+/**
+ * Dump the mempool to disk.
+ *
+ * The transactions are written in checksummed chunks, along with the tip the
+ * mempool was consistent with, so that they can be verified and deserialized
+ * in parallel when loading.
+ */
 bool DumpMempool(const CTxMemPool& pool, const fs::path& dump_path,
+                 const Chainstate& active_chainstate,
                  fsbridge::FopenFn mockable_fopen_function = fsbridge::fopen,
                  bool skip_file_commit = false);
 
+struct ImportMempoolOptions {
+    fsbridge::FopenFn mockable_fopen_function{fsbridge::fopen};
+    //! Don't verify the scripts of transactions that were dumped on top of
+    //! the current tip with the current script verification flags
+    bool skip_script_checks{false};
+};
+
 /** Load the mempool from disk. */
 bool LoadMempool(CTxMemPool& pool, const fs::path& load_path,
                  Chainstate& active_chainstate,
-                 fsbridge::FopenFn mockable_fopen_function = fsbridge::fopen);
+                 ImportMempoolOptions&& opts = {});
 
 } // namespace kernel
 
@@ -85,7 +85,7 @@ int main(int argc, char* argv[])
         .chainparams = chainparams,
         .adjusted_time_callback = NodeClock::now,
     };
-    ChainstateManager chainman{chainman_opts};
+    ChainstateManager chainman{chainman_opts, node::BlockManager::Options{}};
 
     node::CacheSizes cache_sizes;
     cache_sizes.block_tree_db = 2 << 20;
@@ -566,15 +566,23 @@ CNode* CConnman::ConnectNode(CAddress addrConnect, const char *pszDest, bool fCo
     return pnode;
 }
 
-void CNode::CloseSocketDisconnect()
+std::shared_ptr<Sock> CNode::CloseSocketDisconnect()
 {
     fDisconnect = true;
     LOCK(m_sock_mutex);
-    if (m_sock) {
+    std::shared_ptr<Sock> sock{std::move(m_sock)};
+    if (sock) {
         LogPrint(BCLog::NET, "disconnecting peer=%d\n", id);
-        m_sock.reset();
     }
     m_i2p_sam_session.reset();
+    return sock;
+}
+
+void CConnman::CloseNodeSocket(CNode& node)
+{
+    if (const auto sock{node.CloseSocketDisconnect()}) {
+        m_sock_wait_set.Remove(*sock);
+    }
 }
 
 void CConnman::AddWhitelistPermissionFlags(NetPermissionFlags& flags, const CNetAddr &addr) const {
@@ -637,7 +645,9 @@ void CNode::CopyStats(CNodeStats& stats)
         LOCK(cs_vRecv);
         X(mapRecvBytesPerMsgType);
         X(nRecvBytes);
+        stats.m_recv_buffer_size = m_deserializer->GetBufferSize();
     }
+    stats.m_recv_buffer_size += WITH_LOCK(cs_vProcessMsg, return nProcessQueueSize);
     X(m_permission_flags);
 
     X(m_last_ping_time);
@@ -747,12 +757,29 @@ int V1TransportDeserializer::readData(Span<const uint8_t> msg_bytes)
     }
 
     hasher.Write(msg_bytes.first(nCopy));
-    memcpy(&vRecv[nDataPos], msg_bytes.data(), nCopy);
+    // The bytes are already in place if they were received into the buffer
+    // returned by GetPayloadBuffer().
+    if (msg_bytes.data() != UCharCast(vRecv.data() + nDataPos)) {
+        memcpy(&vRecv[nDataPos], msg_bytes.data(), nCopy);
+    }
     nDataPos += nCopy;
 
     return nCopy;
 }
 
+Span<uint8_t> V1TransportDeserializer::GetPayloadBuffer(size_t max_size)
+{
+    // Only worth it for payloads larger than the buffer: a smaller remainder
+    // would be followed by the next message, which has to be copied anyway.
+    if (!in_data || max_size == 0 || hdr.nMessageSize - nDataPos < max_size) return {};
+
+    if (vRecv.size() < nDataPos + max_size) {
+        // Same allocation policy as readData().
+        vRecv.resize(std::min<size_t>(hdr.nMessageSize, nDataPos + max_size + 256 * 1024));
+    }
+    return {reinterpret_cast<uint8_t*>(vRecv.data() + nDataPos), max_size};
+}
+
 const uint256& V1TransportDeserializer::GetMessageHash() const
 {
     assert(Complete());
@@ -812,7 +839,7 @@ void V1TransportSerializer::prepareForTransport(CSerializedNetMsg& msg, std::vec
     CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, header, 0, hdr};
 }
 
-size_t CConnman::SocketSendData(CNode& node) const
+size_t CConnman::SocketSendData(CNode& node)
 {
     auto it = node.vSendMsg.begin();
     size_t nSentSize = 0;
@@ -848,7 +875,7 @@ size_t CConnman::SocketSendData(CNode& node) const
                 int nErr = WSAGetLastError();
                 if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS) {
                     LogPrint(BCLog::NET, "socket send error for peer=%d: %s\n", node.GetId(), NetworkErrorString(nErr));
-                    node.CloseSocketDisconnect();
+                    CloseNodeSocket(node);
                 }
             }
             // couldn't send anything at all
@@ -861,6 +888,7 @@ size_t CConnman::SocketSendData(CNode& node) const
         assert(node.nSendSize == 0);
     }
     node.vSendMsg.erase(node.vSendMsg.begin(), it);
+    UpdateSockEvents(node);
     return nSentSize;
 }
 
@@ -1042,6 +1070,7 @@ void CConnman::CreateNodeFromAcceptedSocket(std::unique_ptr<Sock>&& sock,
         LOCK(m_nodes_mutex);
         m_nodes.push_back(pnode);
     }
+    WITH_LOCK(pnode->cs_vSend, UpdateSockEvents(*pnode));
 
     // We received a new connection, harvest entropy from the time (and our peer count)
     RandAddEvent((uint32_t)id);
@@ -1111,7 +1140,7 @@ void CConnman::DisconnectNodes()
                 pnode->grantOutbound.Release();
 
                 // close socket and cleanup
-                pnode->CloseSocketDisconnect();
+                CloseNodeSocket(*pnode);
 
                 // hold in disconnected pool until all refs are released
                 pnode->Release();
@@ -1186,49 +1215,38 @@ bool CConnman::InactivityCheck(const CNode& node) const
     return false;
 }
 
-Sock::EventsPerSock CConnman::GenerateWaitSockets(Span<CNode* const> nodes)
+void CConnman::UpdateSockEvents(CNode& node)
 {
-    Sock::EventsPerSock events_per_sock;
-
-    for (const ListenSocket& hListenSocket : vhListenSocket) {
-        events_per_sock.emplace(hListenSocket.sock, Sock::Events{Sock::RECV});
+    // Implement the following logic:
+    // * If there is data to send, wait for sending data. As this only
+    //   happens when optimistic write failed, we choose to first drain the
+    //   write buffer in this case before receiving more. This avoids
+    //   needlessly queueing received data, if the remote peer is not themselves
+    //   receiving data. This means properly utilizing TCP flow control signalling.
+    // * Otherwise, if there is space left in the receive buffer, wait for
+    //   receiving data.
+    // * Hand off all complete messages to the processor, to be handled without
+    //   blocking here.
+    //
+    // This is called with cs_vSend held after every change of the state it
+    // looks at, so that the last call always sees the current state.
+    Sock::Event requested{0};
+    if (!node.vSendMsg.empty()) {
+        requested = Sock::SEND;
+    } else if (!node.fPauseRecv) {
+        requested = Sock::RECV;
     }
 
-    for (CNode* pnode : nodes) {
-        // Implement the following logic:
-        // * If there is data to send, select() for sending data. As this only
-        //   happens when optimistic write failed, we choose to first drain the
-        //   write buffer in this case before receiving more. This avoids
-        //   needlessly queueing received data, if the remote peer is not themselves
-        //   receiving data. This means properly utilizing TCP flow control signalling.
-        // * Otherwise, if there is space left in the receive buffer, select() for
-        //   receiving data.
-        // * Hand off all complete messages to the processor, to be handled without
-        //   blocking here.
-
-        bool select_recv = !pnode->fPauseRecv;
-        bool select_send;
-        {
-            LOCK(pnode->cs_vSend);
-            select_send = !pnode->vSendMsg.empty();
-        }
-
-        LOCK(pnode->m_sock_mutex);
-        if (!pnode->m_sock) {
-            continue;
-        }
-
-        Sock::Event requested{0};
-        if (select_send) {
-            requested = Sock::SEND;
-        } else if (select_recv) {
-            requested = Sock::RECV;
-        }
-
-        events_per_sock.emplace(pnode->m_sock, Sock::Events{requested});
+    LOCK(node.m_sock_mutex);
+    if (node.m_sock) {
+        m_sock_wait_set.Set(node.m_sock, requested);
     }
+}
 
-    return events_per_sock;
+void CConnman::ResumeRecv(CNode& node)
+{
+    LOCK(node.cs_vSend);
+    UpdateSockEvents(node);
 }
 
 void CConnman::SocketHandler()
@@ -1243,11 +1261,10 @@ void CConnman::SocketHandler()
         const auto timeout = std::chrono::milliseconds(SELECT_TIMEOUT_MILLISECONDS);
 
         // Check for the readiness of the already connected sockets and the
-        // listening sockets in one call ("readiness" as in poll(2) or
-        // select(2)). If none are ready, wait for a short while and return
-        // empty sets.
-        events_per_sock = GenerateWaitSockets(snap.Nodes());
-        if (events_per_sock.empty() || !events_per_sock.begin()->first->WaitMany(timeout, events_per_sock)) {
+        // listening sockets in one call ("readiness" as in epoll(7), poll(2)
+        // or select(2)). If none are ready, wait for a short while and return
+        // an empty set.
+        if (!m_sock_wait_set.Wait(timeout, events_per_sock)) {
             interruptNet.sleep_for(timeout);
         }
 
@@ -1290,19 +1307,23 @@ void CConnman::SocketHandlerConnected(const std::vector<CNode*>& nodes,
         {
             // typical socket buffer is 8K-64K
             uint8_t pchBuf[0x10000];
+            // Receive the payload of large messages (blocks) into the message
+            // itself rather than copying it out of pchBuf.
+            Span<uint8_t> recv_buf{pnode->GetRecvBuffer(sizeof(pchBuf))};
+            if (recv_buf.empty()) recv_buf = pchBuf;
             int nBytes = 0;
             {
                 LOCK(pnode->m_sock_mutex);
                 if (!pnode->m_sock) {
                     continue;
                 }
-                nBytes = pnode->m_sock->Recv(pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
+                nBytes = pnode->m_sock->Recv(recv_buf.data(), recv_buf.size(), MSG_DONTWAIT);
             }
             if (nBytes > 0)
             {
                 bool notify = false;
-                if (!pnode->ReceiveMsgBytes({pchBuf, (size_t)nBytes}, notify)) {
-                    pnode->CloseSocketDisconnect();
+                if (!pnode->ReceiveMsgBytes(recv_buf.first(nBytes), notify)) {
+                    CloseNodeSocket(*pnode);
                 }
                 RecordBytesRecv(nBytes);
                 if (notify) {
@@ -1319,6 +1340,10 @@ void CConnman::SocketHandlerConnected(const std::vector<CNode*>& nodes,
                         pnode->nProcessQueueSize += nSizeAdded;
                         pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
                     }
+                    if (pnode->fPauseRecv) {
+                        LOCK(pnode->cs_vSend);
+                        UpdateSockEvents(*pnode);
+                    }
                     WakeMessageHandler();
                 }
             }
@@ -1328,7 +1353,7 @@ void CConnman::SocketHandlerConnected(const std::vector<CNode*>& nodes,
                 if (!pnode->fDisconnect) {
                     LogPrint(BCLog::NET, "socket closed for peer=%d\n", pnode->GetId());
                 }
-                pnode->CloseSocketDisconnect();
+                CloseNodeSocket(*pnode);
             }
             else if (nBytes < 0)
             {
@@ -1339,7 +1364,7 @@ void CConnman::SocketHandlerConnected(const std::vector<CNode*>& nodes,
                     if (!pnode->fDisconnect) {
                         LogPrint(BCLog::NET, "socket recv error for peer=%d: %s\n", pnode->GetId(), NetworkErrorString(nErr));
                     }
-                    pnode->CloseSocketDisconnect();
+                    CloseNodeSocket(*pnode);
                 }
             }
         }
@@ -1384,9 +1409,9 @@ void CConnman::WakeMessageHandler()
 {
     {
         LOCK(mutexMsgProc);
-        fMsgProcWake = true;
+        ++nMsgProcWakeSeq;
     }
-    condMsgProc.notify_one();
+    condMsgProc.notify_all();
 }
 
 void CConnman::ThreadDNSAddressSeed()
@@ -1989,11 +2014,13 @@ void CConnman::OpenNetworkConnection(const CAddress& addrConnect, bool fCountFai
         LOCK(m_nodes_mutex);
         m_nodes.push_back(pnode);
     }
+    WITH_LOCK(pnode->cs_vSend, UpdateSockEvents(*pnode));
 }
 
-void CConnman::ThreadMessageHandler()
+void CConnman::ThreadMessageHandler(int shard)
 {
     SetSyscallSandboxPolicy(SyscallSandboxPolicy::MESSAGE_HANDLER);
+    uint64_t wake_seq{WITH_LOCK(mutexMsgProc, return nMsgProcWakeSeq)};
     while (!flagInterruptMsgProc)
     {
         bool fMoreWork = false;
@@ -2005,7 +2032,7 @@ void CConnman::ThreadMessageHandler()
             const NodesSnapshot snap{*this, /*shuffle=*/true};
 
             for (CNode* pnode : snap.Nodes()) {
-                if (pnode->fDisconnect)
+                if (pnode->fDisconnect || pnode->GetId() % m_num_msghand_threads != shard)
                     continue;
 
                 // Receive messages
@@ -2026,9 +2053,9 @@ void CConnman::ThreadMessageHandler()
 
         WAIT_LOCK(mutexMsgProc, lock);
         if (!fMoreWork) {
-            condMsgProc.wait_until(lock, std::chrono::steady_clock::now() + std::chrono::milliseconds(100), [this]() EXCLUSIVE_LOCKS_REQUIRED(mutexMsgProc) { return fMsgProcWake; });
+            condMsgProc.wait_until(lock, std::chrono::steady_clock::now() + std::chrono::milliseconds(100), [&]() EXCLUSIVE_LOCKS_REQUIRED(mutexMsgProc) { return nMsgProcWakeSeq != wake_seq; });
         }
-        fMsgProcWake = false;
+        wake_seq = nMsgProcWakeSeq;
     }
 }
 
@@ -2136,7 +2163,7 @@ bool CConnman::BindListenPort(const CService& addrBind, bilingual_str& strError,
         return false;
     }
 
-    vhListenSocket.emplace_back(std::move(sock), permissions);
+    m_sock_wait_set.Set(vhListenSocket.emplace_back(std::move(sock), permissions).sock, Sock::RECV);
     return true;
 }
 
@@ -2326,11 +2353,6 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
     interruptNet.reset();
     flagInterruptMsgProc = false;
 
-    {
-        LOCK(mutexMsgProc);
-        fMsgProcWake = false;
-    }
-
     // Send and receive from sockets, accept connections
     threadSocketHandler = std::thread(&util::TraceThread, "net", [this] { ThreadSocketHandler(); });
 
@@ -2357,7 +2379,10 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
     }
 
     // Process messages
-    threadMessageHandler = std::thread(&util::TraceThread, "msghand", [this] { ThreadMessageHandler(); });
+    for (int shard = 0; shard < m_num_msghand_threads; ++shard) {
+        const std::string name{m_num_msghand_threads == 1 ? "msghand" : strprintf("msghand.%i", shard)};
+        threadMessageHandlers.emplace_back(&util::TraceThread, name, [this, shard] { ThreadMessageHandler(shard); });
+    }
 
     if (m_i2p_sam_session) {
         threadI2PAcceptIncoming =
@@ -2414,8 +2439,10 @@ void CConnman::StopThreads()
     if (threadI2PAcceptIncoming.joinable()) {
         threadI2PAcceptIncoming.join();
     }
-    if (threadMessageHandler.joinable())
-        threadMessageHandler.join();
+    for (std::thread& thread : threadMessageHandlers) {
+        thread.join();
+    }
+    threadMessageHandlers.clear();
     if (threadOpenConnections.joinable())
         threadOpenConnections.join();
     if (threadOpenAddedConnections.joinable())
@@ -2446,7 +2473,7 @@ void CConnman::StopNodes()
     std::vector<CNode*> nodes;
     WITH_LOCK(m_nodes_mutex, nodes.swap(m_nodes));
     for (CNode* pnode : nodes) {
-        pnode->CloseSocketDisconnect();
+        CloseNodeSocket(*pnode);
         DeleteNode(pnode);
     }
 
@@ -2454,6 +2481,9 @@ void CConnman::StopNodes()
         DeleteNode(pnode);
     }
     m_nodes_disconnected.clear();
+    for (const ListenSocket& listen_socket : vhListenSocket) {
+        m_sock_wait_set.Remove(*listen_socket.sock);
+    }
     vhListenSocket.clear();
     semOutbound.reset();
     semAddnode.reset();
@@ -2494,6 +2524,7 @@ std::vector<CAddress> CConnman::GetAddresses(CNode& requestor, size_t max_addres
         .Write(requestor.IsInboundConn() ? requestor.addrBind.GetPort() : 0)
         .Finalize();
     const auto current_time = GetTime<std::chrono::microseconds>();
+    LOCK(m_addr_response_caches_mutex);
     auto r = m_addr_response_caches.emplace(cache_id, CachedAddrResponse{});
     CachedAddrResponse& cache_entry = r.first->second;
     if (cache_entry.m_cache_entry_expiration < current_time) { // If emplace() added new one it has expiration 0.
@@ -89,6 +89,10 @@ static constexpr bool DEFAULT_DNSSEED{true};
 static constexpr bool DEFAULT_FIXEDSEEDS{true};
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
 static const size_t DEFAULT_MAXSENDBUFFER    = 1 * 1000;
+/** Default number of message handler threads */
+static const int DEFAULT_MSGHAND_THREADS = 1;
+/** Maximum number of message handler threads */
+static const int MAX_MSGHAND_THREADS = 16;
 
 typedef int64_t NodeId;
 
@@ -206,6 +210,8 @@ public:
     mapMsgTypeSize mapSendBytesPerMsgType;
     uint64_t nRecvBytes;
     mapMsgTypeSize mapRecvBytesPerMsgType;
+    //! Bytes held for messages from this peer that have not been processed yet
+    uint64_t m_recv_buffer_size;
     NetPermissionFlags m_permission_flags;
     std::chrono::microseconds m_last_ping_time;
     std::chrono::microseconds m_min_ping_time;
@@ -254,6 +260,15 @@ public:
     virtual void SetVersion(int version) = 0;
     /** read and deserialize data, advances msg_bytes data pointer */
     virtual int Read(Span<const uint8_t>& msg_bytes) = 0;
+    /**
+     * Return a buffer of up to max_size bytes that the next bytes of the
+     * current message can be received into directly, so that Read() does not
+     * have to copy them, or an empty span if there is no such buffer. The
+     * buffer is invalidated by the next call to any other member function.
+     */
+    virtual Span<uint8_t> GetPayloadBuffer(size_t max_size) { return {}; }
+    // bytes allocated for the message being received
+    virtual size_t GetBufferSize() const = 0;
     // decomposes a message from the context
     virtual CNetMessage GetMessage(std::chrono::microseconds time, bool& reject_message) = 0;
     virtual ~TransportDeserializer() {}
@@ -319,6 +334,11 @@ public:
         }
         return ret;
     }
+    Span<uint8_t> GetPayloadBuffer(size_t max_size) override;
+    size_t GetBufferSize() const override
+    {
+        return hdrbuf.size() + vRecv.size();
+    }
     CNetMessage GetMessage(std::chrono::microseconds time, bool& reject_message) override;
 };
 
@@ -559,6 +579,19 @@ public:
      */
     bool ReceiveMsgBytes(Span<const uint8_t> msg_bytes, bool& complete) EXCLUSIVE_LOCKS_REQUIRED(!cs_vRecv);
 
+    /**
+     * Return a buffer of up to max_size bytes to receive data from the socket
+     * into, or an empty span if the data should be received into a temporary
+     * buffer instead. A non-empty buffer is returned while the payload of a
+     * large message is being received, so that it can be written into the
+     * message directly. Whatever part of it was filled must then be passed to
+     * ReceiveMsgBytes() before this is called again.
+     */
+    Span<uint8_t> GetRecvBuffer(size_t max_size) EXCLUSIVE_LOCKS_REQUIRED(!cs_vRecv)
+    {
+        return WITH_LOCK(cs_vRecv, return m_deserializer->GetPayloadBuffer(max_size));
+    }
+
     void SetCommonVersion(int greatest_common_version)
     {
         Assume(m_greatest_common_version == INIT_PROTO_VERSION);
@@ -584,9 +617,14 @@ public:
         nRefCount--;
     }
 
-    void CloseSocketDisconnect() EXCLUSIVE_LOCKS_REQUIRED(!m_sock_mutex);
+    /**
+     * Mark the node for disconnection and drop its socket.
+     * @return the dropped socket, if any, so that it can be removed from
+     * where it is waited on before the last reference to it closes it
+     */
+    std::shared_ptr<Sock> CloseSocketDisconnect() EXCLUSIVE_LOCKS_REQUIRED(!m_sock_mutex);
 
-    void CopyStats(CNodeStats& stats) EXCLUSIVE_LOCKS_REQUIRED(!m_subver_mutex, !m_addr_local_mutex, !cs_vSend, !cs_vRecv);
+    void CopyStats(CNodeStats& stats) EXCLUSIVE_LOCKS_REQUIRED(!m_subver_mutex, !m_addr_local_mutex, !cs_vSend, !cs_vRecv, !cs_vProcessMsg);
 
     std::string ConnectionTypeAsString() const { return ::ConnectionTypeAsString(m_conn_type); }
 
@@ -679,6 +717,7 @@ public:
         BanMan* m_banman = nullptr;
         unsigned int nSendBufferMaxSize = 0;
         unsigned int nReceiveFloodSize = 0;
+        int m_msghand_threads = DEFAULT_MSGHAND_THREADS;
         uint64_t nMaxOutboundLimit = 0;
         int64_t m_peer_connect_timeout = DEFAULT_PEER_CONNECT_TIMEOUT;
         std::vector<std::string> vSeedNodes;
@@ -712,6 +751,7 @@ public:
         m_msgproc = connOptions.m_msgproc;
         nSendBufferMaxSize = connOptions.nSendBufferMaxSize;
         nReceiveFloodSize = connOptions.nReceiveFloodSize;
+        m_num_msghand_threads = std::clamp(connOptions.m_msghand_threads, 1, MAX_MSGHAND_THREADS);
         m_peer_connect_timeout = std::chrono::seconds{connOptions.m_peer_connect_timeout};
         {
             LOCK(m_total_bytes_sent_mutex);
@@ -785,7 +825,7 @@ public:
      * A non-malicious call (from RPC or a peer with addr permission) should
      * call the function without a parameter to avoid using the cache.
      */
-    std::vector<CAddress> GetAddresses(CNode& requestor, size_t max_addresses, size_t max_pct);
+    std::vector<CAddress> GetAddresses(CNode& requestor, size_t max_addresses, size_t max_pct) EXCLUSIVE_LOCKS_REQUIRED(!m_addr_response_caches_mutex);
 
     // This allows temporarily exceeding m_max_outbound_full_relay, with the goal of finding
     // a peer that is better than all our current peers.
@@ -859,6 +899,9 @@ public:
 
     unsigned int GetReceiveFloodSize() const;
 
+    /** Wait for data from a peer again, after its fPauseRecv was cleared. */
+    void ResumeRecv(CNode& node) EXCLUSIVE_LOCKS_REQUIRED(!node.cs_vSend, !node.m_sock_mutex);
+
     void WakeMessageHandler() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
 
     /** Return true if we should disconnect the peer for failing an inactivity check. */
@@ -890,7 +933,13 @@ private:
     void AddAddrFetch(const std::string& strDest) EXCLUSIVE_LOCKS_REQUIRED(!m_addr_fetches_mutex);
     void ProcessAddrFetch() EXCLUSIVE_LOCKS_REQUIRED(!m_addr_fetches_mutex);
     void ThreadOpenConnections(std::vector<std::string> connect) EXCLUSIVE_LOCKS_REQUIRED(!m_addr_fetches_mutex, !m_added_nodes_mutex, !m_nodes_mutex);
-    void ThreadMessageHandler() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
+    /**
+     * Process the messages of the peers whose id modulo the number of
+     * message handler threads is shard. Each peer is only ever handled by
+     * one thread, so per-peer state needs no further locking; state shared
+     * between peers is guarded by cs_main or its own mutex.
+     */
+    void ThreadMessageHandler(int shard) EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
     void ThreadI2PAcceptIncoming();
     void AcceptConnection(const ListenSocket& hListenSocket);
 
@@ -913,11 +962,16 @@ private:
     bool InactivityCheck(const CNode& node) const;
 
     /**
-     * Generate a collection of sockets to check for IO readiness.
-     * @param[in] nodes Select from these nodes' sockets.
-     * @return sockets to check for readiness
+     * Set the events to wait for on a node's socket from its current state,
+     * adding the socket to m_sock_wait_set if it is not in it yet. Must be
+     * called after any change of the node's send queue or fPauseRecv.
+     */
+    void UpdateSockEvents(CNode& node) EXCLUSIVE_LOCKS_REQUIRED(node.cs_vSend, !node.m_sock_mutex);
+
+    /**
+     * Disconnect a node and stop waiting on its socket.
      */
-    Sock::EventsPerSock GenerateWaitSockets(Span<CNode* const> nodes);
+    void CloseNodeSocket(CNode& node) EXCLUSIVE_LOCKS_REQUIRED(!node.m_sock_mutex);
 
     /**
      * Check connected and listening sockets for IO readiness and process them accordingly.
@@ -963,7 +1017,7 @@ private:
 
     NodeId GetNewNodeId();
 
-    size_t SocketSendData(CNode& node) const EXCLUSIVE_LOCKS_REQUIRED(node.cs_vSend);
+    size_t SocketSendData(CNode& node) EXCLUSIVE_LOCKS_REQUIRED(node.cs_vSend, !node.m_sock_mutex);
     void DumpAddresses();
 
     // Network stats
@@ -1037,8 +1091,12 @@ private:
      * distinct Network (up to 5) we have/had an inbound peer from,
      * resulting in at most ~196 KB. Every separate local socket may
      * add up to ~196 KB extra.
+     *
+     * Message handler threads serving different peers look up and refresh
+     * the caches concurrently, so they are protected by their own mutex.
      */
-    std::map<uint64_t, CachedAddrResponse> m_addr_response_caches;
+    std::map<uint64_t, CachedAddrResponse> m_addr_response_caches GUARDED_BY(m_addr_response_caches_mutex);
+    Mutex m_addr_response_caches_mutex;
 
     /**
      * Services this node offers.
@@ -1081,8 +1139,8 @@ private:
     /** SipHasher seeds for deterministic randomness */
     const uint64_t nSeed0, nSeed1;
 
-    /** flag for waking the message processor. */
-    bool fMsgProcWake GUARDED_BY(mutexMsgProc);
+    /** Incremented for waking the message processor threads. */
+    uint64_t nMsgProcWakeSeq GUARDED_BY(mutexMsgProc){0};
 
     std::condition_variable condMsgProc;
     Mutex mutexMsgProc;
@@ -1103,11 +1161,21 @@ private:
      */
     std::unique_ptr<i2p::sam::Session> m_i2p_sam_session;
 
+    /**
+     * Connected and listening sockets waited on by SocketHandler(). Sockets
+     * are added when they are connected or bound, removed when they are
+     * closed, and their events are changed by UpdateSockEvents().
+     */
+    SockWaitSet m_sock_wait_set;
+
     std::thread threadDNSAddressSeed;
     std::thread threadSocketHandler;
     std::thread threadOpenAddedConnections;
     std::thread threadOpenConnections;
-    std::thread threadMessageHandler;
+    std::vector<std::thread> threadMessageHandlers;
+
+    /** Number of message handler threads, each serving a share of the peers. */
+    int m_num_msghand_threads{DEFAULT_MSGHAND_THREADS};
     std::thread threadI2PAcceptIncoming;
 
     /** flag for deciding to connect to an extra outbound peer,
@@ -8,6 +8,7 @@
 #define KOYOTECOIN_NET_PROCESSING_H
 
 #include <net.h>
+#include <txorphanage.h>
 #include <validationinterface.h>
 
 class AddrMan;
@@ -62,6 +63,9 @@ public:
     /** Get statistics from node state */
     virtual bool GetNodeStateStats(NodeId nodeid, CNodeStateStats& stats) const = 0;
 
+    /** Get statistics about the orphan transactions kept */
+    virtual TxOrphanage::Info GetOrphanInfo() const = 0;
+
     /** Whether this node ignores txs received over p2p. */
     virtual bool IgnoresIncomingTxs() = 0;
 
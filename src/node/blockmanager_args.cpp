@@ -0,0 +1,18 @@
+// Copyright (c) 2023-2023 The Koyotecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockmanager_args.h>
+
+#include <kernel/blockmanager_opts.h>
+
+#include <util/system.h>
+
+using kernel::BlockManagerOpts;
+
+namespace node {
+void ApplyArgsManOptions(const ArgsManager& argsman, BlockManagerOpts& blockman_opts)
+{
+    blockman_opts.use_mmap = argsman.GetBoolArg("-blocksmmap", blockman_opts.use_mmap);
+}
+} // namespace node
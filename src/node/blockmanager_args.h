@@ -0,0 +1,17 @@
+// Copyright (c) 2023-2023 The Koyotecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KOYOTECOIN_NODE_BLOCKMANAGER_ARGS_H
+#define KOYOTECOIN_NODE_BLOCKMANAGER_ARGS_H
+
+class ArgsManager;
+namespace kernel {
+struct BlockManagerOpts;
+};
+
+namespace node {
+void ApplyArgsManOptions(const ArgsManager& argsman, kernel::BlockManagerOpts& blockman_opts);
+} // namespace node
+
+#endif // KOYOTECOIN_NODE_BLOCKMANAGER_ARGS_H
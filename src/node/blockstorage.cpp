@@ -9,9 +9,11 @@
 #include <chainparams.h>
 #include <clientversion.h>
 #include <consensus/validation.h>
+#include <crypto/common.h>
 #include <flatfile.h>
 #include <fs.h>
 #include <hash.h>
+#include <node/mempool_persist_args.h>
 #include <pow.h>
 #include <reverse_iterator.h>
 #include <shutdown.h>
@@ -23,6 +25,7 @@
 #include <validation.h>
 
 #include <map>
+#include <memory>
 #include <unordered_map>
 
 namespace node {
@@ -59,6 +62,66 @@ static FILE* OpenUndoFile(const FlatFilePos& pos, bool fReadOnly = false);
 static FlatFileSeq BlockFileSeq();
 static FlatFileSeq UndoFileSeq();
 
+std::shared_ptr<const MappedFile> BlockFileMaps::Get(const FlatFileSeq& seq, const FlatFilePos& pos, uint64_t min_size)
+{
+    LOCK(m_mutex);
+    if (pos.nFile < 0 || pos.nFile >= m_active_file) return nullptr;
+    const fs::path path{seq.FileName(pos)};
+    auto it{m_maps.find(path)};
+    if (it == m_maps.end() || it->second->Data().size() < min_size) {
+        // Undo data is still appended to a file after the block writer
+        // has left it, so remap files that have grown.
+        std::shared_ptr<const MappedFile> map{seq.Map(pos)};
+        if (!map) return nullptr;
+        it = m_maps.insert_or_assign(path, std::move(map)).first;
+    }
+    if (it->second->Data().size() < min_size) return nullptr;
+    return it->second;
+}
+
+void BlockFileMaps::SetActiveFile(int nFile)
+{
+    LOCK(m_mutex);
+    if (nFile < m_active_file) m_maps.clear();
+    m_active_file = nFile;
+}
+
+void BlockFileMaps::Drop(const fs::path& path)
+{
+    LOCK(m_mutex);
+    m_maps.erase(path);
+}
+
+Span<const unsigned char> BlockManager::MapRecord(const FlatFilePos& pos, bool undo, std::shared_ptr<const MappedFile>& map)
+{
+    if (!m_opts.use_mmap || pos.nFile < 0 || pos.nPos < 8) return {};
+
+    // Files are truncated to their used size when finalized, and mapped pages
+    // past the end of a file fault on access, so never hand out bytes beyond
+    // what the block file info records as written.
+    const uint64_t used_size{WITH_LOCK(cs_LastBlockFile, {
+        if (static_cast<size_t>(pos.nFile) >= m_blockfile_info.size()) return uint64_t{0};
+        const CBlockFileInfo& info{m_blockfile_info[pos.nFile]};
+        return uint64_t{undo ? info.nUndoSize : info.nSize};
+    })};
+    if (used_size < pos.nPos) return {};
+
+    const FlatFileSeq seq{undo ? UndoFileSeq() : BlockFileSeq()};
+    map = m_block_file_maps.Get(seq, pos, pos.nPos);
+    if (!map) return {};
+    // Undo records are followed by a checksum of the block hash and undo data
+    const uint64_t end{uint64_t{pos.nPos} + ReadLE32(map->Data().data() + pos.nPos - 4) + (undo ? uint256::size() : 0)};
+    if (end > used_size) {
+        LogPrint(BCLog::BLOCKSTORE, "%s: Record at %s ends past the used size of the file\n", __func__, pos.ToString());
+        return {};
+    }
+    if (map->Data().size() < end) {
+        map = m_block_file_maps.Get(seq, pos, end);
+        if (!map) return {};
+    }
+    return map->Data().subspan(pos.nPos - 8, end - (pos.nPos - 8));
+}
+
 std::vector<CBlockIndex*> BlockManager::GetAllBlockIndices()
 {
     AssertLockHeld(cs_main);
@@ -328,6 +391,7 @@ bool BlockManager::LoadBlockIndexDB(const Consensus::Params& consensus_params)
 
     // Load block file info
     m_block_tree_db->ReadLastBlockFile(m_last_blockfile);
+    m_block_file_maps.SetActiveFile(m_last_blockfile);
     m_blockfile_info.resize(m_last_blockfile + 1);
     LogPrintf("%s: last block file = %i\n", __func__, m_last_blockfile);
     for (int nFile = 0; nFile <= m_last_blockfile; nFile++) {
@@ -481,23 +545,12 @@ static bool UndoWriteToDisk(const CBlockUndo& blockundo, FlatFilePos& pos, const
     return true;
 }
 
-bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex)
+template <typename Stream>
+static bool UndoReadFromStream(CBlockUndo& blockundo, const CBlockIndex* pindex, Stream& filein)
 {
-    const FlatFilePos pos{WITH_LOCK(::cs_main, return pindex->GetUndoPos())};
-
-    if (pos.IsNull()) {
-        return error("%s: no undo data available", __func__);
-    }
-
-    // Open history file to read
-    CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        return error("%s: OpenUndoFile failed", __func__);
-    }
-
     // Read block
     uint256 hashChecksum;
-    CHashVerifier<CAutoFile> verifier(&filein); // We need a CHashVerifier as reserializing may lose data
+    CHashVerifier<Stream> verifier(&filein); // We need a CHashVerifier as reserializing may lose data
     try {
         verifier << pindex->pprev->GetBlockHash();
         verifier >> blockundo;
@@ -514,6 +567,31 @@ bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex)
     return true;
 }
 
+bool BlockManager::UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex)
+{
+    const FlatFilePos pos{WITH_LOCK(::cs_main, return pindex->GetUndoPos())};
+
+    if (pos.IsNull()) {
+        return error("%s: no undo data available", __func__);
+    }
+
+    // Deserialize straight from the mapped file if possible
+    std::shared_ptr<const MappedFile> map;
+    const auto record{MapRecord(pos, /*undo=*/true, map)};
+    if (!record.empty()) {
+        SpanReader reader{SER_DISK, CLIENT_VERSION, record.subspan(8)};
+        return UndoReadFromStream(blockundo, pindex, reader);
+    }
+
+    // Open history file to read
+    CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull()) {
+        return error("%s: OpenUndoFile failed", __func__);
+    }
+
+    return UndoReadFromStream(blockundo, pindex, filein);
+}
+
 void BlockManager::FlushUndoFile(int block_file, bool finalize)
 {
     FlatFilePos undo_pos_old(block_file, m_blockfile_info[block_file].nUndoSize);
@@ -545,10 +623,12 @@ uint64_t BlockManager::CalculateCurrentUsage()
     return retval;
 }
 
-void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune)
+void BlockManager::UnlinkPrunedFiles(const std::set<int>& setFilesToPrune)
 {
     for (std::set<int>::iterator it = setFilesToPrune.begin(); it != setFilesToPrune.end(); ++it) {
         FlatFilePos pos(*it, 0);
+        m_block_file_maps.Drop(BlockFileSeq().FileName(pos));
+        m_block_file_maps.Drop(UndoFileSeq().FileName(pos));
         fs::remove(BlockFileSeq().FileName(pos));
         fs::remove(UndoFileSeq().FileName(pos));
         LogPrint(BCLog::BLOCKSTORE, "Prune: %s deleted blk/rev (%05u)\n", __func__, *it);
@@ -612,6 +692,7 @@ bool BlockManager::FindBlockPos(FlatFilePos& pos, unsigned int nAddSize, unsigne
         }
         FlushBlockFile(!fKnown, finalize_undo);
         m_last_blockfile = nFile;
+        m_block_file_maps.SetActiveFile(nFile);
     }
 
     m_blockfile_info[nFile].AddBlock(nHeight, nTime);
@@ -711,21 +792,31 @@ bool BlockManager::WriteUndoDataForBlock(const CBlockUndo& blockundo, BlockValid
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams)
+bool BlockManager::ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams)
 {
     block.SetNull();
 
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
-    }
+    // Read block, straight from the mapped file if possible
+    std::shared_ptr<const MappedFile> map;
+    const auto record{MapRecord(pos, /*undo=*/false, map)};
+    if (!record.empty()) {
+        try {
+            SpanReader{SER_DISK, CLIENT_VERSION, record.subspan(8)} >> block;
+        } catch (const std::exception& e) {
+            return error("%s: Deserialize error - %s at %s", __func__, e.what(), pos.ToString());
+        }
+    } else {
+        // Open history file to read
+        CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull()) {
+            return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
+        }
 
-    // Read block
-    try {
-        filein >> block;
-    } catch (const std::exception& e) {
-        return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
+        try {
+            filein >> block;
+        } catch (const std::exception& e) {
+            return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
+        }
     }
 
     // Check the header
@@ -741,7 +832,7 @@ bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::P
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
+bool BlockManager::ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
 {
     const FlatFilePos block_pos{WITH_LOCK(cs_main, return pindex->GetBlockPos())};
 
@@ -755,8 +846,24 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus
     return true;
 }
 
-bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos, const CMessageHeader::MessageStartChars& message_start)
+bool BlockManager::ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos, const CMessageHeader::MessageStartChars& message_start)
 {
+    std::shared_ptr<const MappedFile> map;
+    const auto record{MapRecord(pos, /*undo=*/false, map)};
+    if (!record.empty()) {
+        if (memcmp(record.data(), message_start, CMessageHeader::MESSAGE_START_SIZE)) {
+            return error("%s: Block magic mismatch for %s: %s versus expected %s", __func__, pos.ToString(),
+                         HexStr(record.first(CMessageHeader::MESSAGE_START_SIZE)),
+                         HexStr(message_start));
+        }
+        if (record.size() - 8 > MAX_SIZE) {
+            return error("%s: Block data is larger than maximum deserialization size for %s: %s versus %s", __func__, pos.ToString(),
+                         record.size() - 8, MAX_SIZE);
+        }
+        block.assign(record.begin() + 8, record.end());
+        return true;
+    }
+
     FlatFilePos hpos = pos;
     hpos.nPos -= 8; // Seek back 8 bytes for meta header
     CAutoFile filein(OpenBlockFile(hpos, true), SER_DISK, CLIENT_VERSION);
@@ -898,6 +1005,6 @@ void ThreadImport(ChainstateManager& chainman, std::vector<fs::path> vImportFile
             return;
         }
     } // End scope of CImportingNow
-    chainman.ActiveChainstate().LoadMempool(mempool_path);
+    chainman.ActiveChainstate().LoadMempool(mempool_path, {.skip_script_checks = ShouldSkipPersistedMempoolScripts(args)});
 }
 } // namespace node
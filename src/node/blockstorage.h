@@ -9,12 +9,16 @@
 #include <attributes.h>
 #include <chain.h>
 #include <fs.h>
+#include <kernel/blockmanager_opts.h>
 #include <protocol.h>
+#include <span.h>
 #include <sync.h>
 #include <txdb.h>
 
 #include <atomic>
 #include <cstdint>
+#include <map>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
@@ -29,6 +33,8 @@ class CChain;
 class CChainParams;
 class Chainstate;
 class ChainstateManager;
+class FlatFileSeq;
+class MappedFile;
 struct CCheckpointData;
 struct FlatFilePos;
 namespace Consensus {
@@ -72,6 +78,31 @@ struct PruneLockInfo {
     int height_first{std::numeric_limits<int>::max()}; //! Height of earliest block that should be kept and not pruned
 };
 
+/**
+ * Read-only memory mappings of blk/rev files that the block writer has moved
+ * on from, used instead of stdio reads when -blocksmmap is set.
+ */
+class BlockFileMaps
+{
+private:
+    Mutex m_mutex;
+    std::map<fs::path, std::shared_ptr<const MappedFile>> m_maps GUARDED_BY(m_mutex);
+    //! Number of the block file currently being appended to.
+    int m_active_file GUARDED_BY(m_mutex){0};
+
+public:
+    /**
+     * Return a mapping of the file of seq that holds pos, covering at least
+     * min_size bytes, or nullptr if the file is still being written to or
+     * cannot be mapped.
+     */
+    std::shared_ptr<const MappedFile> Get(const FlatFileSeq& seq, const FlatFilePos& pos, uint64_t min_size) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    void SetActiveFile(int nFile) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    void Drop(const fs::path& path) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
 /**
  * Maintains a tree of blocks (stored in `m_block_index`) which is consulted
  * to determine where the most-work tip is.
@@ -84,7 +115,26 @@ class BlockManager
     friend Chainstate;
     friend ChainstateManager;
 
+public:
+    using Options = kernel::BlockManagerOpts;
+
+    explicit BlockManager(Options opts) : m_opts{std::move(opts)} {}
+
 private:
+    const Options m_opts;
+
+    //! Mappings of finished block files, only used if m_opts.use_mmap is set
+    BlockFileMaps m_block_file_maps;
+
+    /**
+     * Return the record at pos in a mapped blk (or rev, if undo is set) file:
+     * the 8 byte header in front of pos, the serialized object of the size
+     * given in that header, and the checksum behind undo data. Returns an
+     * empty span if the record cannot be read from a mapping or does not lie
+     * within the used part of the file; map keeps the returned span valid.
+     */
+    Span<const unsigned char> MapRecord(const FlatFilePos& pos, bool undo, std::shared_ptr<const MappedFile>& map);
+
     /**
      * Load the blocktree off disk and into memory. Populate certain metadata
      * per index entry (nStatus, nChainWork, nTimeMax, etc.) as well as peripheral
@@ -191,6 +241,18 @@ public:
 
     //! Create or update a prune lock identified by its name
     void UpdatePruneLock(const std::string& name, const PruneLockInfo& lock_info) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
+    /**
+     *  Actually unlink the specified files
+     */
+    void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune);
+
+    /** Functions for disk access for blocks */
+    bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams);
+    bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
+    bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos, const CMessageHeader::MessageStartChars& message_start);
+
+    bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex);
 };
 
 void CleanupBlockRevFiles();
@@ -200,18 +262,6 @@ FILE* OpenBlockFile(const FlatFilePos& pos, bool fReadOnly = false);
 /** Translation to a filesystem path */
 fs::path GetBlockPosFilename(const FlatFilePos& pos);
 
-/**
- *  Actually unlink the specified files
- */
-void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune);
-
-/** Functions for disk access for blocks */
-bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams);
-bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
-bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos, const CMessageHeader::MessageStartChars& message_start);
-
-bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex);
-
 void ThreadImport(ChainstateManager& chainman, std::vector<fs::path> vImportFiles, const ArgsManager& args, const fs::path& mempool_path);
 } // namespace node
 
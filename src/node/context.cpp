@@ -11,6 +11,7 @@
 #include <kernel/context.h>
 #include <net.h>
 #include <net_processing.h>
+#include <node/miner.h>
 #include <netgroup.h>
 #include <policy/fees.h>
 #include <scheduler.h>
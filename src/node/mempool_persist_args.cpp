@@ -16,6 +16,11 @@ bool ShouldPersistMempool(const ArgsManager& argsman)
     return argsman.GetBoolArg("-persistmempool", DEFAULT_PERSIST_MEMPOOL);
 }
 
+bool ShouldSkipPersistedMempoolScripts(const ArgsManager& argsman)
+{
+    return argsman.GetBoolArg("-persistmempoolskipscripts", DEFAULT_PERSIST_MEMPOOL_SKIP_SCRIPTS);
+}
+
 fs::path MempoolPath(const ArgsManager& argsman)
 {
     return argsman.GetDataDirNet() / "mempool.dat";
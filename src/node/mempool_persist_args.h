@@ -17,8 +17,15 @@ namespace node {
  * automatically load the mempool on start and save to disk on shutdown
  */
 static constexpr bool DEFAULT_PERSIST_MEMPOOL{true};
+/**
+ * Default for -persistmempoolskipscripts, indicating whether scripts of
+ * persisted transactions are verified again when loading them on top of the
+ * tip they were saved on
+ */
+static constexpr bool DEFAULT_PERSIST_MEMPOOL_SKIP_SCRIPTS{false};
 
 bool ShouldPersistMempool(const ArgsManager& argsman);
+bool ShouldSkipPersistedMempoolScripts(const ArgsManager& argsman);
 fs::path MempoolPath(const ArgsManager& argsman);
 
 } // namespace node
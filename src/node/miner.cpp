@@ -141,7 +141,11 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     int nDescendantsUpdated = 0;
     if (m_mempool) {
         LOCK(m_mempool->cs);
-        addPackageTxs(*m_mempool, nPackagesSelected, nDescendantsUpdated);
+        if (m_mempool->m_track_clusters) {
+            addChunks(*m_mempool, nPackagesSelected);
+        } else {
+            addPackageTxs(*m_mempool, nPackagesSelected, nDescendantsUpdated);
+        }
     }
 
     int64_t nTime1 = GetTimeMicros();
@@ -432,4 +436,262 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
         nDescendantsUpdated += UpdatePackagesForAdded(mempool, ancestors, mapModifiedTx);
     }
 }
+
+// Every cluster of the mempool comes with its transactions already ordered for
+// mining and grouped into chunks of decreasing feerate, so selecting
+// transactions is a merge of the clusters' chunk lists: always take the
+// highest feerate chunk among the first unselected chunks of all clusters.
+// Nothing has to be recomputed for transactions that depend on the selected
+// ones. If a chunk does not fit, the rest of its cluster is skipped, as its
+// later chunks may depend on it.
+void BlockAssembler::addChunks(const CTxMemPool& mempool, int& nPackagesSelected)
+{
+    AssertLockHeld(mempool.cs);
+
+    struct Candidate {
+        const TxMemPoolCluster* cluster;
+        //! Index of the next chunk to consider and of its first transaction
+        size_t chunk;
+        size_t start;
+    };
+    const auto worse{[](const Candidate& a, const Candidate& b) {
+        const cluster_linearize::Chunk& chunk_a{a.cluster->chunks[a.chunk]};
+        const cluster_linearize::Chunk& chunk_b{b.cluster->chunks[b.chunk]};
+        return cluster_linearize::HigherFeerate(chunk_b.fee, chunk_b.size, chunk_a.fee, chunk_a.size);
+    }};
+    std::vector<Candidate> heap;
+    heap.reserve(mempool.GetClusters().size());
+    for (const auto& cluster : mempool.GetClusters()) {
+        heap.push_back({cluster.get(), 0, 0});
+    }
+    std::make_heap(heap.begin(), heap.end(), worse);
+
+    // See addPackageTxs().
+    const int64_t MAX_CONSECUTIVE_FAILURES = 1000;
+    int64_t nConsecutiveFailed = 0;
+
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), worse);
+        const Candidate candidate{heap.back()};
+        heap.pop_back();
+        const cluster_linearize::Chunk& chunk{candidate.cluster->chunks[candidate.chunk]};
+
+        if (chunk.fee < blockMinFeeRate.GetFee(chunk.size)) {
+            // Everything else we might consider has a lower fee rate
+            return;
+        }
+
+        CTxMemPool::setEntries package;
+        int64_t packageSigOpsCost{0};
+        for (size_t i = candidate.start; i < candidate.start + chunk.count; ++i) {
+            const CTxMemPool::txiter it{mempool.mapTx.iterator_to(*candidate.cluster->txs[i])};
+            package.insert(it);
+            packageSigOpsCost += it->GetSigOpCost();
+        }
+
+        if (!TestPackage(chunk.size, packageSigOpsCost)) {
+            ++nConsecutiveFailed;
+            if (nConsecutiveFailed > MAX_CONSECUTIVE_FAILURES && nBlockWeight >
+                    nBlockMaxWeight - 4000) {
+                // Give up if we're close to full and haven't succeeded in a while
+                break;
+            }
+            continue;
+        }
+
+        if (!TestPackageTransactions(package)) {
+            continue;
+        }
+
+        nConsecutiveFailed = 0;
+
+        // The linearization is a valid order to appear in a block.
+        for (size_t i = candidate.start; i < candidate.start + chunk.count; ++i) {
+            AddToBlock(mempool.mapTx.iterator_to(*candidate.cluster->txs[i]));
+        }
+        ++nPackagesSelected;
+
+        if (candidate.chunk + 1 < candidate.cluster->chunks.size()) {
+            heap.push_back({candidate.cluster, candidate.chunk + 1, candidate.start + chunk.count});
+            std::push_heap(heap.begin(), heap.end(), worse);
+        }
+    }
+}
+
+BlockTemplateCache::BlockTemplateCache(ChainstateManager& chainman, const CTxMemPool& mempool, const CScript& script_pub_key)
+    : m_chainman{chainman},
+      m_mempool{mempool},
+      m_script_pub_key{script_pub_key},
+      m_options{DefaultOptions()},
+      // Same limits as BlockAssembler
+      m_block_max_weight{std::max<size_t>(4000, std::min<size_t>(MAX_BLOCK_WEIGHT - 4000, m_options.nBlockMaxWeight))}
+{
+}
+
+bool BlockTemplateCache::NeedsRebuild() const
+{
+    return m_template && m_stale && GetTime<std::chrono::seconds>() - m_last_build >= BLOCK_TEMPLATE_REBUILD_INTERVAL;
+}
+
+void BlockTemplateCache::Rebuild()
+{
+    AssertLockHeld(::cs_main);
+    Chainstate& chainstate{m_chainman.ActiveChainstate()};
+    m_template = BlockAssembler{chainstate, &m_mempool, m_options}.CreateNewBlock(m_script_pub_key);
+    m_snapshot.reset();
+    m_prev = chainstate.m_chain.Tip();
+    m_lock_time_cutoff = m_prev->GetMedianTimePast();
+
+    // Space reserved for the coinbase, like BlockAssembler::resetBlock()
+    m_block_weight = 4000;
+    m_block_sigops_cost = 400;
+    m_fees = 0;
+    m_txids.clear();
+    const CBlock& block{m_template->block};
+    for (size_t i = 1; i < block.vtx.size(); ++i) {
+        m_txids.insert(block.vtx[i]->GetHash());
+        m_block_weight += GetTransactionWeight(*block.vtx[i]);
+        m_block_sigops_cost += m_template->vTxSigOpsCost[i];
+        m_fees += m_template->vTxFees[i];
+    }
+    m_stale = false;
+    m_last_build = GetTime<std::chrono::seconds>();
+}
+
+void BlockTemplateCache::TryRebuild()
+{
+    try {
+        Rebuild();
+    } catch (const std::runtime_error& e) {
+        LogPrintf("%s: %s\n", __func__, e.what());
+        m_template.reset();
+        m_snapshot.reset();
+    }
+}
+
+void BlockTemplateCache::MaybeRebuild()
+{
+    if (!WITH_LOCK(m_mutex, return NeedsRebuild())) return;
+    LOCK2(::cs_main, m_mutex);
+    if (NeedsRebuild()) TryRebuild();
+}
+
+std::shared_ptr<const CBlockTemplate> BlockTemplateCache::Get()
+{
+    LOCK2(::cs_main, m_mutex);
+    if (!m_template || m_prev != m_chainman.ActiveChain().Tip() || NeedsRebuild()) {
+        Rebuild();
+    }
+    if (m_snapshot) return m_snapshot;
+
+    auto snapshot{std::make_shared<CBlockTemplate>(*m_template)};
+    CBlock& block{snapshot->block};
+    const int height{m_prev->nHeight + 1};
+    CMutableTransaction coinbaseTx;
+    coinbaseTx.vin.resize(1);
+    coinbaseTx.vin[0].prevout.SetNull();
+    coinbaseTx.vout.resize(1);
+    coinbaseTx.vout[0].scriptPubKey = m_script_pub_key;
+    coinbaseTx.vout[0].nValue = m_fees + GetBlockSubsidy(height, m_chainman.GetParams().GetConsensus());
+    coinbaseTx.vin[0].scriptSig = CScript() << height << OP_0;
+    block.vtx[0] = MakeTransactionRef(std::move(coinbaseTx));
+    snapshot->vchCoinbaseCommitment = m_chainman.GenerateCoinbaseCommitment(block, m_prev);
+    snapshot->vTxFees[0] = -m_fees;
+    snapshot->vTxSigOpsCost[0] = WITNESS_SCALE_FACTOR * GetLegacySigOpCount(*block.vtx[0]);
+    m_snapshot = std::move(snapshot);
+    return m_snapshot;
+}
+
+void BlockTemplateCache::UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload)
+{
+    if (fInitialDownload) {
+        // Nobody mines on a chain that is still syncing; build on demand only.
+        LOCK(m_mutex);
+        m_template.reset();
+        m_snapshot.reset();
+        return;
+    }
+    LOCK2(::cs_main, m_mutex);
+    TryRebuild();
+}
+
+void BlockTemplateCache::TransactionAddedToMempool(const CTransactionRef& tx, uint64_t mempool_sequence)
+{
+    {
+        LOCK(m_mutex);
+        if (!m_template || m_txids.count(tx->GetHash())) return;
+
+        LOCK(m_mempool.cs);
+        // The transaction may have been removed again already, in which case
+        // there is nothing to do.
+        const auto it{m_mempool.GetIter(tx->GetHash())};
+        if (!it) return;
+        const CTxMemPoolEntry& entry{**it};
+        for (const CTxIn& txin : tx->vin) {
+            if (m_mempool.exists(GenTxid::Txid(txin.prevout.hash)) && !m_txids.count(txin.prevout.hash)) {
+                // The parent was left out, but may be worth including along with its child.
+                m_stale = true;
+                return;
+            }
+        }
+        if (entry.GetModifiedFee() < m_options.blockMinFeeRate.GetFee(entry.GetTxSize())) return;
+        if (!IsFinalTx(*tx, m_prev->nHeight + 1, m_lock_time_cutoff)) return;
+        // Same limits as BlockAssembler::TestPackage()
+        if (m_block_weight + WITNESS_SCALE_FACTOR * entry.GetTxSize() >= m_block_max_weight ||
+            m_block_sigops_cost + entry.GetSigOpCost() >= MAX_BLOCK_SIGOPS_COST) {
+            m_stale = true;
+            return;
+        }
+
+        m_template->block.vtx.emplace_back(entry.GetSharedTx());
+        m_template->vTxFees.push_back(entry.GetFee());
+        m_template->vTxSigOpsCost.push_back(entry.GetSigOpCost());
+        m_block_weight += entry.GetTxWeight();
+        m_block_sigops_cost += entry.GetSigOpCost();
+        m_fees += entry.GetFee();
+        m_txids.insert(tx->GetHash());
+        m_snapshot.reset();
+    }
+    MaybeRebuild();
+}
+
+void BlockTemplateCache::TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence)
+{
+    // Transactions removed for a block are followed by a new tip, for which
+    // the template is rebuilt anyway.
+    if (reason == MemPoolRemovalReason::BLOCK) return;
+    {
+        LOCK(m_mutex);
+        if (!m_template || !m_txids.count(tx->GetHash())) return;
+
+        // Remove the transaction and everything in the template that spends it.
+        std::set<uint256> removed{tx->GetHash()};
+        std::vector<CTransactionRef>& vtx{m_template->block.vtx};
+        size_t kept{1};
+        for (size_t i = 1; i < vtx.size(); ++i) {
+            const CTransaction& block_tx{*vtx[i]};
+            const bool remove{removed.count(block_tx.GetHash()) ||
+                              std::any_of(block_tx.vin.begin(), block_tx.vin.end(), [&](const CTxIn& txin) { return removed.count(txin.prevout.hash); })};
+            if (remove) {
+                removed.insert(block_tx.GetHash());
+                m_txids.erase(block_tx.GetHash());
+                m_block_weight -= GetTransactionWeight(block_tx);
+                m_block_sigops_cost -= m_template->vTxSigOpsCost[i];
+                m_fees -= m_template->vTxFees[i];
+                continue;
+            }
+            vtx[kept] = std::move(vtx[i]);
+            m_template->vTxFees[kept] = m_template->vTxFees[i];
+            m_template->vTxSigOpsCost[kept] = m_template->vTxSigOpsCost[i];
+            ++kept;
+        }
+        vtx.resize(kept);
+        m_template->vTxFees.resize(kept);
+        m_template->vTxSigOpsCost.resize(kept);
+        m_snapshot.reset();
+        // The space freed up may fit transactions that were left out.
+        m_stale = true;
+    }
+    MaybeRebuild();
+}
 } // namespace node
@@ -8,10 +8,14 @@
 #define KOYOTECOIN_NODE_MINER_H
 
 #include <primitives/block.h>
+#include <script/script.h>
+#include <sync.h>
 #include <txmempool.h>
+#include <validationinterface.h>
 
 #include <memory>
 #include <optional>
+#include <set>
 #include <stdint.h>
 
 #include <boost/multi_index/ordered_index.hpp>
@@ -26,6 +30,9 @@ namespace Consensus { struct Params; };
 
 namespace node {
 static const bool DEFAULT_PRINTPRIORITY = false;
+static const bool DEFAULT_BLOCK_TEMPLATE_CACHE = false;
+//! Minimum time between rebuilds of a cached template that missed transactions
+static constexpr std::chrono::seconds BLOCK_TEMPLATE_REBUILD_INTERVAL{5};
 
 struct CBlockTemplate
 {
@@ -179,6 +186,10 @@ private:
       * Increments nPackagesSelected / nDescendantsUpdated with corresponding
       * statistics from the package selection (for logging statistics). */
     void addPackageTxs(const CTxMemPool& mempool, int& nPackagesSelected, int& nDescendantsUpdated) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
+    /** Add transactions by merging the linearized clusters of the mempool
+      * chunk by chunk, best chunk first. Increments nPackagesSelected with the
+      * number of chunks selected. */
+    void addChunks(const CTxMemPool& mempool, int& nPackagesSelected) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
 
     // helper functions for addPackageTxs()
     /** Remove confirmed (inBlock) entries from given set */
@@ -198,6 +209,70 @@ int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParam
 
 /** Update an old GenerateCoinbaseCommitment from CreateNewBlock after the block txs have changed */
 void RegenerateCommitments(CBlock& block, ChainstateManager& chainman);
+
+/**
+ * Keeps a block template for the current tip up to date as transactions enter
+ * and leave the mempool, so that getblocktemplate doesn't need to run
+ * BlockAssembler on every call.
+ *
+ * Transactions added to the mempool are appended to the template when they fit
+ * and all their unconfirmed parents are in it already. Transactions leaving
+ * the mempool are removed from the template together with their descendants.
+ * A transaction that cannot be appended (because the block is full or a
+ * parent is missing) marks the template as stale: it is then rebuilt from
+ * scratch, but at most once every BLOCK_TEMPLATE_REBUILD_INTERVAL, like
+ * getblocktemplate did before. A new tip always causes a rebuild.
+ *
+ * Fee deltas from prioritisetransaction only take effect on the next rebuild.
+ */
+class BlockTemplateCache final : public CValidationInterface
+{
+public:
+    BlockTemplateCache(ChainstateManager& chainman, const CTxMemPool& mempool, const CScript& script_pub_key);
+
+    /**
+     * Return the template for the current tip, rebuilding it first if there
+     * is none or it is stale. Mempool updates that are still queued for the
+     * validation interface are not reflected yet.
+     */
+    std::shared_ptr<const CBlockTemplate> Get() LOCKS_EXCLUDED(m_mutex);
+
+protected:
+    void UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload) override LOCKS_EXCLUDED(m_mutex);
+    void TransactionAddedToMempool(const CTransactionRef& tx, uint64_t mempool_sequence) override LOCKS_EXCLUDED(m_mutex);
+    void TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence) override LOCKS_EXCLUDED(m_mutex);
+
+private:
+    ChainstateManager& m_chainman;
+    const CTxMemPool& m_mempool;
+    const CScript m_script_pub_key;
+    const BlockAssembler::Options m_options;
+    const uint64_t m_block_max_weight;
+
+    //! Lock order: cs_main, m_mutex, mempool.cs
+    Mutex m_mutex;
+    //! Template being updated; its coinbase is only filled in by Get()
+    std::unique_ptr<CBlockTemplate> m_template GUARDED_BY(m_mutex);
+    //! Copy of m_template with its coinbase, handed out until m_template changes
+    std::shared_ptr<const CBlockTemplate> m_snapshot GUARDED_BY(m_mutex);
+    const CBlockIndex* m_prev GUARDED_BY(m_mutex){nullptr};
+    int64_t m_lock_time_cutoff GUARDED_BY(m_mutex){0};
+    std::set<uint256> m_txids GUARDED_BY(m_mutex);
+    uint64_t m_block_weight GUARDED_BY(m_mutex){0};
+    int64_t m_block_sigops_cost GUARDED_BY(m_mutex){0};
+    CAmount m_fees GUARDED_BY(m_mutex){0};
+    //! Whether a rebuild may produce a better template
+    bool m_stale GUARDED_BY(m_mutex){false};
+    std::chrono::seconds m_last_build GUARDED_BY(m_mutex){0};
+
+    /** Build a new template for the current tip. */
+    void Rebuild() EXCLUSIVE_LOCKS_REQUIRED(::cs_main, m_mutex);
+    /** Rebuild(), dropping the template if that fails, for use from validation interface callbacks. */
+    void TryRebuild() EXCLUSIVE_LOCKS_REQUIRED(::cs_main, m_mutex);
+    /** Rebuild the template if it is stale and the last build is old enough. */
+    void MaybeRebuild() LOCKS_EXCLUDED(m_mutex);
+    bool NeedsRebuild() const EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+};
 } // namespace node
 
 #endif // KOYOTECOIN_NODE_MINER_H
@@ -10,7 +10,24 @@
 #include <uint256.h>
 #include <serialize.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <ios>
+#include <iterator>
+
 namespace node {
+//! Bytes a snapshot file in a versioned format starts with. Unversioned
+//! snapshots start with the base block hash instead.
+static constexpr unsigned char SNAPSHOT_MAGIC_BYTES[]{'u', 't', 'x', 'o', 0xff};
+//! The base block hash and coin count, followed by the coins
+static constexpr uint16_t SNAPSHOT_VERSION_UNCHUNKED{1};
+//! Chunks of coins, each with a header carrying its own checksum, followed
+//! by an index of where the chunks start
+static constexpr uint16_t SNAPSHOT_VERSION{2};
+
+//! Maximum number of coins in a chunk of a snapshot
+static constexpr uint32_t SNAPSHOT_CHUNK_MAX_COINS{4096};
+
 //! Metadata describing a serialized version of a UTXO set from which an
 //! assumeutxo Chainstate can be constructed.
 class SnapshotMetadata
@@ -24,6 +41,16 @@ public:
     //! during snapshot load to estimate progress of UTXO set reconstruction.
     uint64_t m_coins_count = 0;
 
+    uint16_t m_version{SNAPSHOT_VERSION};
+
+    //! The number of chunks the coins are split into. Only in chunked snapshots.
+    uint64_t m_chunk_count{0};
+
+    //! Where in the file the chunk index starts, right after the last chunk.
+    //! The index holds the offset of every chunk, as a fixed-width uint64.
+    //! Only in chunked snapshots.
+    uint64_t m_index_offset{0};
+
     SnapshotMetadata() { }
     SnapshotMetadata(
         const uint256& base_blockhash,
@@ -32,8 +59,54 @@ public:
             m_base_blockhash(base_blockhash),
             m_coins_count(coins_count) { }
 
-    SERIALIZE_METHODS(SnapshotMetadata, obj) { READWRITE(obj.m_base_blockhash, obj.m_coins_count); }
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        if (m_version == SNAPSHOT_VERSION_UNCHUNKED) {
+            s << m_base_blockhash << m_coins_count;
+            return;
+        }
+        s << SNAPSHOT_MAGIC_BYTES << m_version << m_base_blockhash << m_coins_count << m_chunk_count << m_index_offset;
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        unsigned char magic[std::size(SNAPSHOT_MAGIC_BYTES)];
+        s >> magic;
+        if (!std::equal(std::begin(magic), std::end(magic), std::begin(SNAPSHOT_MAGIC_BYTES))) {
+            // The start of an unversioned snapshot's base block hash
+            m_version = SNAPSHOT_VERSION_UNCHUNKED;
+            std::copy(std::begin(magic), std::end(magic), m_base_blockhash.begin());
+            Span<unsigned char> rest{m_base_blockhash.begin() + std::size(magic), m_base_blockhash.end()};
+            s >> rest >> m_coins_count;
+            m_chunk_count = 0;
+            m_index_offset = 0;
+            return;
+        }
+        s >> m_version;
+        if (m_version != SNAPSHOT_VERSION) {
+            throw std::ios_base::failure("unsupported snapshot version");
+        }
+        s >> m_base_blockhash >> m_coins_count >> m_chunk_count >> m_index_offset;
+    }
+};
+
+//! Serialized size of the metadata of a chunked snapshot, where its first chunk starts
+static constexpr uint64_t SNAPSHOT_METADATA_SIZE{std::size(SNAPSHOT_MAGIC_BYTES) + sizeof(uint16_t) + sizeof(uint256) + 3 * sizeof(uint64_t)};
+
+/** Precedes the coins of a chunk in a chunked snapshot. */
+struct SnapshotChunkHeader {
+    uint32_t coins_count;
+    uint32_t size;
+    //! Hash of the serialized coins
+    uint256 checksum;
+
+    SERIALIZE_METHODS(SnapshotChunkHeader, obj) { READWRITE(obj.coins_count, obj.size, obj.checksum); }
 };
+
+//! Serialized size of a chunk header
+static constexpr uint64_t SNAPSHOT_CHUNK_HEADER_SIZE{2 * sizeof(uint32_t) + sizeof(uint256)};
 } // namespace node
 
 #endif // KOYOTECOIN_NODE_UTXO_SNAPSHOT_H
@@ -669,6 +669,8 @@ void CBlockPolicyEstimator::processBlock(unsigned int nBlockHeight,
 
     trackedTxs = 0;
     untrackedTxs = 0;
+
+    InvalidateSmartFeeCache();
 }
 
 CFeeRate CBlockPolicyEstimator::estimateFee(int confTarget) const
@@ -826,8 +828,37 @@ double CBlockPolicyEstimator::estimateConservativeFee(unsigned int doubleTarget,
  */
 CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const
 {
+    const std::pair<int, bool> key{confTarget, conservative};
+    if (const auto cache{std::atomic_load(&m_smart_fee_cache)}) {
+        const auto it{cache->find(key)};
+        if (it != cache->end()) {
+            if (feeCalc) *feeCalc = it->second.calc;
+            return it->second.feerate;
+        }
+    }
+
     LOCK(m_cs_fee_estimator);
+    SmartFeeEstimate estimate;
+    estimate.feerate = _estimateSmartFee(confTarget, &estimate.calc, conservative);
+    if (feeCalc) *feeCalc = estimate.calc;
+
+    // Only cache the targets that are tracked, so that the cache size stays bounded.
+    if (confTarget > 0 && (unsigned int)confTarget <= longStats->GetMaxConfirms()) {
+        auto cache{std::make_shared<SmartFeeCache>()};
+        if (const auto old_cache{std::atomic_load(&m_smart_fee_cache)}) *cache = *old_cache;
+        cache->emplace(key, estimate);
+        std::atomic_store(&m_smart_fee_cache, std::shared_ptr<const SmartFeeCache>{std::move(cache)});
+    }
+    return estimate.feerate;
+}
 
+void CBlockPolicyEstimator::InvalidateSmartFeeCache() const
+{
+    std::atomic_store(&m_smart_fee_cache, std::shared_ptr<const SmartFeeCache>{});
+}
+
+CFeeRate CBlockPolicyEstimator::_estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const
+{
     if (feeCalc) {
         feeCalc->desiredTarget = confTarget;
         feeCalc->returnedTarget = confTarget;
@@ -989,6 +1020,7 @@ bool CBlockPolicyEstimator::Read(AutoFile& filein)
             nBestSeenHeight = nFileBestSeenHeight;
             historicalFirst = nFileHistoricalFirst;
             historicalBest = nFileHistoricalBest;
+            InvalidateSmartFeeCache();
         }
     }
     catch (const std::exception& e) {
@@ -1007,6 +1039,7 @@ void CBlockPolicyEstimator::FlushUnconfirmed() {
         auto mi = mapMemPoolTxs.begin();
         _removeTx(mi->first, false); // this calls erase() on mapMemPoolTxs
     }
+    InvalidateSmartFeeCache();
     int64_t endclear = GetTimeMicros();
     LogPrint(BCLog::ESTIMATEFEE, "Recorded %u unconfirmed txs from mempool in %gs\n", num_entries, (endclear - startclear)*0.000001);
 }
@@ -1022,8 +1055,9 @@ FeeFilterRounder::FeeFilterRounder(const CFeeRate& minIncrementalFee)
 
 CAmount FeeFilterRounder::round(CAmount currentMinFee)
 {
+    AssertLockNotHeld(m_insecure_rand_mutex);
     std::set<double>::iterator it = feeset.lower_bound(currentMinFee);
-    if ((it != feeset.begin() && insecure_rand.rand32() % 3 != 0) || it == feeset.end()) {
+    if ((it != feeset.begin() && WITH_LOCK(m_insecure_rand_mutex, return insecure_rand.rand32()) % 3 != 0) || it == feeset.end()) {
         it--;
     }
     return static_cast<CAmount>(*it);
@@ -19,6 +19,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 class AutoFile;
@@ -286,6 +287,33 @@ private:
     /** A non-thread-safe helper for the removeTx function */
     bool _removeTx(const uint256& hash, bool inBlock)
         EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
+
+    /** A non-thread-safe helper for the estimateSmartFee function */
+    CFeeRate _estimateSmartFee(int confTarget, FeeCalculation* feeCalc, bool conservative) const
+        EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
+
+    /** Drop the cached smart fee estimates, after the data they were computed from changed */
+    void InvalidateSmartFeeCache() const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
+
+    struct SmartFeeEstimate
+    {
+        CFeeRate feerate;
+        FeeCalculation calc;
+    };
+    using SmartFeeCache = std::map<std::pair<int, bool>, SmartFeeEstimate>;
+
+    /**
+     * Smart fee estimates computed since the last block, by target and
+     * conservative flag. The estimates only change meaningfully when a block
+     * is processed: transactions that entered the mempool since then have
+     * not waited long enough to count towards any target.
+     *
+     * The map is never modified once published. It is replaced with
+     * std::atomic_store while holding m_cs_fee_estimator and read with
+     * std::atomic_load without it, so that cache hits do not contend with
+     * processTransaction and processBlock.
+     */
+    mutable std::shared_ptr<const SmartFeeCache> m_smart_fee_cache;
 };
 
 class FeeFilterRounder
@@ -302,12 +330,14 @@ public:
     /** Create new FeeFilterRounder */
     explicit FeeFilterRounder(const CFeeRate& minIncrementalFee);
 
-    /** Quantize a minimum fee for privacy purpose before broadcast. Not thread-safe due to use of FastRandomContext */
-    CAmount round(CAmount currentMinFee);
+    /** Quantize a minimum fee for privacy purpose before broadcast. */
+    CAmount round(CAmount currentMinFee) EXCLUSIVE_LOCKS_REQUIRED(!m_insecure_rand_mutex);
 
 private:
     std::set<double> feeset;
-    FastRandomContext insecure_rand;
+    //! Message handler threads may round fees concurrently.
+    Mutex m_insecure_rand_mutex;
+    FastRandomContext insecure_rand GUARDED_BY(m_insecure_rand_mutex);
 };
 
 #endif // KOYOTECOIN_POLICY_FEES_H
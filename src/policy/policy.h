@@ -64,6 +64,10 @@ static constexpr unsigned int DEFAULT_ANCESTOR_SIZE_LIMIT_KVB{101};
 static constexpr unsigned int DEFAULT_DESCENDANT_LIMIT{25};
 /** Default for -limitdescendantsize, maximum kilobytes of in-mempool descendants */
 static constexpr unsigned int DEFAULT_DESCENDANT_SIZE_LIMIT_KVB{101};
+/** Default for -limitclustercount, max number of transactions in a cluster, if the mempool tracks clusters */
+static constexpr unsigned int DEFAULT_CLUSTER_LIMIT{100};
+/** Default for -limitclustersize, maximum kilobytes of a cluster, if the mempool tracks clusters */
+static constexpr unsigned int DEFAULT_CLUSTER_SIZE_LIMIT_KVB{101};
 /**
  * An extra transaction can be added to a package, as long as it only has one
  * ancestor and is no larger than this. Not really any reason to make this
@@ -49,18 +49,25 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
+#include <cstdio>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <thread>
 
 using kernel::CCoinsStats;
 using kernel::CoinStatsHashType;
 
 using node::BlockManager;
 using node::NodeContext;
-using node::ReadBlockFromDisk;
+using node::SNAPSHOT_CHUNK_HEADER_SIZE;
+using node::SNAPSHOT_CHUNK_MAX_COINS;
+using node::SNAPSHOT_METADATA_SIZE;
+using node::SnapshotChunkHeader;
 using node::SnapshotMetadata;
-using node::UndoReadFromDisk;
 
 struct CUpdatedBlock
 {
@@ -182,7 +189,7 @@ UniValue blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIn
         case TxVerbosity::SHOW_DETAILS:
         case TxVerbosity::SHOW_DETAILS_AND_PREVOUT:
             CBlockUndo blockUndo;
-            const bool have_undo{WITH_LOCK(::cs_main, return !blockman.IsBlockPruned(blockindex) && UndoReadFromDisk(blockUndo, blockindex))};
+            const bool have_undo{WITH_LOCK(::cs_main, return !blockman.IsBlockPruned(blockindex) && blockman.UndoReadFromDisk(blockUndo, blockindex))};
 
             for (size_t i = 0; i < block.vtx.size(); ++i) {
                 const CTransactionRef& tx = block.vtx.at(i);
@@ -580,7 +587,7 @@ static CBlock GetBlockChecked(BlockManager& blockman, const CBlockIndex* pblocki
         throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
     }
 
-    if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus())) {
+    if (!blockman.ReadBlockFromDisk(block, pblockindex, Params().GetConsensus())) {
         // Block not found on disk. This could be because we have the block
         // header in our index but not yet have the block or did not accept the
         // block.
@@ -598,7 +605,7 @@ static CBlockUndo GetUndoChecked(BlockManager& blockman, const CBlockIndex* pblo
         throw JSONRPCError(RPC_MISC_ERROR, "Undo data not available (pruned data)");
     }
 
-    if (!UndoReadFromDisk(blockUndo, pblockindex)) {
+    if (!blockman.UndoReadFromDisk(blockUndo, pblockindex)) {
         throw JSONRPCError(RPC_MISC_ERROR, "Can't read undo data from disk");
     }
 
@@ -2275,7 +2282,8 @@ static RPCHelpMan dumptxoutset()
 {
     return RPCHelpMan{
         "dumptxoutset",
-        "Write the serialized UTXO set to disk.",
+        "Write the serialized UTXO set to disk. Several threads dump the coins in chunks, each with\n"
+        "its own checksum, which are followed by an index of where the chunks start.",
         {
             {"path", RPCArg::Type::STR, RPCArg::Optional::NO, "Path to the output file. If relative, will be prefixed by datadir."},
         },
@@ -2283,6 +2291,7 @@ static RPCHelpMan dumptxoutset()
             RPCResult::Type::OBJ, "", "",
                 {
                     {RPCResult::Type::NUM, "coins_written", "the number of coins written in the snapshot"},
+                    {RPCResult::Type::NUM, "chunks", "the number of chunks the coins were written in"},
                     {RPCResult::Type::STR_HEX, "base_hash", "the hash of the base of the snapshot"},
                     {RPCResult::Type::NUM, "base_height", "the height of the base of the snapshot"},
                     {RPCResult::Type::STR, "path", "the absolute path that the snapshot was written to"},
@@ -2327,6 +2336,84 @@ static RPCHelpMan dumptxoutset()
     };
 }
 
+static RPCHelpMan loadtxoutset()
+{
+    return RPCHelpMan{
+        "loadtxoutset",
+        "Load the serialized UTXO set from disk, as written by dumptxoutset, into a new chainstate\n"
+        "that becomes the active one. The snapshot must be based on a block whose header is known\n"
+        "and whose UTXO set hash is committed to in the chain parameters (assumeutxo).",
+        {
+            {"path", RPCArg::Type::STR, RPCArg::Optional::NO, "Path to the snapshot file. If relative, will be prefixed by datadir."},
+        },
+        RPCResult{
+            RPCResult::Type::OBJ, "", "",
+                {
+                    {RPCResult::Type::NUM, "coins_loaded", "the number of coins loaded from the snapshot"},
+                    {RPCResult::Type::STR_HEX, "tip_hash", "the hash of the base of the snapshot"},
+                    {RPCResult::Type::NUM, "base_height", "the height of the base of the snapshot"},
+                    {RPCResult::Type::STR, "path", "the absolute path that the snapshot was loaded from"},
+                }
+        },
+        RPCExamples{
+            HelpExampleCli("loadtxoutset", "utxo.dat")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    NodeContext& node = EnsureAnyNodeContext(request.context);
+    ChainstateManager& chainman = EnsureChainman(node);
+    const fs::path path = fsbridge::AbsPathJoin(EnsureArgsman(node).GetDataDirNet(), fs::u8path(request.params[0].get_str()));
+
+    FILE* file{fsbridge::fopen(path, "rb")};
+    AutoFile afile{file};
+    if (afile.IsNull()) {
+        throw JSONRPCError(
+            RPC_INVALID_PARAMETER,
+            "Couldn't open file " + path.u8string() + " for reading.");
+    }
+
+    SnapshotMetadata metadata;
+    try {
+        afile >> metadata;
+    } catch (const std::ios_base::failure&) {
+        throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "Couldn't read snapshot metadata from " + path.u8string());
+    }
+
+    const CBlockIndex* base{WITH_LOCK(::cs_main, return chainman.m_blockman.LookupBlockIndex(metadata.m_base_blockhash))};
+    if (!base) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block header of the snapshot base " + metadata.m_base_blockhash.ToString() + " not found");
+    }
+    if (!ExpectedAssumeutxo(base->nHeight, chainman.GetParams())) {
+        throw JSONRPCError(RPC_MISC_ERROR, strprintf("No assumeutxo commitment for snapshots at height %d", base->nHeight));
+    }
+
+    if (!chainman.ActivateSnapshot(afile, metadata, /*in_memory=*/false)) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to load UTXO snapshot " + path.u8string() + ", see debug log for details");
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("coins_loaded", metadata.m_coins_count);
+    result.pushKV("tip_hash", base->GetBlockHash().ToString());
+    result.pushKV("base_height", base->nHeight);
+    result.pushKV("path", path.u8string());
+    return result;
+},
+    };
+}
+
+//! Coins expected in each of the txid ranges a UTXO snapshot is dumped in.
+//! A few ranges per core are dumped at a time and then written in order, so
+//! this bounds what is buffered.
+static constexpr uint64_t SNAPSHOT_DUMP_RANGE_COINS{16384};
+
+namespace {
+/** A chunk of a UTXO snapshot that is dumped but not written yet. */
+struct DumpedChunk {
+    SnapshotChunkHeader header{};
+    CDataStream data{SER_DISK, CLIENT_VERSION};
+};
+} // namespace
+
 UniValue CreateUTXOSnapshot(
     NodeContext& node,
     Chainstate& chainstate,
@@ -2334,19 +2421,20 @@ UniValue CreateUTXOSnapshot(
     const fs::path& path,
     const fs::path& temppath)
 {
-    std::unique_ptr<CCoinsViewCursor> pcursor;
+    const size_t num_threads{size_t(std::max(GetNumCores(), 1))};
+    std::vector<std::unique_ptr<CCoinsViewDBCursor>> cursors;
     std::optional<CCoinsStats> maybe_stats;
     const CBlockIndex* tip;
 
     {
         // We need to lock cs_main to ensure that the coinsdb isn't written to
         // between (i) flushing coins cache to disk (coinsdb), (ii) getting stats
-        // based upon the coinsdb, and (iii) constructing a cursor to the
+        // based upon the coinsdb, and (iii) constructing the cursors to the
         // coinsdb for use below this block.
         //
         // Cursors returned by leveldb iterate over snapshots, so the contents
-        // of the pcursor will not be affected by simultaneous writes during
-        // use below this block.
+        // of the cursors will not be affected by simultaneous writes during
+        // use below this block, and they all see the same coins.
         //
         LOCK(::cs_main);
 
@@ -2357,7 +2445,10 @@ UniValue CreateUTXOSnapshot(
             throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
         }
 
-        pcursor = chainstate.CoinsDB().Cursor();
+        // One for every thread dumping coins
+        for (size_t i = 0; i < num_threads; ++i) {
+            cursors.push_back(chainstate.CoinsDB().SeekableCursor());
+        }
         tip = CHECK_NONFATAL(chainstate.m_blockman.LookupBlockIndex(maybe_stats->hashBlock));
     }
 
@@ -2367,27 +2458,95 @@ UniValue CreateUTXOSnapshot(
 
     SnapshotMetadata metadata{tip->GetBlockHash(), maybe_stats->coins_count, tip->nChainTx};
 
+    // The chunk count and the index offset are filled in at the end.
     afile << metadata;
 
-    COutPoint key;
-    Coin coin;
-    unsigned int iter{0};
-
-    while (pcursor->Valid()) {
-        if (iter % 5000 == 0) node.rpc_interruption_point();
-        ++iter;
-        if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
-            afile << key;
-            afile << coin;
+    // Txids are hashes, so splitting them by their first bits gives ranges of
+    // about the same number of coins. The ranges follow the database order,
+    // and so does the snapshot. They only depend on the number of coins, so
+    // the snapshot doesn't depend on the number of threads dumping it.
+    unsigned int range_bits{0};
+    while (range_bits < 16 && (maybe_stats->coins_count >> (range_bits + 1)) >= SNAPSHOT_DUMP_RANGE_COINS) {
+        ++range_bits;
+    }
+    const uint32_t num_ranges{uint32_t{1} << range_bits};
+    const auto range_of{[range_bits](const uint256& txid) {
+        return uint32_t(txid.begin()[0] << 8 | txid.begin()[1]) >> (16 - range_bits);
+    }};
+
+    std::vector<uint64_t> chunk_offsets;
+    uint64_t offset{SNAPSHOT_METADATA_SIZE};
+    uint64_t coins_written{0};
+    std::vector<std::vector<DumpedChunk>> ranges;
+    for (uint32_t first_range = 0; first_range < num_ranges; first_range += ranges.size()) {
+        node.rpc_interruption_point();
+
+        ranges.clear();
+        ranges.resize(std::min<size_t>(num_ranges - first_range, 4 * num_threads));
+        std::atomic<size_t> next{0};
+        const auto work{[&](CCoinsViewDBCursor& cursor) {
+            COutPoint key;
+            Coin coin;
+            for (size_t i; (i = next++) < ranges.size();) {
+                const uint32_t range{first_range + uint32_t(i)};
+                std::vector<DumpedChunk>& chunks{ranges[i]};
+                uint256 start;
+                const uint32_t prefix{range << (16 - range_bits)};
+                start.begin()[0] = prefix >> 8;
+                start.begin()[1] = prefix & 0xff;
+                for (cursor.Seek(COutPoint{start, 0}); cursor.GetKey(key) && range_of(key.hash) == range; cursor.Next()) {
+                    if (!cursor.GetValue(coin)) continue;
+                    if (chunks.empty() || chunks.back().header.coins_count == SNAPSHOT_CHUNK_MAX_COINS) {
+                        chunks.emplace_back();
+                    }
+                    DumpedChunk& chunk{chunks.back()};
+                    chunk.data << key << coin;
+                    ++chunk.header.coins_count;
+                }
+                for (DumpedChunk& chunk : chunks) {
+                    chunk.header.size = chunk.data.size();
+                    chunk.header.checksum = Hash(chunk.data);
+                }
+            }
+        }};
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < std::min(num_threads, ranges.size()); ++i) {
+            threads.emplace_back(work, std::ref(*cursors[i]));
+        }
+        work(*cursors[0]);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        for (const std::vector<DumpedChunk>& chunks : ranges) {
+            for (const DumpedChunk& chunk : chunks) {
+                chunk_offsets.push_back(offset);
+                afile << chunk.header;
+                afile.write(MakeByteSpan(chunk.data));
+                offset += SNAPSHOT_CHUNK_HEADER_SIZE + chunk.data.size();
+                coins_written += chunk.header.coins_count;
+            }
         }
+    }
+    if (coins_written != maybe_stats->coins_count) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
+    }
 
-        pcursor->Next();
+    metadata.m_chunk_count = chunk_offsets.size();
+    metadata.m_index_offset = offset;
+    for (const uint64_t chunk_offset : chunk_offsets) {
+        afile << chunk_offset;
+    }
+    if (std::fseek(afile.Get(), 0, SEEK_SET) != 0) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Couldn't seek in file " + fs::PathToString(temppath));
     }
+    afile << metadata;
 
     afile.fclose();
 
     UniValue result(UniValue::VOBJ);
     result.pushKV("coins_written", maybe_stats->coins_count);
+    result.pushKV("chunks", metadata.m_chunk_count);
     result.pushKV("base_hash", tip->GetBlockHash().ToString());
     result.pushKV("base_height", tip->nHeight);
     result.pushKV("path", path.u8string());
@@ -2427,6 +2586,7 @@ void RegisterBlockchainRPCCommands(CRPCTable& t)
         {"hidden", &waitforblockheight},
         {"hidden", &syncwithvalidationinterfacequeue},
         {"hidden", &dumptxoutset},
+        {"hidden", &loadtxoutset},
     };
     for (const auto& c : commands) {
         t.appendCommand(c.name, &c);
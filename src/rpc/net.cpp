@@ -22,6 +22,7 @@
 #include <rpc/util.h>
 #include <sync.h>
 #include <timedata.h>
+#include <txorphanage.h>
 #include <util/strencodings.h>
 #include <util/string.h>
 #include <util/time.h>
@@ -122,6 +123,7 @@ static RPCHelpMan getpeerinfo()
                     {RPCResult::Type::NUM_TIME, "last_block", "The " + UNIX_EPOCH_TIME + " of the last block received from this peer"},
                     {RPCResult::Type::NUM, "bytessent", "The total bytes sent"},
                     {RPCResult::Type::NUM, "bytesrecv", "The total bytes received"},
+                    {RPCResult::Type::NUM, "recvbuffer", "The bytes held for received messages that have not been processed yet"},
                     {RPCResult::Type::NUM_TIME, "conntime", "The " + UNIX_EPOCH_TIME + " of the connection"},
                     {RPCResult::Type::NUM, "timeoffset", "The time offset in seconds"},
                     {RPCResult::Type::NUM, "pingtime", /*optional=*/true, "ping time (if available)"},
@@ -207,6 +209,7 @@ static RPCHelpMan getpeerinfo()
         obj.pushKV("last_block", count_seconds(stats.m_last_block_time));
         obj.pushKV("bytessent", stats.nSendBytes);
         obj.pushKV("bytesrecv", stats.nRecvBytes);
+        obj.pushKV("recvbuffer", stats.m_recv_buffer_size);
         obj.pushKV("conntime", count_seconds(stats.m_connected));
         obj.pushKV("timeoffset", stats.nTimeOffset);
         if (stats.m_last_ping_time > 0us) {
@@ -555,6 +558,66 @@ static RPCHelpMan getnettotals()
     };
 }
 
+static RPCHelpMan getorphaninfo()
+{
+    return RPCHelpMan{"getorphaninfo",
+                "\nReturns information about the orphan transactions kept, i.e. transactions whose parents were not received yet.\n",
+                {},
+                RPCResult{
+                   RPCResult::Type::OBJ, "", "",
+                   {
+                       {RPCResult::Type::NUM, "size", "Number of orphan transactions"},
+                       {RPCResult::Type::NUM, "weight", "Total weight of the orphan transactions"},
+                       {RPCResult::Type::NUM, "max_weight", "Maximum total weight of the orphan transactions"},
+                       {RPCResult::Type::NUM, "max_peer_weight", "Maximum total weight of the orphan transactions received from a single peer"},
+                       {RPCResult::Type::NUM, "evicted", "Number of orphan transactions evicted to stay within the limits"},
+                       {RPCResult::Type::NUM, "expired", "Number of orphan transactions that expired"},
+                       {RPCResult::Type::NUM, "erased_for_block", "Number of orphan transactions removed because they were included in or conflicted by a block"},
+                       {RPCResult::Type::NUM, "block_parent_arrivals", "Number of times an orphan transaction was reconsidered because a block confirmed one of its parents"},
+                       {RPCResult::Type::ARR, "peers", "Peers that sent orphan transactions",
+                       {
+                           {RPCResult::Type::OBJ, "", "",
+                           {
+                               {RPCResult::Type::NUM, "id", "Peer index"},
+                               {RPCResult::Type::NUM, "size", "Number of orphan transactions received from the peer"},
+                               {RPCResult::Type::NUM, "weight", "Total weight of the orphan transactions received from the peer"},
+                           }},
+                       }},
+                    }
+                },
+                RPCExamples{
+                    HelpExampleCli("getorphaninfo", "")
+            + HelpExampleRpc("getorphaninfo", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    NodeContext& node = EnsureAnyNodeContext(request.context);
+    const PeerManager& peerman = EnsurePeerman(node);
+    const TxOrphanage::Info info{peerman.GetOrphanInfo()};
+
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("size", (uint64_t)info.count);
+    obj.pushKV("weight", info.weight);
+    obj.pushKV("max_weight", MAX_ORPHAN_TOTAL_WEIGHT);
+    obj.pushKV("max_peer_weight", MAX_PEER_ORPHAN_WEIGHT);
+    obj.pushKV("evicted", info.evicted);
+    obj.pushKV("expired", info.expired);
+    obj.pushKV("erased_for_block", info.erased_for_block);
+    obj.pushKV("block_parent_arrivals", info.block_parent_arrivals);
+    UniValue peers(UniValue::VARR);
+    for (const auto& [peer_id, peer_info] : info.peers) {
+        UniValue peer(UniValue::VOBJ);
+        peer.pushKV("id", peer_id);
+        peer.pushKV("size", (uint64_t)peer_info.count);
+        peer.pushKV("weight", peer_info.weight);
+        peers.push_back(peer);
+    }
+    obj.pushKV("peers", peers);
+    return obj;
+},
+    };
+}
+
 static UniValue GetNetworksInfo()
 {
     UniValue networks(UniValue::VARR);
@@ -978,6 +1041,7 @@ void RegisterNetRPCCommands(CRPCTable& t)
         {"network", &disconnectnode},
         {"network", &getaddednodeinfo},
         {"network", &getnettotals},
+        {"network", &getorphaninfo},
         {"network", &getnetworkinfo},
         {"network", &setban},
         {"network", &listbanned},
@@ -0,0 +1,87 @@
+// Copyright (c) 2023-2023 The Koyotecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <chainparams.h>
+#include <clientversion.h>
+#include <crypto/common.h>
+#include <fs.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <streams.h>
+#include <test/util/mining.h>
+#include <test/util/script.h>
+#include <test/util/setup_common.h>
+#include <undo.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+using node::BlockManager;
+
+namespace {
+struct BlockMmapTestingSetup : public TestingSetup {
+    // Use small block files, so that the first one is finished after a few
+    // hundred blocks and can be mapped.
+    BlockMmapTestingSetup() : TestingSetup{CBaseChainParams::REGTEST, {"-fastprune", "-blocksmmap=1"}} {}
+};
+
+//! Overwrite the size in the 8 byte record header in front of pos.
+void CorruptRecordSize(const fs::path& path, const FlatFilePos& pos, uint32_t size)
+{
+    FILE* file{fsbridge::fopen(path, "rb+")};
+    BOOST_REQUIRE(file);
+    BOOST_REQUIRE_EQUAL(std::fseek(file, pos.nPos - 4, SEEK_SET), 0);
+    unsigned char buf[4];
+    WriteLE32(buf, size);
+    BOOST_REQUIRE_EQUAL(std::fwrite(buf, 1, sizeof(buf), file), sizeof(buf));
+    BOOST_REQUIRE_EQUAL(std::fclose(file), 0);
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(blockmanager_tests, BlockMmapTestingSetup)
+
+BOOST_AUTO_TEST_CASE(blockmanager_mmap_record_bounds)
+{
+    BlockManager& blockman{m_node.chainman->m_blockman};
+    const CChainParams& params{Params()};
+    const CBlockIndex* pindex{nullptr};
+    while (!pindex) {
+        MineBlock(m_node, P2WSH_OP_TRUE);
+        LOCK(cs_main);
+        const CChain& chain{m_node.chainman->ActiveChain()};
+        if (chain.Tip()->GetBlockPos().nFile > 0) pindex = chain[1];
+    }
+    const FlatFilePos block_pos{WITH_LOCK(cs_main, return pindex->GetBlockPos())};
+    const FlatFilePos undo_pos{WITH_LOCK(cs_main, return pindex->GetUndoPos())};
+    BOOST_REQUIRE_EQUAL(block_pos.nFile, 0);
+
+    CBlock block;
+    BOOST_REQUIRE(blockman.ReadBlockFromDisk(block, pindex, params.GetConsensus()));
+    std::vector<uint8_t> raw;
+    BOOST_REQUIRE(blockman.ReadRawBlockFromDisk(raw, block_pos, params.MessageStart()));
+    CDataStream expected{SER_DISK, CLIENT_VERSION};
+    expected << block;
+    const auto expected_bytes{MakeUCharSpan(expected)};
+    BOOST_CHECK(std::equal(raw.begin(), raw.end(), expected_bytes.begin(), expected_bytes.end()));
+
+    // A record size pointing past the written part of the file is not
+    // trusted: the raw read, which relies on it, fails cleanly and the
+    // deserializing reads fall back to reading the file.
+    CorruptRecordSize(node::GetBlockPosFilename(block_pos), block_pos, 0xffffffff);
+    CorruptRecordSize(gArgs.GetBlocksDirPath() / fs::u8path(strprintf("rev%05u.dat", undo_pos.nFile)), undo_pos, 0xfffffff0);
+    BOOST_CHECK(!blockman.ReadRawBlockFromDisk(raw, block_pos, params.MessageStart()));
+    CBlock reread;
+    BOOST_CHECK(blockman.ReadBlockFromDisk(reread, pindex, params.GetConsensus()));
+    BOOST_CHECK_EQUAL(reread.GetHash(), block.GetHash());
+    CBlockUndo undo;
+    BOOST_CHECK(blockman.UndoReadFromDisk(undo, pindex));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
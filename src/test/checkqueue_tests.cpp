@@ -70,6 +70,22 @@ struct FailingCheck {
     };
 };
 
+struct CountingFailingCheck {
+    static std::atomic<size_t> n_calls;
+    bool fails{false};
+    CountingFailingCheck() = default;
+    CountingFailingCheck(bool fails_in) : fails(fails_in){};
+    bool operator()()
+    {
+        n_calls.fetch_add(1, std::memory_order_relaxed);
+        return !fails;
+    }
+    void swap(CountingFailingCheck& x) noexcept
+    {
+        std::swap(fails, x.fails);
+    };
+};
+
 struct UniqueCheck {
     static Mutex m;
     static std::unordered_multiset<size_t> results GUARDED_BY(m);
@@ -153,12 +169,14 @@ std::condition_variable FrozenCleanupCheck::cv{};
 Mutex UniqueCheck::m;
 std::unordered_multiset<size_t> UniqueCheck::results;
 std::atomic<size_t> FakeCheckCheckCompletion::n_calls{0};
+std::atomic<size_t> CountingFailingCheck::n_calls{0};
 std::atomic<size_t> MemoryCheck::fake_allocated_memory{0};
 
 // Queue Typedefs
 typedef CCheckQueue<FakeCheckCheckCompletion> Correct_Queue;
 typedef CCheckQueue<FakeCheck> Standard_Queue;
 typedef CCheckQueue<FailingCheck> Failing_Queue;
+typedef CCheckQueue<CountingFailingCheck> CountingFailing_Queue;
 typedef CCheckQueue<UniqueCheck> Unique_Queue;
 typedef CCheckQueue<MemoryCheck> Memory_Queue;
 typedef CCheckQueue<FrozenCleanupCheck> FrozenCleanup_Queue;
@@ -276,6 +294,30 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_Recovers_From_Failure)
     fail_queue->StopWorkerThreads();
 }
 
+// Test that a control with run_all runs every check despite failures, and
+// that the next control short-circuits again.
+BOOST_AUTO_TEST_CASE(test_CheckQueue_RunAll)
+{
+    auto queue = std::make_unique<CountingFailing_Queue>(QUEUE_BATCH_SIZE);
+    queue->StartWorkerThreads(SCRIPT_CHECK_THREADS);
+
+    for (const bool run_all : {true, false}) {
+        CountingFailingCheck::n_calls = 0;
+        CCheckQueueControl<CountingFailingCheck> control(queue.get(), run_all);
+        for (size_t i = 0; i < 100; ++i) {
+            std::vector<CountingFailingCheck> vChecks(QUEUE_BATCH_SIZE, CountingFailingCheck{/*fails_in=*/true});
+            control.Add(vChecks);
+        }
+        BOOST_REQUIRE(!control.Wait());
+        if (run_all) {
+            BOOST_CHECK_EQUAL(CountingFailingCheck::n_calls, 100 * QUEUE_BATCH_SIZE);
+        } else {
+            BOOST_CHECK_LT(CountingFailingCheck::n_calls, 100 * QUEUE_BATCH_SIZE);
+        }
+    }
+    queue->StopWorkerThreads();
+}
+
 // Test that unique checks are actually all called individually, rather than
 // just one check being called repeatedly. Test that checks are not called
 // more than once as well
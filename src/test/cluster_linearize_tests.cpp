@@ -0,0 +1,112 @@
+// Copyright (c) 2023-2023 The Koyotecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <cluster_linearize.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <vector>
+
+using namespace cluster_linearize;
+
+namespace {
+/** Check that a linearization is topologically valid and properly chunked. */
+void CheckLinearization(const Linearization& lin, const std::vector<CAmount>& fees, const std::vector<int64_t>& sizes, const std::vector<std::vector<uint32_t>>& parents)
+{
+    const size_t n{parents.size()};
+    BOOST_REQUIRE_EQUAL(lin.order.size(), n);
+    std::vector<size_t> pos(n, n);
+    for (size_t i = 0; i < n; ++i) pos[lin.order[i]] = i;
+    for (size_t tx = 0; tx < n; ++tx) {
+        BOOST_REQUIRE(pos[tx] < n);
+        for (uint32_t parent : parents[tx]) BOOST_CHECK(pos[parent] < pos[tx]);
+    }
+
+    size_t start{0};
+    for (size_t c = 0; c < lin.chunks.size(); ++c) {
+        const Chunk& chunk{lin.chunks[c]};
+        CAmount fee{0};
+        int64_t size{0};
+        for (size_t i = start; i < start + chunk.count; ++i) {
+            fee += fees[lin.order[i]];
+            size += sizes[lin.order[i]];
+        }
+        BOOST_CHECK_EQUAL(chunk.fee, fee);
+        BOOST_CHECK_EQUAL(chunk.size, size);
+        if (c > 0) {
+            const Chunk& prev{lin.chunks[c - 1]};
+            BOOST_CHECK(HigherFeerate(prev.fee, prev.size, chunk.fee, chunk.size));
+        }
+        start += chunk.count;
+    }
+    BOOST_CHECK_EQUAL(start, n);
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(cluster_linearize_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(linearize_simple)
+{
+    // A child paying for its parent is chunked with it.
+    {
+        const std::vector<CAmount> fees{1, 1000};
+        const std::vector<int64_t> sizes{100, 100};
+        const std::vector<std::vector<uint32_t>> parents{{}, {0}};
+        const Linearization lin{Linearize(fees, sizes, parents)};
+        CheckLinearization(lin, fees, sizes, parents);
+        BOOST_CHECK(lin.order == std::vector<uint32_t>({0, 1}));
+        BOOST_REQUIRE_EQUAL(lin.chunks.size(), 1U);
+        BOOST_CHECK_EQUAL(lin.chunks[0].count, 2U);
+    }
+
+    // Parents need not have lower indices than their children.
+    {
+        const std::vector<CAmount> fees{50, 10, 30};
+        const std::vector<int64_t> sizes{1, 1, 1};
+        const std::vector<std::vector<uint32_t>> parents{{1}, {}, {}};
+        const Linearization lin{Linearize(fees, sizes, parents)};
+        CheckLinearization(lin, fees, sizes, parents);
+        // {1, 0} has an ancestor feerate of 30, like 2, so it is picked first.
+        BOOST_CHECK(lin.order == std::vector<uint32_t>({1, 0, 2}));
+        // Chunks of equal feerate are merged.
+        BOOST_CHECK_EQUAL(lin.chunks.size(), 1U);
+    }
+
+    // An ancestor set beats a transaction with a higher individual feerate
+    // than the set's parent.
+    {
+        const std::vector<CAmount> fees{0, 10, 4};
+        const std::vector<int64_t> sizes{1, 1, 1};
+        const std::vector<std::vector<uint32_t>> parents{{}, {0}, {}};
+        const Linearization lin{Linearize(fees, sizes, parents)};
+        CheckLinearization(lin, fees, sizes, parents);
+        BOOST_CHECK(lin.order == std::vector<uint32_t>({0, 1, 2}));
+        BOOST_REQUIRE_EQUAL(lin.chunks.size(), 2U);
+        BOOST_CHECK_EQUAL(lin.chunks[0].fee, 10);
+        BOOST_CHECK_EQUAL(lin.chunks[1].fee, 4);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(linearize_random)
+{
+    for (size_t n : {size_t{1}, size_t{10}, size_t{100}, MAX_ANCESTOR_SET_LINEARIZATION + 100}) {
+        std::vector<CAmount> fees;
+        std::vector<int64_t> sizes;
+        std::vector<std::vector<uint32_t>> parents(n);
+        for (uint32_t i = 0; i < n; ++i) {
+            fees.push_back(InsecureRandRange(10000));
+            sizes.push_back(1 + InsecureRandRange(1000));
+            // Edges only go from lower to higher indices, so the graph is acyclic.
+            for (int j = 0; i > 0 && j < 3; ++j) {
+                const uint32_t parent = InsecureRandRange(i);
+                if (std::find(parents[i].begin(), parents[i].end(), parent) == parents[i].end()) parents[i].push_back(parent);
+            }
+        }
+        CheckLinearization(Linearize(fees, sizes, parents), fees, sizes, parents);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
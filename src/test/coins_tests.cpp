@@ -54,9 +54,9 @@ public:
 
     uint256 GetBestBlock() const override { return hashBestBlock_; }
 
-    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock) override
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, bool erase = true) override
     {
-        for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end(); ) {
+        for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end(); it = erase ? mapCoins.erase(it) : std::next(it)) {
             if (it->second.flags & CCoinsCacheEntry::DIRTY) {
                 // Same optimization used in CCoinsViewDB is to only write dirty entries.
                 map_[it->first] = it->second.coin;
@@ -65,7 +65,6 @@ public:
                     map_.erase(it->first);
                 }
             }
-            mapCoins.erase(it++);
         }
         if (!hashBlock.IsNull())
             hashBestBlock_ = hashBlock;
@@ -217,7 +216,8 @@ void SimulationTest(CCoinsView* base, bool fake_best_block)
             if (stack.size() > 1 && InsecureRandBool() == 0) {
                 unsigned int flushIndex = InsecureRandRange(stack.size() - 1);
                 if (fake_best_block) stack[flushIndex]->SetBestBlock(InsecureRand256());
-                BOOST_CHECK(stack[flushIndex]->Flush());
+                bool should_erase = InsecureRandRange(4) < 3;
+                BOOST_CHECK(should_erase ? stack[flushIndex]->Flush() : stack[flushIndex]->Sync());
             }
         }
         if (InsecureRandRange(100) == 0) {
@@ -464,7 +464,8 @@ BOOST_AUTO_TEST_CASE(updatecoins_simulation_test)
             // Every 100 iterations, flush an intermediate cache
             if (stack.size() > 1 && InsecureRandBool() == 0) {
                 unsigned int flushIndex = InsecureRandRange(stack.size() - 1);
-                BOOST_CHECK(stack[flushIndex]->Flush());
+                bool should_erase = InsecureRandRange(4) < 3;
+                BOOST_CHECK(should_erase ? stack[flushIndex]->Flush() : stack[flushIndex]->Sync());
             }
         }
         if (InsecureRandRange(100) == 0) {
@@ -609,7 +610,8 @@ void GetCoinsMapEntry(const CCoinsMap& map, CAmount& value, char& flags)
 
 void WriteCoinsViewEntry(CCoinsView& view, CAmount value, char flags)
 {
-    CCoinsMap map;
+    CCoinsMapMemoryResource resource;
+    CCoinsMap map{0, CCoinsMap::hasher{}, CCoinsMap::key_equal{}, &resource};
     InsertCoinsMapEntry(map, value, flags);
     BOOST_CHECK(view.BatchWrite(map, {}));
 }
@@ -878,4 +880,35 @@ BOOST_AUTO_TEST_CASE(ccoins_write)
                     CheckWriteCoins(parent_value, child_value, parent_value, parent_flags, child_flags, parent_flags);
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_sync_retains_clean_entries)
+{
+    /* Sync() writes DIRTY entries to the base like Flush(), but keeps unspent
+     * coins in the cache as clean entries and only drops spent ones. */
+    CCoinsView root;
+    CCoinsViewCacheTest base{&root};
+    CCoinsViewCacheTest cache{&base};
+
+    const COutPoint unspent{InsecureRand256(), 0};
+    const COutPoint spent{InsecureRand256(), 1};
+    Coin coin;
+    SetCoinsValue(VALUE1, coin);
+    cache.AddCoin(unspent, Coin{coin}, /*possible_overwrite=*/false);
+    cache.AddCoin(spent, Coin{coin}, /*possible_overwrite=*/false);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(cache.SpendCoin(spent));
+    // Load the unspent coin again so it becomes a clean cache entry.
+    BOOST_CHECK(cache.HaveCoin(unspent));
+    BOOST_CHECK_EQUAL(cache.map().at(spent).flags, DIRTY);
+
+    BOOST_CHECK(cache.Sync());
+    cache.SelfTest();
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 1U);
+    BOOST_CHECK(cache.HaveCoinInCache(unspent));
+    BOOST_CHECK_EQUAL(cache.map().at(unspent).flags, 0);
+    BOOST_CHECK(!cache.HaveCoinInCache(spent));
+    // The spend reached the base view.
+    BOOST_CHECK(!base.HaveCoin(spent));
+    BOOST_CHECK(base.HaveCoin(unspent));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
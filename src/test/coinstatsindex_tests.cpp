@@ -3,10 +3,16 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <blockfilter.h>
 #include <chainparams.h>
+#include <consensus/consensus.h>
+#include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
 #include <interfaces/chain.h>
 #include <kernel/coinstats.h>
+#include <test/util/blockfilter.h>
+#include <test/util/mining.h>
+#include <test/util/script.h>
 #include <test/util/setup_common.h>
 #include <test/util/validation.h>
 #include <util/time.h>
@@ -123,4 +129,76 @@ BOOST_FIXTURE_TEST_CASE(coinstatsindex_unclean_shutdown, TestChain100Setup)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(coinstatsindex_shared_sync, RegTestingSetup)
+{
+    // Blocks with spends, so that their undo data isn't empty
+    std::vector<CTxIn> coinbases;
+    for (int i = 0; i < COINBASE_MATURITY + 10; ++i) {
+        coinbases.push_back(MineBlock(m_node, P2WSH_OP_TRUE));
+    }
+    for (int i = 0; i < 10; ++i) {
+        CMutableTransaction tx;
+        tx.vin.push_back(coinbases[i]);
+        tx.vin[0].scriptWitness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
+        tx.vout.emplace_back(COIN, P2WSH_OP_TRUE);
+        const MempoolAcceptResult res{WITH_LOCK(cs_main, return m_node.chainman->ProcessTransaction(MakeTransactionRef(tx)))};
+        BOOST_REQUIRE(res.m_result_type == MempoolAcceptResult::ResultType::VALID);
+        MineBlock(m_node, P2WSH_OP_TRUE);
+    }
+
+    // Sync two indexes that need undo data at the same time, so that they
+    // share the blocks and undo data they read.
+    const IndexSyncReads reads_before{GetIndexSyncReads()};
+    CoinStatsIndex coin_stats_index{interfaces::MakeChain(m_node), 1 << 20, true};
+    BlockFilterIndex filter_index{interfaces::MakeChain(m_node), BlockFilterType::BASIC, 1 << 20, true};
+    BOOST_REQUIRE(coin_stats_index.Start());
+    BOOST_REQUIRE(filter_index.Start());
+    IndexWaitSynced(coin_stats_index);
+    IndexWaitSynced(filter_index);
+    const IndexSyncReads reads_shared{GetIndexSyncReads()};
+
+    // The same stats as when syncing alone, and the same filters as another
+    // index syncing alone
+    CoinStatsIndex alone_index{interfaces::MakeChain(m_node), 1 << 20, true};
+    BOOST_REQUIRE(alone_index.Start());
+    IndexWaitSynced(alone_index);
+    BlockFilterIndex alone_filter_index{interfaces::MakeChain(m_node), BlockFilterType::BASIC, 1 << 20, true};
+    BOOST_REQUIRE(alone_filter_index.Start());
+    IndexWaitSynced(alone_filter_index);
+    const IndexSyncReads reads_alone{GetIndexSyncReads()};
+
+    // Syncing alone, every index reads every block and its undo data.
+    const uint64_t num_blocks{uint64_t(WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Height()) + 1)};
+    BOOST_CHECK_EQUAL(reads_alone.blocks - reads_shared.blocks, 2 * num_blocks);
+    BOOST_CHECK_EQUAL(reads_alone.undos - reads_shared.undos, 2 * (num_blocks - 1));
+    // Syncing together, most reads are shared.
+    BOOST_CHECK_LT(reads_shared.blocks - reads_before.blocks, num_blocks + num_blocks / 2);
+    BOOST_CHECK_LT(reads_shared.undos - reads_before.undos, num_blocks + num_blocks / 2);
+
+    LOCK(cs_main);
+    for (const CBlockIndex* block_index = m_node.chainman->ActiveChain().Genesis();
+         block_index != nullptr;
+         block_index = m_node.chainman->ActiveChain().Next(block_index)) {
+        const auto stats{coin_stats_index.LookUpStats(*block_index)};
+        const auto alone_stats{alone_index.LookUpStats(*block_index)};
+        BOOST_REQUIRE(stats && alone_stats);
+        BOOST_CHECK_EQUAL(stats->hashSerialized, alone_stats->hashSerialized);
+        BOOST_CHECK_EQUAL(stats->total_unspendable_amount, alone_stats->total_unspendable_amount);
+
+        BlockFilter filter, expected_filter;
+        BOOST_REQUIRE(filter_index.LookupFilter(block_index, filter));
+        BOOST_REQUIRE(ComputeFilter(BlockFilterType::BASIC, block_index, expected_filter, m_node.chainman->m_blockman));
+        BOOST_CHECK_EQUAL(filter.GetHash(), expected_filter.GetHash());
+        BlockFilter alone_filter;
+        BOOST_REQUIRE(alone_filter_index.LookupFilter(block_index, alone_filter));
+        BOOST_CHECK_EQUAL(alone_filter.GetHash(), filter.GetHash());
+    }
+
+    coin_stats_index.Stop();
+    filter_index.Stop();
+    alone_index.Stop();
+    alone_filter_index.Stop();
+    SyncWithValidationInterfaceQueue();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
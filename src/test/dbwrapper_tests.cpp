@@ -412,5 +412,38 @@ BOOST_AUTO_TEST_CASE(unicodepath)
     BOOST_CHECK(fs::exists(lockPath));
 }
 
+BOOST_AUTO_TEST_CASE(dbwrapper_profiles)
+{
+    ArgsManager args;
+    args.AddArg("-dbprofile", "", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    const char* argv[]{"ignored", "-dbprofile=chainstate:bulk", "-dbprofile=txindex:lookup", "-dbprofile=chainstate:lookup"};
+    std::string error;
+    BOOST_REQUIRE(args.ParseParameters(std::size(argv), argv, error));
+    BOOST_CHECK(!CheckDBProfileArgs(args));
+
+    // The last profile given for a database wins.
+    const DBProfile lookup{*GetDBProfileByName("lookup")};
+    BOOST_CHECK_EQUAL(GetDBProfile(args, "chainstate").block_size, lookup.block_size);
+    BOOST_CHECK_EQUAL(GetDBProfile(args, "txindex").bloom_bits, lookup.bloom_bits);
+    BOOST_CHECK_EQUAL(GetDBProfile(args, "blockindex").block_size, DBProfile{}.block_size);
+    BOOST_CHECK(!GetDBProfileByName("fast"));
+
+    for (const char* bad : {"-dbprofile=chainstate", "-dbprofile=chainstate:fast", "-dbprofile=wallet:bulk"}) {
+        const char* bad_argv[]{"ignored", bad};
+        BOOST_REQUIRE(args.ParseParameters(std::size(bad_argv), bad_argv, error));
+        BOOST_CHECK_EQUAL(CheckDBProfileArgs(args).value_or(""), std::string{bad}.substr(std::string{"-dbprofile="}.size()));
+    }
+
+    // A database written with one profile can be reopened with another.
+    const fs::path ph{m_args.GetDataDirBase() / "dbwrapper_profiles"};
+    {
+        CDBWrapper dbw{ph, 1 << 20, /*fMemory=*/false, /*fWipe=*/true, /*obfuscate=*/true, *GetDBProfileByName("bulk")};
+        for (uint32_t i = 0; i < 1000; ++i) BOOST_CHECK(dbw.Write(i, InsecureRand256()));
+    }
+    CDBWrapper dbw{ph, 1 << 20, /*fMemory=*/false, /*fWipe=*/false, /*obfuscate=*/true, lookup};
+    for (uint32_t i = 0; i < 1000; ++i) BOOST_CHECK(dbw.Exists(i));
+    BOOST_CHECK(!dbw.Exists(uint32_t{1000}));
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
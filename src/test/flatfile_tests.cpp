@@ -124,4 +124,35 @@ BOOST_AUTO_TEST_CASE(flatfile_flush)
     BOOST_CHECK_EQUAL(fs::file_size(seq.FileName(FlatFilePos(0, 1))), 1U);
 }
 
+BOOST_AUTO_TEST_CASE(flatfile_map)
+{
+    const auto data_dir = m_args.GetDataDirBase();
+    FlatFileSeq seq(data_dir, "a", 100);
+
+    // Nothing to map for missing or empty files.
+    BOOST_CHECK(!seq.Map(FlatFilePos(0, 0)));
+    fclose(seq.Open(FlatFilePos(0, 0)));
+    BOOST_CHECK(!seq.Map(FlatFilePos(0, 0)));
+
+    const std::string line1("A purely peer-to-peer version of electronic cash.");
+    {
+        AutoFile file{seq.Open(FlatFilePos(0, 0))};
+        file << LIMITED_STRING(line1, 256);
+    }
+
+    auto map = seq.Map(FlatFilePos(0, 0));
+#ifdef WIN32
+    BOOST_CHECK(!map);
+#else
+    BOOST_REQUIRE(map);
+    BOOST_CHECK_EQUAL(map->Data().size(), line1.size() + 1);
+    BOOST_CHECK_EQUAL(map->Data()[0], line1.size());
+    BOOST_CHECK(std::equal(line1.begin(), line1.end(), map->Data().begin() + 1));
+
+    // The mapping stays readable after the file is removed.
+    fs::remove(seq.FileName(FlatFilePos(0, 0)));
+    BOOST_CHECK(std::equal(line1.begin(), line1.end(), map->Data().begin() + 1));
+#endif
+}
+
 BOOST_AUTO_TEST_SUITE_END()
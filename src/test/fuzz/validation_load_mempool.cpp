@@ -48,6 +48,6 @@ FUZZ_TARGET_INIT(validation_load_mempool, initialize_validation_load_mempool)
     auto fuzzed_fopen = [&](const fs::path&, const char*) {
         return fuzzed_file_provider.open();
     };
-    (void)chainstate.LoadMempool(MempoolPath(g_setup->m_args), fuzzed_fopen);
-    (void)DumpMempool(pool, MempoolPath(g_setup->m_args), fuzzed_fopen, true);
+    (void)chainstate.LoadMempool(MempoolPath(g_setup->m_args), {.mockable_fopen_function = fuzzed_fopen});
+    (void)DumpMempool(pool, MempoolPath(g_setup->m_args), chainstate, fuzzed_fopen, true);
 }
@@ -0,0 +1,99 @@
+// Copyright (c) 2023-2023 The Koyotecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <coins.h>
+#include <inputfetcher.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+
+namespace {
+//! Read-only coins view, so that it can be queried from several threads.
+class StaticCoinsView : public CCoinsView
+{
+public:
+    std::map<COutPoint, Coin> m_coins;
+
+    bool GetCoin(const COutPoint& outpoint, Coin& coin) const override
+    {
+        const auto it{m_coins.find(outpoint)};
+        if (it == m_coins.end()) return false;
+        coin = it->second;
+        return true;
+    }
+};
+
+Coin MakeCoin(CAmount value)
+{
+    Coin coin;
+    coin.out.nValue = value;
+    coin.out.scriptPubKey = CScript() << OP_TRUE;
+    coin.nHeight = 1;
+    return coin;
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(inputfetcher_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(fetch_inputs)
+{
+    StaticCoinsView db;
+    CCoinsViewCache cache{&db};
+
+    CBlock block;
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vout.resize(1);
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+
+    // Spend 100 coins from the database, one of which is already cached and
+    // one of which is missing from the database.
+    CMutableTransaction spend;
+    for (uint32_t i = 0; i < 100; ++i) {
+        const COutPoint outpoint{InsecureRand256(), i};
+        spend.vin.emplace_back(outpoint);
+        if (i != 99) db.m_coins.emplace(outpoint, MakeCoin(i + 1));
+    }
+    spend.vout.resize(1);
+    BOOST_CHECK(cache.HaveCoin(spend.vin[0].prevout));
+    const CTransactionRef spend_tx{MakeTransactionRef(spend)};
+    block.vtx.push_back(spend_tx);
+
+    // Spending an output created within the block doesn't need a read.
+    CMutableTransaction child;
+    child.vin.emplace_back(spend_tx->GetHash(), 0);
+    child.vout.resize(1);
+    block.vtx.push_back(MakeTransactionRef(child));
+
+    InputFetcher fetcher;
+    fetcher.StartWorkerThreads(3);
+    fetcher.FetchInputs(cache, db, block);
+    BOOST_CHECK_EQUAL(fetcher.GetHits(), 1U);
+    BOOST_CHECK_EQUAL(fetcher.GetMisses(), 99U);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 99U);
+    for (uint32_t i = 0; i < 99; ++i) {
+        BOOST_CHECK(cache.HaveCoinInCache(spend.vin[i].prevout));
+        BOOST_CHECK_EQUAL(cache.AccessCoin(spend.vin[i].prevout).out.nValue, i + 1);
+    }
+    BOOST_CHECK(!cache.HaveCoinInCache(spend.vin[99].prevout));
+
+    // A spent entry in the cache takes precedence over the database.
+    BOOST_CHECK(cache.SpendCoin(spend.vin[1].prevout));
+    cache.Uncache(spend.vin[2].prevout);
+    fetcher.FetchInputs(cache, db, block);
+    BOOST_CHECK(!cache.HaveCoin(spend.vin[1].prevout));
+    BOOST_CHECK(cache.HaveCoinInCache(spend.vin[2].prevout));
+    fetcher.StopWorkerThreads();
+
+    // Without workers, the calling thread does all of the reads.
+    cache.Uncache(spend.vin[3].prevout);
+    fetcher.FetchInputs(cache, db, block);
+    BOOST_CHECK(cache.HaveCoinInCache(spend.vin[3].prevout));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,155 @@
+// Copyright (c) 2023-2023 The Koyotecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <consensus/consensus.h>
+#include <consensus/validation.h>
+#include <crypto/common.h>
+#include <fs.h>
+#include <kernel/mempool_persist.h>
+#include <policy/policy.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <test/util/mining.h>
+#include <test/util/script.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <vector>
+
+using kernel::DumpMempool;
+
+namespace {
+struct NonStandardTestingSetup : public TestingSetup {
+    NonStandardTestingSetup() : TestingSetup{CBaseChainParams::REGTEST, {"-acceptnonstdtxn=1"}} {}
+};
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(mempool_persist_tests, RegTestingSetup)
+
+BOOST_AUTO_TEST_CASE(dump_and_load)
+{
+    Chainstate& chainstate{m_node.chainman->ActiveChainstate()};
+    CTxMemPool& pool{*m_node.mempool};
+    const fs::path path{m_args.GetDataDirNet() / "mempool.dat"};
+
+    std::vector<CTxIn> coinbase_outpoints;
+    for (int i = 0; i < COINBASE_MATURITY + 1; ++i) {
+        coinbase_outpoints.push_back(MineBlock(m_node, P2WSH_OP_TRUE));
+    }
+    const auto submit{[&](const CMutableTransaction& tx) {
+        const MempoolAcceptResult res{WITH_LOCK(cs_main, return m_node.chainman->ProcessTransaction(MakeTransactionRef(tx)))};
+        BOOST_REQUIRE(res.m_result_type == MempoolAcceptResult::ResultType::VALID);
+    }};
+
+    // Confirm many outputs, so that more than a chunk of independent
+    // transactions can spend them.
+    const size_t num_txs{600};
+    const CAmount value{COIN / 10};
+    CMutableTransaction fan_out;
+    fan_out.vin.push_back(coinbase_outpoints[0]);
+    fan_out.vin[0].scriptWitness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
+    fan_out.vout.resize(num_txs + 1, CTxOut{value, P2WSH_OP_TRUE});
+    submit(fan_out);
+    MineBlock(m_node, P2WSH_OP_TRUE);
+    BOOST_REQUIRE_EQUAL(pool.size(), 0U);
+
+    for (uint32_t i = 0; i < num_txs; ++i) {
+        CMutableTransaction tx;
+        tx.vin.emplace_back(fan_out.GetHash(), i);
+        tx.vin[0].scriptWitness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
+        tx.vout.emplace_back(value - 1000, P2WSH_OP_TRUE);
+        submit(tx);
+    }
+    // A transaction with an invalid witness, which only gets in when its
+    // scripts aren't verified.
+    CMutableTransaction bad_tx;
+    bad_tx.vin.emplace_back(fan_out.GetHash(), num_txs);
+    bad_tx.vout.emplace_back(value - 1000, P2WSH_OP_TRUE);
+    {
+        LOCK2(cs_main, pool.cs);
+        pool.addUnchecked(TestMemPoolEntryHelper{}.Fee(1000).Time(GetTime()).FromTx(bad_tx));
+    }
+    BOOST_REQUIRE(DumpMempool(pool, path, chainstate));
+
+    const auto reload{[&](bool skip_script_checks) {
+        WITH_LOCK(pool.cs, pool.clear());
+        chainstate.LoadMempool(path, {.skip_script_checks = skip_script_checks});
+        return pool.size();
+    }};
+    BOOST_CHECK_EQUAL(reload(/*skip_script_checks=*/false), num_txs);
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(bad_tx.GetHash())));
+    BOOST_CHECK_EQUAL(reload(/*skip_script_checks=*/true), num_txs + 1);
+    BOOST_CHECK(pool.exists(GenTxid::Txid(bad_tx.GetHash())));
+
+    // Scripts are verified again once the tip changed.
+    WITH_LOCK(pool.cs, pool.clear());
+    MineBlock(m_node, P2WSH_OP_TRUE);
+    BOOST_CHECK_EQUAL(reload(/*skip_script_checks=*/true), num_txs);
+
+    // A corrupted chunk is skipped, the ones after it are still loaded.
+    {
+        FILE* file{fsbridge::fopen(path, "rb+")};
+        BOOST_REQUIRE(file);
+        // Past the file header and the first chunk's header
+        BOOST_REQUIRE_EQUAL(std::fseek(file, 100, SEEK_SET), 0);
+        const int byte{std::fgetc(file)};
+        BOOST_REQUIRE(byte != EOF);
+        BOOST_REQUIRE_EQUAL(std::fseek(file, 100, SEEK_SET), 0);
+        std::fputc(byte ^ 1, file);
+        std::fclose(file);
+    }
+    const size_t loaded{reload(/*skip_script_checks=*/false)};
+    BOOST_CHECK(loaded > 0 && loaded <= num_txs + 1 - 500);
+
+    // A chunk header claiming more bytes than any chunk can hold is not
+    // trusted with an allocation.
+    {
+        FILE* file{fsbridge::fopen(path, "rb+")};
+        BOOST_REQUIRE(file);
+        // The size follows the file header and the first chunk's tx count.
+        BOOST_REQUIRE_EQUAL(std::fseek(file, 8 + 32 + 4 + 8 + 4, SEEK_SET), 0);
+        unsigned char buf[4];
+        WriteLE32(buf, 16 << 20);
+        BOOST_REQUIRE_EQUAL(std::fwrite(buf, 1, sizeof(buf), file), sizeof(buf));
+        std::fclose(file);
+    }
+    BOOST_CHECK_EQUAL(reload(/*skip_script_checks=*/false), 0U);
+}
+
+BOOST_FIXTURE_TEST_CASE(dump_and_load_large_transactions, NonStandardTestingSetup)
+{
+    Chainstate& chainstate{m_node.chainman->ActiveChainstate()};
+    CTxMemPool& pool{*m_node.mempool};
+    const fs::path path{m_args.GetDataDirNet() / "mempool.dat"};
+
+    // Transactions of almost 1MB, far heavier than standard ones. Four of them
+    // stay below the chunk size, a fifth one would take the chunk past what
+    // the loader accepts.
+    const size_t num_txs{5};
+    std::vector<CTxIn> coinbase_outpoints;
+    for (int i = 0; i < COINBASE_MATURITY + int(num_txs); ++i) {
+        coinbase_outpoints.push_back(MineBlock(m_node, P2WSH_OP_TRUE));
+    }
+    for (size_t i = 0; i < num_txs; ++i) {
+        CMutableTransaction tx;
+        tx.vin.push_back(coinbase_outpoints[i]);
+        tx.vin[0].scriptWitness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
+        tx.vout.emplace_back(COIN / 10, CScript{} << OP_RETURN << std::vector<unsigned char>(990000, uint8_t(i)));
+        const CTransactionRef ptx{MakeTransactionRef(tx)};
+        BOOST_REQUIRE(GetTransactionWeight(*ptx) > MAX_STANDARD_TX_WEIGHT);
+        const MempoolAcceptResult res{WITH_LOCK(cs_main, return m_node.chainman->ProcessTransaction(ptx))};
+        BOOST_REQUIRE(res.m_result_type == MempoolAcceptResult::ResultType::VALID);
+    }
+    BOOST_REQUIRE(DumpMempool(pool, path, chainstate));
+
+    WITH_LOCK(pool.cs, pool.clear());
+    chainstate.LoadMempool(path, {});
+    BOOST_CHECK_EQUAL(pool.size(), num_txs);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
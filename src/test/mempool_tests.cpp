@@ -5,9 +5,12 @@
 
 #include <policy/policy.h>
 #include <txmempool.h>
+#include <util/rbf.h>
 #include <util/system.h>
 #include <util/time.h>
+#include <validation.h>
 
+#include <test/util/script.h>
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
@@ -801,4 +804,123 @@ BOOST_AUTO_TEST_CASE(MempoolAncestryTestsDiamond)
     BOOST_CHECK_EQUAL(descendants, 4ULL);
 }
 
+BOOST_AUTO_TEST_CASE(MempoolClusterTest)
+{
+    CTxMemPool::Options opts{MemPoolOptionsForTest(m_node)};
+    opts.estimator = nullptr;
+    opts.track_clusters = true;
+    CTxMemPool pool{opts};
+    LOCK2(cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    const auto cluster_of{[&](const CTransactionRef& tx) EXCLUSIVE_LOCKS_REQUIRED(pool.cs) {
+        return pool.GetIter(tx->GetHash()).value()->m_cluster;
+    }};
+
+    // [tx1].0 <- [tx2]        [tx3]
+    CTransactionRef tx1 = make_tx(/*output_values=*/{10 * COIN, 10 * COIN});
+    pool.addUnchecked(entry.Fee(1000LL).FromTx(tx1));
+    CTransactionRef tx2 = make_tx(/*output_values=*/{10 * COIN}, /*inputs=*/{tx1});
+    pool.addUnchecked(entry.Fee(20000LL).FromTx(tx2));
+    CTransactionRef tx3 = make_tx(/*output_values=*/{5 * COIN});
+    pool.addUnchecked(entry.Fee(5000LL).FromTx(tx3));
+    BOOST_CHECK_EQUAL(pool.GetClusters().size(), 2U);
+    BOOST_CHECK_EQUAL(cluster_of(tx1), cluster_of(tx2));
+    // The child pays for its parent, so they form a single chunk.
+    BOOST_CHECK_EQUAL(cluster_of(tx1)->chunks.size(), 1U);
+
+    // [tx1].0 <- [tx2]        [tx3]
+    //      .1 <- [tx4]
+    CTransactionRef tx4 = make_tx(/*output_values=*/{10 * COIN}, /*inputs=*/{tx1}, /*input_indices=*/{1});
+    pool.addUnchecked(entry.Fee(100LL).FromTx(tx4));
+    BOOST_CHECK_EQUAL(pool.GetClusters().size(), 2U);
+    const TxMemPoolCluster* cluster{cluster_of(tx4)};
+    BOOST_CHECK_EQUAL(cluster, cluster_of(tx1));
+    BOOST_REQUIRE_EQUAL(cluster->txs.size(), 3U);
+    BOOST_CHECK_EQUAL(cluster->txs[2], &*pool.GetIter(tx4->GetHash()).value());
+    BOOST_REQUIRE_EQUAL(cluster->chunks.size(), 2U);
+    BOOST_CHECK_EQUAL(cluster->chunks[0].fee, 21000);
+    BOOST_CHECK_EQUAL(cluster->chunks[1].fee, 100);
+
+    // Prioritising tx4 moves it into the first chunk.
+    pool.PrioritiseTransaction(tx4->GetHash(), 100000LL);
+    BOOST_CHECK(cluster_of(tx4)->txs[0] == &*pool.GetIter(tx1->GetHash()).value());
+    BOOST_CHECK(cluster_of(tx4)->txs[1] == &*pool.GetIter(tx4->GetHash()).value());
+    pool.PrioritiseTransaction(tx4->GetHash(), -100000LL);
+
+    // Trimming evicts the worst chunk, which is tx4 alone.
+    pool.TrimToSize(pool.DynamicMemoryUsage() - 1);
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(tx4->GetHash())));
+    BOOST_CHECK(pool.exists(GenTxid::Txid(tx1->GetHash())));
+    BOOST_CHECK(pool.exists(GenTxid::Txid(tx2->GetHash())));
+    BOOST_CHECK(pool.exists(GenTxid::Txid(tx3->GetHash())));
+    BOOST_CHECK_EQUAL(pool.GetClusters().size(), 2U);
+
+    // Removing tx1 for a block splits nothing off, but leaves tx2 alone.
+    pool.removeForBlock({tx1}, 1);
+    BOOST_CHECK_EQUAL(pool.GetClusters().size(), 2U);
+    BOOST_CHECK_EQUAL(cluster_of(tx2)->txs.size(), 1U);
+
+    pool.removeRecursive(*tx2, REMOVAL_REASON_DUMMY);
+    pool.removeRecursive(*tx3, REMOVAL_REASON_DUMMY);
+    BOOST_CHECK(pool.GetClusters().empty());
+}
+
+struct ClusterLimitsTestingSetup : public TestingSetup {
+    ClusterLimitsTestingSetup() : TestingSetup{CBaseChainParams::REGTEST, {"-mempoolclusters=1", "-limitclustercount=3"}} {}
+};
+
+BOOST_FIXTURE_TEST_CASE(MempoolClusterLimitsTest, ClusterLimitsTestingSetup)
+{
+    Chainstate& chainstate{m_node.chainman->ActiveChainstate()};
+    CTxMemPool& pool{*Assert(m_node.mempool)};
+    LOCK2(cs_main, pool.cs);
+
+    std::vector<COutPoint> coins;
+    for (int i = 0; i < 2; ++i) {
+        coins.emplace_back(InsecureRand256(), 0);
+        chainstate.CoinsTip().AddCoin(coins.back(), Coin{CTxOut{10 * COIN, P2WSH_OP_TRUE}, /*nHeightIn=*/0, /*fCoinBaseIn=*/false}, /*possible_overwrite=*/false);
+    }
+    const auto spend{[](const std::vector<COutPoint>& prevouts, CAmount value, size_t num_outputs) {
+        CMutableTransaction tx;
+        for (const COutPoint& prevout : prevouts) {
+            tx.vin.emplace_back(prevout, CScript{}, MAX_BIP125_RBF_SEQUENCE);
+            tx.vin.back().scriptWitness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
+        }
+        for (size_t i = 0; i < num_outputs; ++i) {
+            tx.vout.emplace_back(value / num_outputs, P2WSH_OP_TRUE);
+        }
+        return MakeTransactionRef(tx);
+    }};
+    const auto accept{[&](const CTransactionRef& tx) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
+        return AcceptToMemoryPool(chainstate, tx, GetTime(), /*bypass_limits=*/false, /*test_accept=*/false);
+    }};
+
+    // [tx_a].0 <- [tx_b]
+    // [tx_c].0 <-/
+    const CTransactionRef tx_a{spend({coins[0]}, 10 * COIN - 10000, 2)};
+    const CTransactionRef tx_c{spend({coins[1]}, 10 * COIN - 10000, 1)};
+    const CTransactionRef tx_b{spend({{tx_a->GetHash(), 0}, {tx_c->GetHash(), 0}}, 15 * COIN - 25000, 1)};
+    for (const auto& tx : {tx_a, tx_c, tx_b}) {
+        BOOST_CHECK_EQUAL(accept(tx).m_result_type, MempoolAcceptResult::ResultType::VALID);
+    }
+    BOOST_CHECK_EQUAL(WITH_LOCK(pool.cs, return pool.GetClusters().size()), 1U);
+
+    // A child of tx_a would make the cluster exceed 3 transactions.
+    const CTransactionRef tx_d{spend({{tx_a->GetHash(), 1}}, 5 * COIN - 15000, 1)};
+    const auto result_d{accept(tx_d)};
+    BOOST_CHECK_EQUAL(result_d.m_result_type, MempoolAcceptResult::ResultType::INVALID);
+    BOOST_CHECK_EQUAL(result_d.m_state.GetRejectReason(), "too-large-cluster");
+    std::string err_string;
+    BOOST_CHECK(!pool.CheckPackageLimits({tx_d}, DEFAULT_ANCESTOR_LIMIT, DEFAULT_ANCESTOR_SIZE_LIMIT_KVB * 1000,
+                                         DEFAULT_DESCENDANT_LIMIT, DEFAULT_DESCENDANT_SIZE_LIMIT_KVB * 1000, err_string));
+    BOOST_CHECK_EQUAL(err_string, "too many transactions in cluster [limit: 3]");
+
+    // A replacement of tx_b doesn't count tx_b, so the cluster keeps 3 transactions.
+    const CTransactionRef tx_b2{spend({{tx_a->GetHash(), 0}, {tx_c->GetHash(), 0}}, 15 * COIN - 45000, 1)};
+    BOOST_CHECK_EQUAL(accept(tx_b2).m_result_type, MempoolAcceptResult::ResultType::VALID);
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(tx_b->GetHash())));
+    BOOST_CHECK_EQUAL(pool.size(), 3U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -18,8 +18,11 @@
 #include <util/system.h>
 #include <util/time.h>
 #include <validation.h>
+#include <validationinterface.h>
 #include <versionbits.h>
 
+#include <test/util/mining.h>
+#include <test/util/script.h>
 #include <test/util/setup_common.h>
 
 #include <memory>
@@ -27,6 +30,7 @@
 #include <boost/test/unit_test.hpp>
 
 using node::BlockAssembler;
+using node::BlockTemplateCache;
 using node::CBlockTemplate;
 
 namespace miner_tests {
@@ -613,4 +617,62 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     fCheckpointsEnabled = true;
 }
 
+BOOST_FIXTURE_TEST_CASE(block_template_cache, RegTestingSetup)
+{
+    std::vector<CTxIn> coinbase_outpoints;
+    for (int i = 0; i < COINBASE_MATURITY + 2; ++i) {
+        coinbase_outpoints.push_back(MineBlock(m_node, P2WSH_OP_TRUE));
+    }
+    const auto spend{[&](const CTxIn& txin, CAmount value) {
+        CMutableTransaction tx;
+        tx.vin.push_back(txin);
+        tx.vin.back().scriptWitness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
+        tx.vout.emplace_back(value, P2WSH_OP_TRUE);
+        const CTransactionRef tx_ref{MakeTransactionRef(tx)};
+        const MempoolAcceptResult res{WITH_LOCK(cs_main, return m_node.chainman->ProcessTransaction(tx_ref))};
+        BOOST_REQUIRE(res.m_result_type == MempoolAcceptResult::ResultType::VALID);
+        return tx_ref;
+    }};
+
+    BlockTemplateCache cache{*m_node.chainman, *m_node.mempool, P2WSH_OP_TRUE};
+    RegisterValidationInterface(&cache);
+
+    const auto check_template{[&](const std::vector<CTransactionRef>& txs) {
+        SyncWithValidationInterfaceQueue();
+        const auto block_template{cache.Get()};
+        const CBlock& block{block_template->block};
+        BOOST_REQUIRE_EQUAL(block.vtx.size(), txs.size() + 1);
+        CAmount fees{0};
+        for (size_t i = 0; i < txs.size(); ++i) {
+            BOOST_CHECK(block.vtx[i + 1]->GetHash() == txs[i]->GetHash());
+            fees += block_template->vTxFees[i + 1];
+        }
+        LOCK(cs_main);
+        CBlockIndex* tip{m_node.chainman->ActiveChain().Tip()};
+        BOOST_CHECK(block.hashPrevBlock == tip->GetBlockHash());
+        BOOST_CHECK_EQUAL(block.vtx[0]->GetValueOut(), fees + GetBlockSubsidy(tip->nHeight + 1, Params().GetConsensus()));
+        BlockValidationState state;
+        CBlock test_block{block};
+        test_block.hashMerkleRoot = BlockMerkleRoot(test_block);
+        BOOST_CHECK(TestBlockValidity(state, Params(), m_node.chainman->ActiveChainstate(), test_block, tip, GetAdjustedTime, false, false));
+    }};
+    check_template({});
+
+    // Transactions whose parents are in the template are appended to it.
+    const CTransactionRef parent{spend(coinbase_outpoints[0], 49 * COIN)};
+    const CTransactionRef child{spend(CTxIn{parent->GetHash(), 0}, 48 * COIN)};
+    const CTransactionRef other{spend(coinbase_outpoints[1], 49 * COIN)};
+    check_template({parent, child, other});
+
+    // Removing a transaction removes its descendants too.
+    WITH_LOCK(m_node.mempool->cs, m_node.mempool->removeRecursive(*parent, MemPoolRemovalReason::EXPIRY));
+    check_template({other});
+
+    // A new tip replaces the template.
+    MineBlock(m_node, P2WSH_OP_TRUE);
+    check_template({});
+
+    UnregisterValidationInterface(&cache);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
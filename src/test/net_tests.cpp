@@ -907,4 +907,54 @@ BOOST_AUTO_TEST_CASE(initial_advertise_from_version_message)
     TestOnlyResetTimeData();
 }
 
+BOOST_AUTO_TEST_CASE(v1_deserializer_payload_buffer)
+{
+    // A message with a payload several times the size of the receive buffer.
+    constexpr size_t buf_size{0x10000};
+    std::vector<unsigned char> payload(5 * buf_size / 2);
+    for (size_t i = 0; i < payload.size(); ++i) payload[i] = i % 251;
+    CSerializedNetMsg msg{CNetMsgMaker{INIT_PROTO_VERSION}.Make(NetMsgType::BLOCK, payload)};
+    std::vector<unsigned char> header;
+    V1TransportSerializer{}.prepareForTransport(msg, header);
+
+    V1TransportDeserializer deserializer{Params(), /*node_id=*/0, SER_NETWORK, INIT_PROTO_VERSION};
+    // No buffer is handed out while receiving the header.
+    BOOST_CHECK(deserializer.GetPayloadBuffer(buf_size).empty());
+    Span<const uint8_t> header_bytes{header};
+    BOOST_CHECK_EQUAL(deserializer.Read(header_bytes), int(header.size()));
+    BOOST_CHECK(header_bytes.empty());
+
+    Span<const uint8_t> data{msg.data};
+    size_t in_place{0};
+    while (!data.empty()) {
+        const Span<uint8_t> buf{deserializer.GetPayloadBuffer(buf_size)};
+        Span<const uint8_t> received;
+        if (buf.empty()) {
+            received = data.first(std::min(buf_size, data.size()));
+        } else {
+            BOOST_CHECK_EQUAL(buf.size(), buf_size);
+            std::copy(data.begin(), data.begin() + buf.size(), buf.begin());
+            received = buf;
+            ++in_place;
+        }
+        data = data.subspan(received.size());
+        while (!received.empty()) {
+            BOOST_CHECK(deserializer.Read(received) > 0);
+        }
+        BOOST_CHECK(deserializer.GetBufferSize() >= payload.size() - data.size());
+    }
+    // The last half buffer is copied.
+    BOOST_CHECK_EQUAL(in_place, 2U);
+
+    BOOST_REQUIRE(deserializer.Complete());
+    bool reject_message{true};
+    CNetMessage result{deserializer.GetMessage(0us, reject_message)};
+    BOOST_CHECK(!reject_message);
+    BOOST_CHECK_EQUAL(result.m_type, NetMsgType::BLOCK);
+    std::vector<unsigned char> result_payload;
+    result.m_recv >> result_payload;
+    BOOST_CHECK(result_payload == payload);
+    BOOST_CHECK(deserializer.GetPayloadBuffer(buf_size).empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
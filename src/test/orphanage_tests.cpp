@@ -135,4 +135,74 @@ BOOST_AUTO_TEST_CASE(DoS_mapOrphans)
     BOOST_CHECK(orphanage.CountOrphans() == 0);
 }
 
+static CTransactionRef MakeOrphan(size_t script_size)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout.hash = InsecureRand256();
+    tx.vin[0].scriptSig << std::vector<unsigned char>(script_size, 1);
+    tx.vout.resize(2);
+    tx.vout[0].nValue = 1*CENT;
+    tx.vout[1].nValue = 1*CENT;
+    return MakeTransactionRef(tx);
+}
+
+BOOST_AUTO_TEST_CASE(orphan_weight_limits)
+{
+    TxOrphanageTest orphanage;
+
+    // Peer 1 floods large orphans, peer 2 sends a few small ones.
+    int64_t large_weight{0};
+    for (int i = 0; i < 30; i++) {
+        const CTransactionRef tx{MakeOrphan(90000)};
+        large_weight = GetTransactionWeight(*tx);
+        BOOST_CHECK(WITH_LOCK(g_cs_orphans, return orphanage.AddTx(tx, 1)));
+    }
+    std::vector<CTransactionRef> small_orphans;
+    for (int i = 0; i < 5; i++) {
+        small_orphans.push_back(MakeOrphan(100));
+        BOOST_CHECK(WITH_LOCK(g_cs_orphans, return orphanage.AddTx(small_orphans.back(), 2)));
+    }
+    TxOrphanage::Info info{orphanage.GetInfo()};
+    BOOST_CHECK_EQUAL(info.count, 35U);
+    BOOST_CHECK_EQUAL(info.peers.at(1).weight, 30 * large_weight);
+
+    // Only the flooding peer's orphans are evicted.
+    WITH_LOCK(g_cs_orphans, orphanage.LimitOrphans(100));
+    info = orphanage.GetInfo();
+    BOOST_CHECK(info.peers.at(1).weight <= MAX_PEER_ORPHAN_WEIGHT);
+    BOOST_CHECK(info.peers.at(1).weight > MAX_PEER_ORPHAN_WEIGHT - large_weight);
+    BOOST_CHECK_EQUAL(info.peers.at(2).count, 5U);
+    BOOST_CHECK_EQUAL(info.evicted, 30 - info.peers.at(1).count);
+    int64_t total_weight{0};
+    for (const auto& [peer, peer_info] : info.peers) total_weight += peer_info.weight;
+    BOOST_CHECK_EQUAL(info.weight, total_weight);
+
+    // When over the count limit, the heaviest peer is evicted from first.
+    WITH_LOCK(g_cs_orphans, orphanage.LimitOrphans(5));
+    info = orphanage.GetInfo();
+    BOOST_CHECK_EQUAL(info.count, 5U);
+    BOOST_CHECK_EQUAL(info.peers.size(), 1U);
+    BOOST_CHECK_EQUAL(info.peers.at(2).count, 5U);
+
+    // Children of a block's transactions are reported by the peer that sent them.
+    CMutableTransaction child;
+    child.vin.emplace_back(small_orphans[0]->GetHash(), 0);
+    child.vin.emplace_back(small_orphans[0]->GetHash(), 1);
+    BOOST_CHECK(WITH_LOCK(g_cs_orphans, return orphanage.AddTx(MakeTransactionRef(child), 3)));
+    CBlock block;
+    block.vtx = {small_orphans[0], small_orphans[1]};
+    const auto children{WITH_LOCK(g_cs_orphans, return orphanage.GetChildrenFromBlock(block))};
+    BOOST_CHECK_EQUAL(children.size(), 1U);
+    BOOST_CHECK(children.at(3) == std::set<uint256>{child.GetHash()});
+    BOOST_CHECK_EQUAL(orphanage.GetInfo().block_parent_arrivals, 1U);
+
+    WITH_LOCK(g_cs_orphans, orphanage.EraseForPeer(2));
+    WITH_LOCK(g_cs_orphans, orphanage.EraseForPeer(3));
+    info = orphanage.GetInfo();
+    BOOST_CHECK_EQUAL(info.count, 0U);
+    BOOST_CHECK_EQUAL(info.weight, 0);
+    BOOST_CHECK(info.peers.empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
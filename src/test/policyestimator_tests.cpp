@@ -179,6 +179,23 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
     for (int i = 2; i < 9; i++) { // At 9, the original estimate was already at the bottom (b/c scale = 2)
         BOOST_CHECK(feeEst.estimateFee(i).GetFeePerK() < origFeeEst[i-1] - deltaFee);
     }
+
+    // Smart fee estimates are cached until the next block is processed
+    FeeCalculation feeCalc;
+    const CFeeRate smartFee{feeEst.estimateSmartFee(2, &feeCalc, /*conservative=*/false)};
+    BOOST_CHECK(smartFee != CFeeRate(0));
+    for (int i = 0; i < 3; i++) {
+        FeeCalculation cachedCalc;
+        BOOST_CHECK(feeEst.estimateSmartFee(2, &cachedCalc, /*conservative=*/false) == smartFee);
+        BOOST_CHECK_EQUAL(cachedCalc.desiredTarget, feeCalc.desiredTarget);
+        BOOST_CHECK_EQUAL(cachedCalc.returnedTarget, feeCalc.returnedTarget);
+        BOOST_CHECK(cachedCalc.reason == feeCalc.reason);
+    }
+    // The next block decays the recorded history
+    mpool.removeForBlock(block, ++blocknum);
+    FeeCalculation newCalc;
+    feeEst.estimateSmartFee(2, &newCalc, /*conservative=*/false);
+    BOOST_CHECK(newCalc.est.pass.withinTarget < feeCalc.est.pass.withinTarget);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
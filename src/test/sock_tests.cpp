@@ -129,6 +129,68 @@ BOOST_AUTO_TEST_CASE(wait)
     waiter.join();
 }
 
+BOOST_AUTO_TEST_CASE(wait_set)
+{
+    int s[2];
+    CreateSocketPair(s);
+
+    const auto sock0 = std::make_shared<const Sock>(s[0]);
+    const auto sock1 = std::make_shared<const Sock>(s[1]);
+
+    SockWaitSet wait_set;
+    Sock::EventsPerSock occurred;
+    BOOST_CHECK(!wait_set.Wait(0ms, occurred));
+
+    wait_set.Set(sock0, Sock::RECV);
+    wait_set.Set(sock1, Sock::RECV);
+    BOOST_REQUIRE(wait_set.Wait(0ms, occurred));
+    BOOST_CHECK(occurred.empty());
+
+    BOOST_REQUIRE_EQUAL(sock1->Send("a", 1, 0), 1);
+    BOOST_REQUIRE(wait_set.Wait(1min, occurred));
+    BOOST_REQUIRE_EQUAL(occurred.size(), 1U);
+    BOOST_CHECK(occurred.begin()->first == sock0);
+    BOOST_CHECK_EQUAL(occurred.begin()->second.occurred, Sock::RECV);
+
+    // Change the requested events of one socket and remove the other one.
+    wait_set.Set(sock0, Sock::SEND);
+    wait_set.Remove(*sock1);
+    BOOST_CHECK_EQUAL(sock1.use_count(), 1);
+    BOOST_REQUIRE(wait_set.Wait(1min, occurred));
+    BOOST_REQUIRE_EQUAL(occurred.size(), 1U);
+    BOOST_CHECK(occurred.begin()->first == sock0);
+    BOOST_CHECK_EQUAL(occurred.begin()->second.occurred, Sock::SEND);
+
+    wait_set.Remove(*sock0);
+    occurred.clear();
+    BOOST_CHECK_EQUAL(sock0.use_count(), 1);
+    BOOST_CHECK(!wait_set.Wait(0ms, occurred));
+}
+
+#ifdef USE_EPOLL
+BOOST_AUTO_TEST_CASE(wait_set_change_while_waiting)
+{
+    int s[2];
+    CreateSocketPair(s);
+
+    const auto sock0 = std::make_shared<const Sock>(s[0]);
+    const auto sock1 = std::make_shared<const Sock>(s[1]);
+
+    SockWaitSet wait_set;
+    wait_set.Set(sock0, Sock::RECV);
+
+    // Requesting write readiness from another thread is seen by a wait that
+    // is already in progress.
+    std::thread changer([&] { wait_set.Set(sock1, Sock::SEND); });
+    Sock::EventsPerSock occurred;
+    BOOST_REQUIRE(wait_set.Wait(1min, occurred));
+    changer.join();
+    BOOST_REQUIRE_EQUAL(occurred.size(), 1U);
+    BOOST_CHECK(occurred.begin()->first == sock1);
+    BOOST_CHECK_EQUAL(occurred.begin()->second.occurred, Sock::SEND);
+}
+#endif // USE_EPOLL
+
 BOOST_AUTO_TEST_CASE(recv_until_terminator_limit)
 {
     constexpr auto timeout = 1min; // High enough so that it is never hit.
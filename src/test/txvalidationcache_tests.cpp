@@ -8,6 +8,7 @@
 #include <script/sign.h>
 #include <script/signingprovider.h>
 #include <script/standard.h>
+#include <test/util/script.h>
 #include <test/util/setup_common.h>
 #include <txmempool.h>
 #include <validation.h>
@@ -19,6 +20,11 @@ struct Dersig100Setup : public TestChain100Setup {
         : TestChain100Setup{CBaseChainParams::REGTEST, {"-testactivationheight=dersig@102"}} {}
 };
 
+struct PrecheckTestingSetup : public TestingSetup {
+    PrecheckTestingSetup()
+        : TestingSetup{CBaseChainParams::REGTEST, {"-limitancestorcount=2"}} {}
+};
+
 bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
                        const CCoinsViewCache& inputs, unsigned int flags, bool cacheSigStore,
                        bool cacheFullScriptStore, PrecomputedTransactionData& txdata,
@@ -379,4 +385,89 @@ BOOST_FIXTURE_TEST_CASE(checkinputs_test, Dersig100Setup)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(precheck_transaction_scripts, PrecheckTestingSetup)
+{
+    ChainstateManager& chainman{*m_node.chainman};
+    std::vector<COutPoint> coins;
+    {
+        LOCK(cs_main);
+        for (int i = 0; i < 4; ++i) {
+            coins.emplace_back(InsecureRand256(), 0);
+            chainman.ActiveChainstate().CoinsTip().AddCoin(coins.back(), Coin{CTxOut{10 * COIN, P2WSH_OP_TRUE}, /*nHeightIn=*/0, /*fCoinBaseIn=*/false}, /*possible_overwrite=*/false);
+        }
+    }
+    const auto spend{[](const COutPoint& prevout, CAmount value, const std::vector<uint8_t>& witness_script = WITNESS_STACK_ELEM_OP_TRUE) {
+        CMutableTransaction tx;
+        tx.vin.emplace_back(prevout);
+        tx.vin.back().scriptWitness.stack.push_back(witness_script);
+        tx.vout.emplace_back(value, P2WSH_OP_TRUE);
+        return MakeTransactionRef(tx);
+    }};
+    // Whether the scripts of tx are in the script execution cache for flags.
+    const auto in_script_cache{[&](const CTransactionRef& tx, unsigned int flags) {
+        LOCK(cs_main);
+        TxValidationState state;
+        PrecomputedTransactionData txdata;
+        txdata.Init(*tx, {CTxOut{10 * COIN, P2WSH_OP_TRUE}});
+        std::vector<CScriptCheck> checks;
+        BOOST_CHECK(CheckInputScripts(*tx, state, chainman.ActiveChainstate().CoinsTip(), flags, false, false, txdata, &checks));
+        return checks.empty();
+    }};
+
+    // A valid transaction is verified without storing anything in the
+    // caches. Accepting it uses the result and caches the script execution.
+    const CTransactionRef tx{spend(coins[0], 10 * COIN - 10000)};
+    const auto prechecked{chainman.PrecheckTransactionScripts(tx)};
+    BOOST_REQUIRE(prechecked);
+    BOOST_CHECK(prechecked->m_state.IsValid());
+    BOOST_CHECK(!in_script_cache(tx, prechecked->m_script_flags));
+    {
+        LOCK(cs_main);
+        BOOST_CHECK_EQUAL(chainman.ProcessTransaction(tx, /*test_accept=*/false, &*prechecked).m_result_type, MempoolAcceptResult::ResultType::VALID);
+    }
+    BOOST_CHECK(in_script_cache(tx, prechecked->m_script_flags));
+
+    // Conflicting transactions and transactions that fail the cheaper checks
+    // are not verified.
+    BOOST_CHECK(!chainman.PrecheckTransactionScripts(spend(coins[0], 10 * COIN - 20000)));
+    BOOST_CHECK(!chainman.PrecheckTransactionScripts(spend(coins[1], 10 * COIN)));
+    BOOST_CHECK(!chainman.PrecheckTransactionScripts(spend(COutPoint{InsecureRand256(), 0}, COIN)));
+    // Nor are transactions that exceed the package limits: tx's grandchild
+    // would have 2 in-mempool ancestors.
+    const CTransactionRef child{spend({tx->GetHash(), 0}, 10 * COIN - 20000)};
+    BOOST_REQUIRE(chainman.PrecheckTransactionScripts(child));
+    {
+        LOCK(cs_main);
+        BOOST_CHECK_EQUAL(chainman.ProcessTransaction(child).m_result_type, MempoolAcceptResult::ResultType::VALID);
+    }
+    BOOST_CHECK(!chainman.PrecheckTransactionScripts(spend({child->GetHash(), 0}, 10 * COIN - 30000)));
+
+    // The failure of a transaction with invalid scripts is remembered, and
+    // mempool acceptance reports it without verifying the scripts again.
+    const CTransactionRef invalid_tx{spend(coins[1], 10 * COIN - 10000, {uint8_t{OP_2}})};
+    const auto invalid_prechecked{chainman.PrecheckTransactionScripts(invalid_tx)};
+    BOOST_REQUIRE(invalid_prechecked);
+    BOOST_CHECK_EQUAL(invalid_prechecked->m_state.GetRejectReason(), "non-mandatory-script-verify-flag (Witness program hash mismatch)");
+    BOOST_CHECK(!in_script_cache(invalid_tx, invalid_prechecked->m_script_flags));
+    {
+        LOCK(cs_main);
+        const auto result{chainman.ProcessTransaction(invalid_tx, /*test_accept=*/false, &*invalid_prechecked)};
+        BOOST_CHECK_EQUAL(result.m_result_type, MempoolAcceptResult::ResultType::INVALID);
+        BOOST_CHECK_EQUAL(result.m_state.GetRejectReason(), invalid_prechecked->m_state.GetRejectReason());
+    }
+    const CTransactionRef tx2{spend(coins[2], 10 * COIN - 10000)};
+    PrecheckedScripts failed{*Assert(chainman.PrecheckTransactionScripts(tx2))};
+    failed.m_state.Invalid(TxValidationResult::TX_CONSENSUS, "remembered-failure");
+    {
+        LOCK(cs_main);
+        BOOST_CHECK_EQUAL(chainman.ProcessTransaction(tx2, /*test_accept=*/true, &failed).m_state.GetRejectReason(), "remembered-failure");
+    }
+    // A result for other spent outputs is not used.
+    failed.m_spent_outputs[0].nValue -= 1;
+    {
+        LOCK(cs_main);
+        BOOST_CHECK_EQUAL(chainman.ProcessTransaction(tx2, /*test_accept=*/false, &failed).m_result_type, MempoolAcceptResult::ResultType::VALID);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -4,12 +4,17 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 //
 #include <chainparams.h>
+#include <clientversion.h>
+#include <coins.h>
 #include <consensus/validation.h>
+#include <fs.h>
+#include <hash.h>
 #include <node/utxo_snapshot.h>
 #include <random.h>
 #include <rpc/blockchain.h>
 #include <sync.h>
 #include <test/util/chainstate.h>
+#include <test/util/logging.h>
 #include <test/util/setup_common.h>
 #include <uint256.h>
 #include <validation.h>
@@ -17,6 +22,7 @@
 
 #include <tinyformat.h>
 
+#include <cstdio>
 #include <vector>
 
 #include <boost/test/unit_test.hpp>
@@ -193,17 +199,49 @@ BOOST_FIXTURE_TEST_CASE(chainstatemanager_activate_snapshot, TestChain100Setup)
     initial_total_coins += 10;
 
     // Should not load malleated snapshots
-    BOOST_REQUIRE(!CreateAndActivateUTXOSnapshot(
-        m_node, m_path_root, [](AutoFile& auto_infile, SnapshotMetadata& metadata) {
-            // A UTXO is missing but count is correct
-            metadata.m_coins_count -= 1;
-
-            COutPoint outpoint;
-            Coin coin;
-
-            auto_infile >> outpoint;
-            auto_infile >> coin;
-    }));
+    {
+        ASSERT_DEBUG_LOG("bad snapshot content hash");
+        BOOST_REQUIRE(!CreateAndActivateUTXOSnapshot(
+            m_node, m_path_root, [&](AutoFile& auto_infile, SnapshotMetadata& metadata) {
+                // A UTXO is missing but counts, checksums and the chunk index
+                // are correct, so that only the content hash gives it away
+                std::vector<node::SnapshotChunkHeader> headers(metadata.m_chunk_count);
+                std::vector<CDataStream> chunks(metadata.m_chunk_count, CDataStream{SER_DISK, CLIENT_VERSION});
+                for (uint64_t i = 0; i < metadata.m_chunk_count; ++i) {
+                    auto_infile >> headers[i];
+                    chunks[i].resize(headers[i].size);
+                    auto_infile.read(MakeWritableByteSpan(chunks[i]));
+                }
+                COutPoint outpoint;
+                Coin coin;
+                chunks[0] >> outpoint >> coin;
+                headers[0] = {headers[0].coins_count - 1, uint32_t(chunks[0].size()), Hash(chunks[0])};
+                metadata.m_coins_count -= 1;
+
+                std::vector<uint64_t> offsets;
+                uint64_t offset{node::SNAPSHOT_METADATA_SIZE};
+                for (const CDataStream& chunk : chunks) {
+                    offsets.push_back(offset);
+                    offset += node::SNAPSHOT_CHUNK_HEADER_SIZE + chunk.size();
+                }
+                metadata.m_index_offset = offset;
+
+                const fs::path path{m_path_root / "malleated_snapshot.dat"};
+                {
+                    AutoFile auto_outfile{fsbridge::fopen(path, "wb")};
+                    auto_outfile << metadata;
+                    for (uint64_t i = 0; i < metadata.m_chunk_count; ++i) {
+                        auto_outfile << headers[i];
+                        auto_outfile.write(MakeByteSpan(chunks[i]));
+                    }
+                    for (const uint64_t chunk_offset : offsets) auto_outfile << chunk_offset;
+                }
+                // Continue from the same place in the malleated file.
+                BOOST_REQUIRE(std::freopen(fs::PathToString(path).c_str(), "rb", auto_infile.Get()));
+                SnapshotMetadata malleated_metadata;
+                auto_infile >> malleated_metadata;
+        }));
+    }
     BOOST_REQUIRE(!CreateAndActivateUTXOSnapshot(
         m_node, m_path_root, [](AutoFile& auto_infile, SnapshotMetadata& metadata) {
             // Coins count is larger than coins in file
@@ -4,16 +4,37 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <chainparams.h>
+#include <coins.h>
 #include <consensus/amount.h>
+#include <kernel/coinstats.h>
 #include <net.h>
+#include <node/utxo_snapshot.h>
+#include <rpc/blockchain.h>
 #include <signet.h>
+#include <streams.h>
+#include <txdb.h>
 #include <uint256.h>
 #include <validation.h>
 
 #include <test/util/setup_common.h>
 
+#include <univalue.h>
+
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <cstdio>
+#include <optional>
+#include <utility>
+#include <vector>
+
+using kernel::CCoinsStats;
+using kernel::CoinStatsHashType;
+using kernel::ComputeUTXOStats;
+using node::SNAPSHOT_VERSION;
+using node::SNAPSHOT_VERSION_UNCHUNKED;
+using node::SnapshotMetadata;
+
 BOOST_FIXTURE_TEST_SUITE(validation_tests, TestingSetup)
 
 static void TestBlockSubsidyHalvings(const Consensus::Params& consensusParams)
@@ -129,20 +150,154 @@ BOOST_AUTO_TEST_CASE(test_assumeutxo)
 
     // These heights don't have assumeutxo configurations associated, per the contents
     // of chainparams.cpp.
-    std::vector<int> bad_heights{0, 100, 111, 115, 209, 211};
+    std::vector<int> bad_heights{0, 100, 110, 198, 200, 210};
 
     for (auto empty : bad_heights) {
         const auto out = ExpectedAssumeutxo(empty, *params);
         BOOST_CHECK(!out);
     }
 
-    const auto out110 = *ExpectedAssumeutxo(110, *params);
-    BOOST_CHECK_EQUAL(out110.hash_serialized.ToString(), "1ebbf5850204c0bdb15bf030f47c7fe91d45c44c712697e4509ba67adb01c618");
-    BOOST_CHECK_EQUAL(out110.nChainTx, 110U);
+    const auto out199 = *ExpectedAssumeutxo(199, *params);
+    BOOST_CHECK_EQUAL(out199.hash_serialized.ToString(), "b3b33b135ceef5f57043e91168d2ca657ad41efeafbd7233b5e90fad4cf61f07");
+    BOOST_CHECK_EQUAL(out199.nChainTx, 200U);
+}
+
+BOOST_AUTO_TEST_CASE(load_snapshot_coins)
+{
+    const uint256 base_hash{m_node.chainman->GetParams().GenesisBlock().GetHash()};
+
+    // Enough coins for several chunks, including a transaction with outputs
+    // whose indexes aren't in database key order.
+    std::vector<std::pair<COutPoint, Coin>> coins;
+    const auto add_tx{[&](uint32_t outputs) {
+        const uint256 txid{InsecureRand256()};
+        for (uint32_t n = 0; n < outputs; ++n) {
+            CScript script;
+            script << OP_DUP << OP_HASH160 << g_insecure_rand_ctx.randbytes(20) << OP_EQUALVERIFY << OP_CHECKSIG;
+            coins.emplace_back(COutPoint{txid, n}, Coin{CTxOut{CAmount(1 + InsecureRandRange(COIN)), script}, /*nHeightIn=*/0, /*fCoinBaseIn=*/false});
+        }
+    }};
+    add_tx(20000);
+    while (coins.size() < 250000) add_tx(1 + InsecureRandRange(3));
+    std::sort(coins.begin(), coins.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    const fs::path path{m_args.GetDataDirBase() / "snapshot.dat"};
+    const auto write_snapshot{[&](uint64_t coins_count) {
+        AutoFile file{fsbridge::fopen(path, "wb")};
+        SnapshotMetadata metadata{base_hash, coins_count, /*nchaintx=*/0};
+        metadata.m_version = SNAPSHOT_VERSION_UNCHUNKED;
+        file << metadata;
+        for (const auto& [outpoint, coin] : coins) file << outpoint << coin;
+    }};
+    // Load the snapshot into a new database and return the computed and
+    // actual statistics of its coins.
+    const auto load{[&](int base_height) -> std::optional<std::pair<std::optional<CCoinsStats>, CCoinsStats>> {
+        AutoFile file{fsbridge::fopen(path, "rb")};
+        SnapshotMetadata metadata;
+        file >> metadata;
+        CCoinsViewDB db{m_args.GetDataDirBase() / "snapshot_db", 1 << 23, /*fMemory=*/true, /*fWipe=*/false};
+        std::optional<CCoinsStats> stats;
+        if (!LoadSnapshotCoins(file, metadata, base_height, db, stats)) return std::nullopt;
+        CCoinsViewCache cache{&db};
+        cache.SetBestBlock(base_hash);
+        BOOST_REQUIRE(cache.Flush());
+        return std::make_pair(stats, *Assert(ComputeUTXOStats(CoinStatsHashType::HASH_SERIALIZED, &db, m_node.chainman->m_blockman, [] {})));
+    }};
+
+    write_snapshot(coins.size());
+    const auto sorted{load(/*base_height=*/0)};
+    BOOST_REQUIRE(sorted && sorted->first);
+    BOOST_CHECK_EQUAL(sorted->first->hashSerialized, sorted->second.hashSerialized);
+    BOOST_CHECK_EQUAL(sorted->first->coins_count, coins.size());
+    BOOST_CHECK_EQUAL(sorted->first->nTransactions, sorted->second.nTransactions);
+    BOOST_CHECK_EQUAL(sorted->second.coins_count, coins.size());
+
+    // Unsorted coins are loaded all the same, but must be hashed from the database.
+    std::reverse(coins.begin(), coins.end());
+    write_snapshot(coins.size());
+    const auto unsorted{load(/*base_height=*/0)};
+    BOOST_REQUIRE(unsorted);
+    BOOST_CHECK(!unsorted->first);
+    BOOST_CHECK_EQUAL(unsorted->second.hashSerialized, sorted->second.hashSerialized);
+
+    // Truncated snapshot, coins left over, and a coin younger than the base
+    write_snapshot(coins.size() + 1);
+    BOOST_CHECK(!load(/*base_height=*/0));
+    write_snapshot(coins.size() - 1);
+    BOOST_CHECK(!load(/*base_height=*/0));
+    coins[coins.size() / 2].second.nHeight = 1;
+    write_snapshot(coins.size());
+    BOOST_CHECK(!load(/*base_height=*/0));
+    BOOST_CHECK(load(/*base_height=*/1));
+}
+
+BOOST_AUTO_TEST_CASE(dump_chunked_snapshot)
+{
+    Chainstate& chainstate{m_node.chainman->ActiveChainstate()};
+    const uint256 base_hash{m_node.chainman->GetParams().GenesisBlock().GetHash()};
+
+    // Enough coins to be dumped in several ranges
+    {
+        LOCK(cs_main);
+        CCoinsViewCache& coins_tip{chainstate.CoinsTip()};
+        for (uint32_t i = 0; i < 150000; ++i) {
+            CScript script;
+            script << OP_DUP << OP_HASH160 << g_insecure_rand_ctx.randbytes(20) << OP_EQUALVERIFY << OP_CHECKSIG;
+            coins_tip.AddCoin(COutPoint{InsecureRand256(), uint32_t(InsecureRandRange(3))},
+                              Coin{CTxOut{CAmount(1 + InsecureRandRange(COIN)), script}, /*nHeightIn=*/0, /*fCoinBaseIn=*/false},
+                              /*possible_overwrite=*/false);
+        }
+        coins_tip.SetBestBlock(base_hash);
+    }
+
+    const fs::path path{m_args.GetDataDirBase() / "snapshot.dat"};
+    UniValue result;
+    {
+        AutoFile file{fsbridge::fopen(path, "wb")};
+        result = CreateUTXOSnapshot(m_node, chainstate, file, path, path);
+    }
+    BOOST_CHECK_EQUAL(result["coins_written"].getInt<uint64_t>(), 150000U);
+    BOOST_CHECK(result["chunks"].getInt<uint64_t>() >= 150000 / node::SNAPSHOT_CHUNK_MAX_COINS);
+
+    const auto load{[&]() -> std::optional<CCoinsStats> {
+        AutoFile file{fsbridge::fopen(path, "rb")};
+        SnapshotMetadata metadata;
+        file >> metadata;
+        BOOST_CHECK_EQUAL(metadata.m_version, SNAPSHOT_VERSION);
+        BOOST_CHECK_EQUAL(metadata.m_chunk_count, result["chunks"].getInt<uint64_t>());
+        CCoinsViewDB db{m_args.GetDataDirBase() / "snapshot_db", 1 << 23, /*fMemory=*/true, /*fWipe=*/false};
+        std::optional<CCoinsStats> stats;
+        if (!LoadSnapshotCoins(file, metadata, /*base_height=*/0, db, stats)) return std::nullopt;
+        // Chunks are dumped in database order, so the statistics are computed while loading.
+        return *Assert(stats);
+    }};
+    const auto stats{load()};
+    BOOST_REQUIRE(stats);
+    BOOST_CHECK_EQUAL(stats->coins_count, 150000U);
+    BOOST_CHECK_EQUAL(stats->hashSerialized.ToString(), result["txoutset_hash"].get_str());
+
+    const auto flip_byte{[&](long pos) {
+        FILE* file{fsbridge::fopen(path, "rb+")};
+        BOOST_REQUIRE(file);
+        BOOST_REQUIRE_EQUAL(std::fseek(file, pos, SEEK_SET), 0);
+        const int byte{std::fgetc(file)};
+        BOOST_REQUIRE(byte != EOF);
+        BOOST_REQUIRE_EQUAL(std::fseek(file, pos, SEEK_SET), 0);
+        std::fputc(byte ^ 1, file);
+        std::fclose(file);
+    }};
+    // A coin of the first chunk, whose checksum no longer matches
+    const long coin_pos{long(node::SNAPSHOT_METADATA_SIZE + node::SNAPSHOT_CHUNK_HEADER_SIZE + 100)};
+    flip_byte(coin_pos);
+    BOOST_CHECK(!load());
+    flip_byte(coin_pos);
+    BOOST_CHECK(load());
 
-    const auto out210 = *ExpectedAssumeutxo(200, *params);
-    BOOST_CHECK_EQUAL(out210.hash_serialized.ToString(), "51c8d11d8b5c1de51543c579736e786aa2736206d1e11e627568029ce092cf62");
-    BOOST_CHECK_EQUAL(out210.nChainTx, 200U);
+    // The offset of the second chunk in the index
+    SnapshotMetadata metadata;
+    AutoFile{fsbridge::fopen(path, "rb")} >> metadata;
+    flip_byte(long(metadata.m_index_offset + sizeof(uint64_t)));
+    BOOST_CHECK(!load());
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -9,6 +9,7 @@
 
 #include <coins.h>
 #include <dbwrapper.h>
+#include <span.h>
 #include <sync.h>
 
 #include <memory>
@@ -47,6 +48,8 @@ static const int64_t nMaxCoinsDBCache = 8;
 // Actually declared in validation.cpp; can't include because of circular dependency.
 extern RecursiveMutex cs_main;
 
+class CCoinsViewDBCursor;
+
 /** CCoinsView backed by the coin database (chainstate/) */
 class CCoinsViewDB final : public CCoinsView
 {
@@ -64,9 +67,23 @@ public:
     bool HaveCoin(const COutPoint &outpoint) const override;
     uint256 GetBestBlock() const override;
     std::vector<uint256> GetHeadBlocks() const override;
-    bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) override;
+    bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase = true) override;
     std::unique_ptr<CCoinsViewCursor> Cursor() const override;
 
+    /**
+     * Like Cursor(), but the cursor can be moved around the coins with
+     * Seek(). Cursors see the database as it was when they were created, so
+     * several of them created together iterate over the same coins.
+     */
+    std::unique_ptr<CCoinsViewDBCursor> SeekableCursor() const;
+
+    /**
+     * Write coins straight to the database in one batch, bypassing any cache
+     * and leaving the best block alone. Meant for populating a new chainstate
+     * from a UTXO snapshot; several threads can write at once.
+     */
+    bool WriteCoins(Span<const std::pair<COutPoint, Coin>> coins);
+
     //! Whether an unsupported database format is used.
     bool NeedsUpgrade();
     size_t EstimateSize() const override;
@@ -75,6 +92,34 @@ public:
     void ResizeCache(size_t new_cache_size) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 };
 
+/** Specialization of CCoinsViewCursor to iterate over a CCoinsViewDB */
+class CCoinsViewDBCursor: public CCoinsViewCursor
+{
+public:
+    // Prefer using CCoinsViewDB::Cursor() since we want to perform some
+    // cache warmup on instantiation.
+    CCoinsViewDBCursor(CDBIterator* pcursorIn, const uint256&hashBlockIn):
+        CCoinsViewCursor(hashBlockIn), pcursor(pcursorIn) {}
+    ~CCoinsViewDBCursor() = default;
+
+    bool GetKey(COutPoint &key) const override;
+    bool GetValue(Coin &coin) const override;
+
+    bool Valid() const override;
+    void Next() override;
+
+    //! Move to the first coin at or after the given outpoint.
+    void Seek(const COutPoint& start);
+
+private:
+    void CacheKey();
+
+    std::unique_ptr<CDBIterator> pcursor;
+    std::pair<char, COutPoint> keyTmp;
+
+    friend class CCoinsViewDB;
+};
+
 /** Access to the block database (blocks/index/) */
 class CBlockTreeDB : public CDBWrapper
 {
@@ -25,6 +25,13 @@
 #include <cmath>
 #include <optional>
 
+/** Memory used by a cluster and its node in the set of clusters. */
+static size_t ClusterUsage(const CTxMemPool::ClusterSet& clusters, const TxMemPoolCluster& cluster)
+{
+    return memusage::IncrementalDynamicUsage(clusters) + memusage::MallocUsage(sizeof(TxMemPoolCluster)) +
+           memusage::DynamicUsage(cluster.txs) + memusage::DynamicUsage(cluster.chunks);
+}
+
 bool TestLockPointValidity(CChain& active_chain, const LockPoints& lp)
 {
     AssertLockHeld(cs_main);
@@ -81,8 +88,8 @@ size_t CTxMemPoolEntry::GetTxSize() const
 void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap& cachedDescendants,
                                       const std::set<uint256>& setExclude, std::set<uint256>& descendants_to_remove)
 {
-    CTxMemPoolEntry::Children stageEntries, descendants;
-    stageEntries = updateIt->GetMemPoolChildrenConst();
+    const CTxMemPoolEntry::Children& update_children = updateIt->GetMemPoolChildrenConst();
+    CTxMemPoolEntry::RefSet stageEntries{update_children.begin(), update_children.end()}, descendants;
 
     while (!stageEntries.empty()) {
         const CTxMemPoolEntry& descendant = *stageEntries.begin();
@@ -169,11 +176,14 @@ void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256>& vHashes
                 if (!visited(childIter) && !setAlreadyIncluded.count(childHash)) {
                     UpdateChild(it, childIter, true);
                     UpdateParent(childIter, it, true);
+                    MarkClusterDirty(*it);
+                    MarkClusterDirty(*childIter);
                 }
             }
         } // release epoch guard for UpdateForDescendants
         UpdateForDescendants(it, mapMemPoolDescendantsToUpdate, setAlreadyIncluded, descendants_to_remove);
     }
+    UpdateClusters();
 
     for (const auto& txid : descendants_to_remove) {
         // This txid may have been removed already in a prior call to removeRecursive.
@@ -187,7 +197,7 @@ void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256>& vHashes
 bool CTxMemPool::CalculateAncestorsAndCheckLimits(size_t entry_size,
                                                   size_t entry_count,
                                                   setEntries& setAncestors,
-                                                  CTxMemPoolEntry::Parents& staged_ancestors,
+                                                  CTxMemPoolEntry::RefSet& staged_ancestors,
                                                   uint64_t limitAncestorCount,
                                                   uint64_t limitAncestorSize,
                                                   uint64_t limitDescendantCount,
@@ -240,7 +250,7 @@ bool CTxMemPool::CheckPackageLimits(const Package& package,
                                     uint64_t limitDescendantSize,
                                     std::string &errString) const
 {
-    CTxMemPoolEntry::Parents staged_ancestors;
+    CTxMemPoolEntry::RefSet staged_ancestors;
     size_t total_size = 0;
     for (const auto& tx : package) {
         total_size += GetVirtualTransactionSize(*tx);
@@ -264,8 +274,56 @@ bool CTxMemPool::CheckPackageLimits(const Package& package,
                                                       limitAncestorCount, limitAncestorSize,
                                                       limitDescendantCount, limitDescendantSize, errString);
     // It's possible to overestimate the ancestor/descendant totals.
-    if (!ret) errString.insert(0, "possibly ");
-    return ret;
+    if (!ret) {
+        errString.insert(0, "possibly ");
+        return false;
+    }
+    return CheckClusterLimits(package, /*conflicts=*/{}, errString);
+}
+
+bool CTxMemPool::CheckClusterLimits(const Package& package, const setEntries& conflicts, std::string& errString) const
+{
+    AssertLockHeld(cs);
+    if (!m_track_clusters) return true;
+
+    setEntries replaced;
+    for (txiter it : conflicts) {
+        CalculateDescendants(it, replaced);
+    }
+
+    // Walk the cluster from the package's in-mempool parents, stopping as soon
+    // as it is known to be too large.
+    uint64_t cluster_size{0};
+    for (const auto& tx : package) {
+        cluster_size += GetVirtualTransactionSize(*tx);
+    }
+    setEntries cluster;
+    std::vector<txiter> todo;
+    const auto visit = [&](txiter it) EXCLUSIVE_LOCKS_REQUIRED(cs) {
+        if (replaced.count(it) || !cluster.insert(it).second) return;
+        todo.push_back(it);
+        cluster_size += it->GetTxSize();
+    };
+    for (const auto& tx : package) {
+        for (const auto& input : tx->vin) {
+            if (std::optional<txiter> piter = GetIter(input.prevout.hash)) visit(*piter);
+        }
+    }
+    while (true) {
+        if (cluster.size() + package.size() > uint64_t(m_limits.cluster_count)) {
+            errString = strprintf("too many transactions in cluster [limit: %u]", m_limits.cluster_count);
+            return false;
+        }
+        if (cluster_size > uint64_t(m_limits.cluster_size_vbytes)) {
+            errString = strprintf("exceeds cluster size limit [limit: %u]", m_limits.cluster_size_vbytes);
+            return false;
+        }
+        if (todo.empty()) return true;
+        const txiter it{todo.back()};
+        todo.pop_back();
+        for (const CTxMemPoolEntry& parent : it->GetMemPoolParentsConst()) visit(mapTx.iterator_to(parent));
+        for (const CTxMemPoolEntry& child : it->GetMemPoolChildrenConst()) visit(mapTx.iterator_to(child));
+    }
 }
 
 bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry,
@@ -277,7 +335,7 @@ bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry,
                                            std::string &errString,
                                            bool fSearchForParents /* = true */) const
 {
-    CTxMemPoolEntry::Parents staged_ancestors;
+    CTxMemPoolEntry::RefSet staged_ancestors;
     const CTransaction &tx = entry.GetTx();
 
     if (fSearchForParents) {
@@ -298,7 +356,7 @@ bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry,
         // If we're not searching for parents, we require this to already be an
         // entry in the mempool and use the entry's cached parents.
         txiter it = mapTx.iterator_to(entry);
-        staged_ancestors = it->GetMemPoolParentsConst();
+        staged_ancestors.insert(it->GetMemPoolParentsConst().begin(), it->GetMemPoolParentsConst().end());
     }
 
     return CalculateAncestorsAndCheckLimits(entry.GetTxSize(), /*entry_count=*/1,
@@ -436,6 +494,7 @@ CTxMemPool::CTxMemPool(const Options& opts)
       m_max_datacarrier_bytes{opts.max_datacarrier_bytes},
       m_require_standard{opts.require_standard},
       m_full_rbf{opts.full_rbf},
+      m_track_clusters{opts.track_clusters},
       m_limits{opts.limits}
 {
     _clear(); //lock free clear
@@ -507,6 +566,15 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
 
     vTxHashes.emplace_back(tx.GetWitnessHash(), newit);
     newit->vTxHashesIdx = vTxHashes.size() - 1;
+
+    if (m_track_clusters) {
+        // The new transaction joins the clusters of its parents.
+        m_unclustered.push_back(&*newit);
+        for (const CTxMemPoolEntry& parent : newit->GetMemPoolParentsConst()) {
+            MarkClusterDirty(parent);
+        }
+        UpdateClusters();
+    }
 }
 
 void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
@@ -541,7 +609,11 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     totalTxSize -= it->GetTxSize();
     m_total_fee -= it->GetFee();
     cachedInnerUsage -= it->DynamicMemoryUsage();
-    cachedInnerUsage -= memusage::DynamicUsage(it->GetMemPoolParentsConst()) + memusage::DynamicUsage(it->GetMemPoolChildrenConst());
+    cachedInnerUsage -= it->GetMemPoolParentsConst().DynamicMemoryUsage() + it->GetMemPoolChildrenConst().DynamicMemoryUsage();
+    if (it->m_cluster) {
+        it->m_cluster->txs[it->m_cluster_index] = nullptr;
+        m_dirty_clusters.insert(it->m_cluster);
+    }
     mapTx.erase(it);
     nTransactionsUpdated++;
     if (minerPolicyEstimator) {minerPolicyEstimator->removeTx(hash, false);}
@@ -661,6 +733,8 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigne
     }
     // Before the txs in the new block have been removed from the mempool, update policy estimates
     if (minerPolicyEstimator) {minerPolicyEstimator->processBlock(nBlockHeight, entries);}
+    // Rebuild the affected clusters once, rather than after every transaction.
+    m_defer_cluster_updates = true;
     for (const auto& tx : vtx)
     {
         txiter it = mapTx.find(tx->GetHash());
@@ -672,6 +746,8 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigne
         removeConflicts(*tx);
         ClearPrioritisation(tx->GetHash());
     }
+    m_defer_cluster_updates = false;
+    UpdateClusters();
     lastRollingFeeUpdate = GetTime();
     blockSinceLastRollingFeeBump = true;
 }
@@ -681,6 +757,10 @@ void CTxMemPool::_clear()
     vTxHashes.clear();
     mapTx.clear();
     mapNextTx.clear();
+    m_clusters.clear();
+    m_dirty_clusters.clear();
+    m_unclustered.clear();
+    m_cluster_usage = 0;
     totalTxSize = 0;
     m_total_fee = 0;
     cachedInnerUsage = 0;
@@ -718,8 +798,8 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
         check_total_fee += it->GetFee();
         innerUsage += it->DynamicMemoryUsage();
         const CTransaction& tx = it->GetTx();
-        innerUsage += memusage::DynamicUsage(it->GetMemPoolParentsConst()) + memusage::DynamicUsage(it->GetMemPoolChildrenConst());
-        CTxMemPoolEntry::Parents setParentCheck;
+        innerUsage += it->GetMemPoolParentsConst().DynamicMemoryUsage() + it->GetMemPoolChildrenConst().DynamicMemoryUsage();
+        CTxMemPoolEntry::RefSet setParentCheck;
         for (const CTxIn &txin : tx.vin) {
             // Check that every mempool transaction's inputs refer to available coins, or other mempool tx's.
             indexed_transaction_set::const_iterator it2 = mapTx.find(txin.prevout.hash);
@@ -768,7 +848,7 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
         prev_ancestor_count = it->GetCountWithAncestors();
 
         // Check children against mapNextTx
-        CTxMemPoolEntry::Children setChildrenCheck;
+        CTxMemPoolEntry::RefSet setChildrenCheck;
         auto iter = mapNextTx.lower_bound(COutPoint(it->GetTx().GetHash(), 0));
         uint64_t child_sizes = 0;
         for (; iter != mapNextTx.end() && iter->first->hash == it->GetTx().GetHash(); ++iter) {
@@ -802,6 +882,29 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
     assert(totalTxSize == checkTotal);
     assert(m_total_fee == check_total_fee);
     assert(innerUsage == cachedInnerUsage);
+
+    if (m_track_clusters) {
+        assert(m_dirty_clusters.empty() && m_unclustered.empty());
+        size_t clustered{0};
+        uint64_t cluster_usage{0};
+        for (const auto& cluster : m_clusters) {
+            size_t chunked{0};
+            for (const auto& chunk : cluster->chunks) chunked += chunk.count;
+            assert(chunked == cluster->txs.size());
+            for (size_t i = 0; i < cluster->txs.size(); ++i) {
+                const CTxMemPoolEntry& entry{*cluster->txs[i]};
+                assert(entry.m_cluster == cluster.get() && entry.m_cluster_index == i);
+                // Parents (and therefore children) are in the same cluster, and come first.
+                for (const CTxMemPoolEntry& parent : entry.GetMemPoolParentsConst()) {
+                    assert(parent.m_cluster == cluster.get() && parent.m_cluster_index < i);
+                }
+            }
+            clustered += cluster->txs.size();
+            cluster_usage += ClusterUsage(m_clusters, *cluster);
+        }
+        assert(clustered == mapTx.size());
+        assert(cluster_usage == m_cluster_usage);
+    }
 }
 
 bool CTxMemPool::CompareDepthAndScore(const uint256& hasha, const uint256& hashb, bool wtxid)
@@ -922,6 +1025,8 @@ void CTxMemPool::PrioritiseTransaction(const uint256& hash, const CAmount& nFeeD
             for (txiter descendantIt : setDescendants) {
                 mapTx.modify(descendantIt, [=](CTxMemPoolEntry& e){ e.UpdateAncestorState(0, nFeeDelta, 0, 0); });
             }
+            MarkClusterDirty(*it);
+            UpdateClusters();
             ++nTransactionsUpdated;
         }
     }
@@ -1010,7 +1115,7 @@ void CCoinsViewMemPool::PackageAddTransaction(const CTransactionRef& tx)
 size_t CTxMemPool::DynamicMemoryUsage() const {
     LOCK(cs);
     // Estimate the overhead of mapTx to be 15 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
-    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(vTxHashes) + cachedInnerUsage;
+    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(vTxHashes) + cachedInnerUsage + m_cluster_usage;
 }
 
 void CTxMemPool::RemoveUnbroadcastTx(const uint256& txid, const bool unchecked) {
@@ -1028,6 +1133,85 @@ void CTxMemPool::RemoveStaged(setEntries &stage, bool updateDescendants, MemPool
     for (txiter it : stage) {
         removeUnchecked(it, reason);
     }
+    if (!m_defer_cluster_updates) UpdateClusters();
+}
+
+void CTxMemPool::MarkClusterDirty(const CTxMemPoolEntry& entry)
+{
+    AssertLockHeld(cs);
+    if (entry.m_cluster) m_dirty_clusters.insert(entry.m_cluster);
+}
+
+void CTxMemPool::UpdateClusters()
+{
+    AssertLockHeld(cs);
+    if (!m_track_clusters) return;
+
+    std::vector<const CTxMemPoolEntry*> todo;
+    todo.swap(m_unclustered);
+    for (TxMemPoolCluster* cluster : m_dirty_clusters) {
+        for (const CTxMemPoolEntry* entry : cluster->txs) {
+            // Transactions that left the mempool have been replaced by nullptr.
+            if (entry == nullptr) continue;
+            entry->m_cluster = nullptr;
+            todo.push_back(entry);
+        }
+        const auto it{m_clusters.find(cluster)};
+        assert(it != m_clusters.end());
+        m_cluster_usage -= ClusterUsage(m_clusters, **it);
+        m_clusters.erase(it);
+    }
+    m_dirty_clusters.clear();
+
+    std::vector<const CTxMemPoolEntry*> members;
+    std::vector<CAmount> fees;
+    std::vector<int64_t> sizes;
+    std::vector<std::vector<uint32_t>> parents;
+    for (const CTxMemPoolEntry* start : todo) {
+        // Skip transactions that were already put into one of the new clusters.
+        if (start->m_cluster) continue;
+
+        // Collect the connected component of start. The cluster pointer marks
+        // the transactions that have been visited, and m_cluster_index is
+        // temporarily their index in members.
+        auto cluster{std::make_unique<TxMemPoolCluster>()};
+        members.assign(1, start);
+        start->m_cluster = cluster.get();
+        for (size_t i = 0; i < members.size(); ++i) {
+            members[i]->m_cluster_index = i;
+            const auto visit{[&](const CTxMemPoolEntry& neighbour) {
+                if (neighbour.m_cluster == cluster.get()) return;
+                // Whatever linked the two transactions marked the neighbour's
+                // old cluster as dirty.
+                assert(neighbour.m_cluster == nullptr);
+                neighbour.m_cluster = cluster.get();
+                members.push_back(&neighbour);
+            }};
+            for (const CTxMemPoolEntry& parent : members[i]->GetMemPoolParentsConst()) visit(parent);
+            for (const CTxMemPoolEntry& child : members[i]->GetMemPoolChildrenConst()) visit(child);
+        }
+
+        fees.clear();
+        sizes.clear();
+        parents.assign(members.size(), {});
+        for (size_t i = 0; i < members.size(); ++i) {
+            fees.push_back(members[i]->GetModifiedFee());
+            sizes.push_back(members[i]->GetTxSize());
+            for (const CTxMemPoolEntry& parent : members[i]->GetMemPoolParentsConst()) {
+                parents[i].push_back(parent.m_cluster_index);
+            }
+        }
+        cluster_linearize::Linearization linearization{cluster_linearize::Linearize(fees, sizes, parents)};
+        cluster->txs.reserve(members.size());
+        for (uint32_t i : linearization.order) {
+            members[i]->m_cluster_index = cluster->txs.size();
+            cluster->txs.push_back(members[i]);
+        }
+        cluster->chunks = std::move(linearization.chunks);
+
+        m_cluster_usage += ClusterUsage(m_clusters, *cluster);
+        m_clusters.insert(std::move(cluster));
+    }
 }
 
 int CTxMemPool::Expire(std::chrono::seconds time)
@@ -1059,23 +1243,27 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, bool validFeeEstimat
 void CTxMemPool::UpdateChild(txiter entry, txiter child, bool add)
 {
     AssertLockHeld(cs);
-    CTxMemPoolEntry::Children s;
-    if (add && entry->GetMemPoolChildren().insert(*child).second) {
-        cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
-    } else if (!add && entry->GetMemPoolChildren().erase(*child)) {
-        cachedInnerUsage -= memusage::IncrementalDynamicUsage(s);
+    CTxMemPoolEntry::Children& children = entry->GetMemPoolChildren();
+    cachedInnerUsage -= children.DynamicMemoryUsage();
+    if (add) {
+        children.insert(*child);
+    } else {
+        children.erase(*child);
     }
+    cachedInnerUsage += children.DynamicMemoryUsage();
 }
 
 void CTxMemPool::UpdateParent(txiter entry, txiter parent, bool add)
 {
     AssertLockHeld(cs);
-    CTxMemPoolEntry::Parents s;
-    if (add && entry->GetMemPoolParents().insert(*parent).second) {
-        cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
-    } else if (!add && entry->GetMemPoolParents().erase(*parent)) {
-        cachedInnerUsage -= memusage::IncrementalDynamicUsage(s);
+    CTxMemPoolEntry::Parents& parents = entry->GetMemPoolParents();
+    cachedInnerUsage -= parents.DynamicMemoryUsage();
+    if (add) {
+        parents.insert(*parent);
+    } else {
+        parents.erase(*parent);
     }
+    cachedInnerUsage += parents.DynamicMemoryUsage();
 }
 
 CFeeRate CTxMemPool::GetMinFee(size_t sizelimit) const {
@@ -1116,19 +1304,31 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
     unsigned nTxnRemoved = 0;
     CFeeRate maxFeeRateRemoved(0);
     while (!mapTx.empty() && DynamicMemoryUsage() > sizelimit) {
-        indexed_transaction_set::index<descendant_score>::type::iterator it = mapTx.get<descendant_score>().begin();
+        setEntries stage;
+        CFeeRate removed;
+        if (m_track_clusters) {
+            // Evict the worst chunk of the mempool: the last chunk of some
+            // cluster, which contains all of its own in-mempool descendants.
+            const TxMemPoolCluster& cluster{**m_clusters.begin()};
+            const cluster_linearize::Chunk& chunk{cluster.chunks.back()};
+            removed = CFeeRate(chunk.fee, chunk.size);
+            for (size_t i = cluster.txs.size() - chunk.count; i < cluster.txs.size(); ++i) {
+                stage.insert(mapTx.iterator_to(*cluster.txs[i]));
+            }
+        } else {
+            indexed_transaction_set::index<descendant_score>::type::iterator it = mapTx.get<descendant_score>().begin();
+            removed = CFeeRate(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
+            CalculateDescendants(mapTx.project<0>(it), stage);
+        }
 
         // We set the new mempool min fee to the feerate of the removed set, plus the
         // "minimum reasonable fee rate" (ie some value under which we consider txn
         // to have 0 fee). This way, we don't allow txn to enter mempool with feerate
         // equal to txn which were removed with no block in between.
-        CFeeRate removed(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
         removed += m_incremental_relay_feerate;
         trackPackageRemoved(removed);
         maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
 
-        setEntries stage;
-        CalculateDescendants(mapTx.project<0>(it), stage);
         nTxnRemoved += stage.size();
 
         std::vector<CTransaction> txn;
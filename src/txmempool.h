@@ -9,6 +9,7 @@
 
 #include <atomic>
 #include <map>
+#include <memory>
 #include <optional>
 #include <set>
 #include <string>
@@ -18,11 +19,14 @@
 #include <kernel/mempool_limits.h>
 #include <kernel/mempool_options.h>
 
+#include <cluster_linearize.h>
 #include <coins.h>
 #include <consensus/amount.h>
 #include <indirectmap.h>
+#include <memusage.h>
 #include <policy/feerate.h>
 #include <policy/packages.h>
+#include <prevector.h>
 #include <primitives/transaction.h>
 #include <random.h>
 #include <sync.h>
@@ -74,6 +78,8 @@ struct CompareIteratorByHash {
     }
 };
 
+struct TxMemPoolCluster;
+
 /** \class CTxMemPoolEntry
  *
  * CTxMemPoolEntry stores data about the corresponding transaction, as well
@@ -90,9 +96,59 @@ class CTxMemPoolEntry
 {
 public:
     typedef std::reference_wrapper<const CTxMemPoolEntry> CTxMemPoolEntryRef;
+    //! Set of entries, used while walking the mempool graph
+    typedef std::set<CTxMemPoolEntryRef, CompareIteratorByHash> RefSet;
+
+    /**
+     * Set of in-mempool parents or children of an entry, sorted by txid.
+     * Most transactions have one or two of each, which are stored inline
+     * instead of in separately allocated std::set nodes.
+     */
+    class Links
+    {
+    private:
+        typedef prevector<2, CTxMemPoolEntryRef> container;
+        container m_entries;
+
+        container::const_iterator Find(const CTxMemPoolEntry& entry) const
+        {
+            return std::lower_bound(m_entries.begin(), m_entries.end(), CTxMemPoolEntryRef{entry}, CompareIteratorByHash{});
+        }
+
+    public:
+        typedef container::const_iterator const_iterator;
+        const_iterator begin() const { return m_entries.begin(); }
+        const_iterator end() const { return m_entries.end(); }
+        size_t size() const { return m_entries.size(); }
+        bool empty() const { return m_entries.empty(); }
+
+        size_t count(const CTxMemPoolEntry& entry) const
+        {
+            const auto it{Find(entry)};
+            return it != end() && &it->get() == &entry;
+        }
+        /** Add an entry. Returns whether it was not in the set yet. */
+        bool insert(const CTxMemPoolEntry& entry)
+        {
+            const auto it{Find(entry)};
+            if (it != end() && &it->get() == &entry) return false;
+            m_entries.insert(m_entries.begin() + (it - begin()), CTxMemPoolEntryRef{entry});
+            return true;
+        }
+        /** Remove an entry. Returns whether it was in the set. */
+        bool erase(const CTxMemPoolEntry& entry)
+        {
+            const auto it{Find(entry)};
+            if (it == end() || &it->get() != &entry) return false;
+            m_entries.erase(m_entries.begin() + (it - begin()));
+            if (m_entries.empty()) m_entries.shrink_to_fit();
+            return true;
+        }
+        size_t DynamicMemoryUsage() const { return memusage::DynamicUsage(m_entries); }
+    };
     // two aliases, should the types ever diverge
-    typedef std::set<CTxMemPoolEntryRef, CompareIteratorByHash> Parents;
-    typedef std::set<CTxMemPoolEntryRef, CompareIteratorByHash> Children;
+    typedef Links Parents;
+    typedef Links Children;
 
 private:
     const CTransactionRef tx;
@@ -166,6 +222,44 @@ public:
 
     mutable size_t vTxHashesIdx; //!< Index in mempool's vTxHashes
     mutable Epoch::Marker m_epoch_marker; //!< epoch when last touched, useful for graph algorithms
+    mutable TxMemPoolCluster* m_cluster{nullptr}; //!< Cluster of this tx, if the mempool tracks clusters
+    mutable uint32_t m_cluster_index{0}; //!< ... and position of this tx in the cluster's linearization
+};
+
+/**
+ * A connected component of the mempool's transaction graph, i.e. a set of
+ * transactions that are linked by spending each other's outputs, directly or
+ * through other transactions, together with a linearization of them: the
+ * order in which they are best mined, grouped into chunks of decreasing
+ * feerate.
+ *
+ * Clusters are built by the mempool when a transaction joins or leaves them
+ * and are not modified afterwards: instead, the clusters that a change
+ * touches are replaced with new ones. Mining a cluster means mining a prefix
+ * of its chunks, and the last chunk is the part of it that is worst to keep.
+ */
+struct TxMemPoolCluster {
+    //! The transactions, in linearization order
+    std::vector<const CTxMemPoolEntry*> txs;
+    //! Chunks of txs, in the same order
+    std::vector<cluster_linearize::Chunk> chunks;
+};
+
+/** Sort clusters by the feerate of their last chunk, lowest first. */
+struct CompareClusterByWorstChunk {
+    using is_transparent = void;
+
+    bool operator()(const TxMemPoolCluster* a, const TxMemPoolCluster* b) const
+    {
+        const cluster_linearize::Chunk& chunk_a{a->chunks.back()};
+        const cluster_linearize::Chunk& chunk_b{b->chunks.back()};
+        if (cluster_linearize::HigherFeerate(chunk_a.fee, chunk_a.size, chunk_b.fee, chunk_b.size)) return false;
+        if (cluster_linearize::HigherFeerate(chunk_b.fee, chunk_b.size, chunk_a.fee, chunk_a.size)) return true;
+        return a < b;
+    }
+    bool operator()(const std::unique_ptr<TxMemPoolCluster>& a, const std::unique_ptr<TxMemPoolCluster>& b) const { return (*this)(a.get(), b.get()); }
+    bool operator()(const std::unique_ptr<TxMemPoolCluster>& a, const TxMemPoolCluster* b) const { return (*this)(a.get(), b); }
+    bool operator()(const TxMemPoolCluster* a, const std::unique_ptr<TxMemPoolCluster>& b) const { return (*this)(a, b.get()); }
 };
 
 // extracts a transaction hash from CTxMemPoolEntry or CTransactionRef
@@ -527,6 +621,8 @@ public:
 
     typedef std::set<txiter, CompareIteratorByHash> setEntries;
 
+    using ClusterSet = std::set<std::unique_ptr<TxMemPoolCluster>, CompareClusterByWorstChunk>;
+
     uint64_t CalculateDescendantMaximum(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 private:
     typedef std::map<txiter, setEntries, CompareIteratorByHash> cacheMap;
@@ -542,6 +638,27 @@ private:
      */
     std::set<uint256> m_unbroadcast_txids GUARDED_BY(cs);
 
+    //! All clusters if m_track_clusters, sorted for eviction
+    ClusterSet m_clusters GUARDED_BY(cs);
+    //! Clusters that lost or gained transactions and have to be rebuilt
+    std::set<TxMemPoolCluster*> m_dirty_clusters GUARDED_BY(cs);
+    //! Transactions that were added but are not in a cluster yet
+    std::vector<const CTxMemPoolEntry*> m_unclustered GUARDED_BY(cs);
+    //! Dynamic memory usage of the clusters
+    uint64_t m_cluster_usage GUARDED_BY(cs){0};
+    //! While set, RemoveStaged() leaves rebuilding the clusters to its caller
+    bool m_defer_cluster_updates GUARDED_BY(cs){false};
+
+    /** Mark the cluster of entry, if any, as having to be rebuilt. */
+    void MarkClusterDirty(const CTxMemPoolEntry& entry) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /**
+     * Replace the dirty clusters by the connected components of their
+     * remaining transactions, and build clusters for unclustered
+     * transactions (merging them with the clusters of their neighbours).
+     * Only does work if m_track_clusters.
+     */
+    void UpdateClusters() EXCLUSIVE_LOCKS_REQUIRED(cs);
+
 
     /**
      * Helper function to calculate all in-mempool ancestors of staged_ancestors and apply ancestor
@@ -554,7 +671,7 @@ private:
     bool CalculateAncestorsAndCheckLimits(size_t entry_size,
                                           size_t entry_count,
                                           setEntries& setAncestors,
-                                          CTxMemPoolEntry::Parents &staged_ancestors,
+                                          CTxMemPoolEntry::RefSet& staged_ancestors,
                                           uint64_t limitAncestorCount,
                                           uint64_t limitAncestorSize,
                                           uint64_t limitDescendantCount,
@@ -576,6 +693,7 @@ public:
     const std::optional<unsigned> m_max_datacarrier_bytes;
     const bool m_require_standard;
     const bool m_full_rbf;
+    const bool m_track_clusters;
 
     using Limits = kernel::MemPoolLimits;
 
@@ -695,6 +813,8 @@ public:
      * @param[in]       limitDescendantCount    Max number of txns including descendants.
      * @param[in]       limitDescendantSize     Max virtual size including descendants.
      * @param[out]      errString               Populated with error reason if a limit is hit.
+     *
+     * If the mempool tracks clusters, the cluster limits are checked as well, see CheckClusterLimits().
      */
     bool CheckPackageLimits(const Package& package,
                             uint64_t limitAncestorCount,
@@ -703,6 +823,16 @@ public:
                             uint64_t limitDescendantSize,
                             std::string &errString) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    /** Check that the cluster that a set of transactions not already in the mempool would form
+     * with their in-mempool relatives is within the cluster count and size limits. Only does
+     * anything if the mempool tracks clusters, since the limits bound the cost of linearizing them.
+     * @param[in]       package                 Transactions being evaluated for acceptance to mempool.
+     * @param[in]       conflicts               In-mempool transactions the package replaces. They
+     *                                          and their descendants are not counted.
+     * @param[out]      errString               Populated with error reason if a limit is hit.
+     */
+    bool CheckClusterLimits(const Package& package, const setEntries& conflicts, std::string& errString) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     /** Populate setDescendants with all in-mempool descendants of hash.
      *  Assumes that setDescendants includes all in-mempool descendants of anything
      *  already in it.  */
@@ -820,6 +950,13 @@ public:
         return m_sequence_number;
     }
 
+    /** Returns all clusters if the mempool tracks them, sorted for eviction */
+    const ClusterSet& GetClusters() const EXCLUSIVE_LOCKS_REQUIRED(cs)
+    {
+        AssertLockHeld(cs);
+        return m_clusters;
+    }
+
 private:
     /** UpdateForDescendants is used by UpdateTransactionsFromBlock to update
      *  the descendants for a single transaction that has been added to the
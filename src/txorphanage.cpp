@@ -9,6 +9,7 @@
 #include <logging.h>
 #include <policy/policy.h>
 
+#include <algorithm>
 #include <cassert>
 
 /** Expiration time for orphan transactions in seconds */
@@ -40,17 +41,20 @@ bool TxOrphanage::AddTx(const CTransactionRef& tx, NodeId peer)
         return false;
     }
 
-    auto ret = m_orphans.emplace(hash, OrphanTx{tx, peer, GetTime() + ORPHAN_TX_EXPIRE_TIME, m_orphan_list.size()});
+    PeerOrphans& peer_orphans = m_peer_orphans[peer];
+    auto ret = m_orphans.emplace(hash, OrphanTx{tx, peer, GetTime() + ORPHAN_TX_EXPIRE_TIME, peer_orphans.orphans.size(), sz});
     assert(ret.second);
-    m_orphan_list.push_back(ret.first);
+    peer_orphans.orphans.push_back(ret.first);
+    peer_orphans.weight += sz;
+    m_total_weight += sz;
     // Allow for lookups in the orphan pool by wtxid, as well as txid
     m_wtxid_to_orphan_it.emplace(tx->GetWitnessHash(), ret.first);
     for (const CTxIn& txin : tx->vin) {
         m_outpoint_to_orphan_it[txin.prevout].insert(ret.first);
     }
 
-    LogPrint(BCLog::MEMPOOL, "stored orphan tx %s (mapsz %u outsz %u)\n", hash.ToString(),
-             m_orphans.size(), m_outpoint_to_orphan_it.size());
+    LogPrint(BCLog::MEMPOOL, "stored orphan tx %s (mapsz %u outsz %u weight %d)\n", hash.ToString(),
+             m_orphans.size(), m_outpoint_to_orphan_it.size(), m_total_weight);
     return true;
 }
 
@@ -70,16 +74,23 @@ int TxOrphanage::EraseTx(const uint256& txid)
             m_outpoint_to_orphan_it.erase(itPrev);
     }
 
+    auto peer_it = m_peer_orphans.find(it->second.fromPeer);
+    assert(peer_it != m_peer_orphans.end());
+    PeerOrphans& peer_orphans = peer_it->second;
     size_t old_pos = it->second.list_pos;
-    assert(m_orphan_list[old_pos] == it);
-    if (old_pos + 1 != m_orphan_list.size()) {
-        // Unless we're deleting the last entry in m_orphan_list, move the last
+    assert(peer_orphans.orphans[old_pos] == it);
+    if (old_pos + 1 != peer_orphans.orphans.size()) {
+        // Unless we're deleting the last entry in the peer's list, move the last
         // entry to the position we're deleting.
-        auto it_last = m_orphan_list.back();
-        m_orphan_list[old_pos] = it_last;
+        auto it_last = peer_orphans.orphans.back();
+        peer_orphans.orphans[old_pos] = it_last;
         it_last->second.list_pos = old_pos;
     }
-    m_orphan_list.pop_back();
+    peer_orphans.orphans.pop_back();
+    peer_orphans.weight -= it->second.weight;
+    if (peer_orphans.orphans.empty()) m_peer_orphans.erase(peer_it);
+    m_total_weight -= it->second.weight;
+
     m_wtxid_to_orphan_it.erase(it->second.tx->GetWitnessHash());
 
     m_orphans.erase(it);
@@ -91,13 +102,12 @@ void TxOrphanage::EraseForPeer(NodeId peer)
     AssertLockHeld(g_cs_orphans);
 
     int nErased = 0;
-    std::map<uint256, OrphanTx>::iterator iter = m_orphans.begin();
-    while (iter != m_orphans.end())
-    {
-        std::map<uint256, OrphanTx>::iterator maybeErase = iter++; // increment to avoid iterator becoming invalid
-        if (maybeErase->second.fromPeer == peer)
-        {
-            nErased += EraseTx(maybeErase->second.tx->GetHash());
+    auto peer_it = m_peer_orphans.find(peer);
+    if (peer_it != m_peer_orphans.end()) {
+        // Copy the list, as erasing the last orphan erases the peer's entry.
+        const std::vector<OrphanMap::iterator> orphans{peer_it->second.orphans};
+        for (const auto& it : orphans) {
+            nErased += EraseTx(it->first);
         }
     }
     if (nErased > 0) LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx from peer=%d\n", nErased, peer);
@@ -126,19 +136,42 @@ void TxOrphanage::LimitOrphans(unsigned int max_orphans)
         }
         // Sweep again 5 minutes after the next entry that expires in order to batch the linear scan.
         nNextSweep = nMinExpTime + ORPHAN_TX_EXPIRE_INTERVAL;
+        m_expired += nErased;
         if (nErased > 0) LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx due to expiration\n", nErased);
     }
     FastRandomContext rng;
-    while (m_orphans.size() > max_orphans)
+    // No single peer may take up more than its share.
+    std::vector<NodeId> heavy_peers;
+    for (const auto& [peer, peer_orphans] : m_peer_orphans) {
+        if (peer_orphans.weight > MAX_PEER_ORPHAN_WEIGHT) heavy_peers.push_back(peer);
+    }
+    for (const NodeId peer : heavy_peers) {
+        // A single orphan is never over the limit, so this stops before
+        // the peer's last orphan (and its entry) is erased.
+        while (m_peer_orphans.at(peer).weight > MAX_PEER_ORPHAN_WEIGHT) {
+            EvictFromPeer(peer, rng);
+            ++nEvicted;
+        }
+    }
+    while (m_orphans.size() > max_orphans || m_total_weight > MAX_ORPHAN_TOTAL_WEIGHT)
     {
-        // Evict a random orphan:
-        size_t randompos = rng.randrange(m_orphan_list.size());
-        EraseTx(m_orphan_list[randompos]->first);
+        // Evict from the peer whose orphans weigh the most:
+        const auto heaviest = std::max_element(m_peer_orphans.begin(), m_peer_orphans.end(),
+            [](const auto& a, const auto& b) { return a.second.weight < b.second.weight; });
+        EvictFromPeer(heaviest->first, rng);
         ++nEvicted;
     }
+    m_evicted += nEvicted;
     if (nEvicted > 0) LogPrint(BCLog::MEMPOOL, "orphanage overflow, removed %u tx\n", nEvicted);
 }
 
+void TxOrphanage::EvictFromPeer(NodeId peer, FastRandomContext& rng)
+{
+    AssertLockHeld(g_cs_orphans);
+    const std::vector<OrphanMap::iterator>& orphans{m_peer_orphans.at(peer).orphans};
+    EraseTx(orphans[rng.randrange(orphans.size())]->first);
+}
+
 void TxOrphanage::AddChildrenToWorkSet(const CTransaction& tx, std::set<uint256>& orphan_work_set) const
 {
     AssertLockHeld(g_cs_orphans);
@@ -152,6 +185,38 @@ void TxOrphanage::AddChildrenToWorkSet(const CTransaction& tx, std::set<uint256>
     }
 }
 
+std::map<NodeId, std::set<uint256>> TxOrphanage::GetChildrenFromBlock(const CBlock& block)
+{
+    AssertLockHeld(g_cs_orphans);
+    std::map<NodeId, std::set<uint256>> children;
+    for (const CTransactionRef& ptx : block.vtx) {
+        for (unsigned int i = 0; i < ptx->vout.size(); i++) {
+            const auto it_by_prev = m_outpoint_to_orphan_it.find(COutPoint(ptx->GetHash(), i));
+            if (it_by_prev == m_outpoint_to_orphan_it.end()) continue;
+            for (const auto& elem : it_by_prev->second) {
+                if (children[elem->second.fromPeer].insert(elem->first).second) ++m_block_parent_arrivals;
+            }
+        }
+    }
+    return children;
+}
+
+TxOrphanage::Info TxOrphanage::GetInfo() const
+{
+    LOCK(g_cs_orphans);
+    Info info;
+    info.count = m_orphans.size();
+    info.weight = m_total_weight;
+    for (const auto& [peer, peer_orphans] : m_peer_orphans) {
+        info.peers.emplace(peer, PeerInfo{peer_orphans.orphans.size(), peer_orphans.weight});
+    }
+    info.evicted = m_evicted;
+    info.expired = m_expired;
+    info.erased_for_block = m_erased_for_block;
+    info.block_parent_arrivals = m_block_parent_arrivals;
+    return info;
+}
+
 bool TxOrphanage::HaveTx(const GenTxid& gtxid) const
 {
     LOCK(g_cs_orphans);
@@ -198,6 +263,7 @@ void TxOrphanage::EraseForBlock(const CBlock& block)
         for (const uint256& orphanHash : vOrphanErase) {
             nErased += EraseTx(orphanHash);
         }
+        m_erased_for_block += nErased;
         LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx included or conflicted by block\n", nErased);
     }
 }
@@ -7,20 +7,54 @@
 #define KOYOTECOIN_TXORPHANAGE_H
 
 #include <net.h>
+#include <policy/policy.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
+#include <random.h>
 #include <sync.h>
 
+#include <cstdint>
+#include <map>
+#include <set>
+#include <vector>
+
 /** Guards orphan transactions and extra txs for compact blocks */
 extern RecursiveMutex g_cs_orphans;
 
+/** Maximum total weight of the orphans kept, about 10 megabytes */
+static constexpr int64_t MAX_ORPHAN_TOTAL_WEIGHT{100 * MAX_STANDARD_TX_WEIGHT};
+/** Maximum total weight of the orphans kept that were received from a single peer */
+static constexpr int64_t MAX_PEER_ORPHAN_WEIGHT{10 * MAX_STANDARD_TX_WEIGHT};
+
 /** A class to track orphan transactions (failed on TX_MISSING_INPUTS)
  * Since we cannot distinguish orphans from bad transactions with
- * non-existent inputs, we heavily limit the number of orphans
- * we keep and the duration we keep them for.
+ * non-existent inputs, we heavily limit the number and weight of orphans
+ * we keep and the duration we keep them for. When over the limits, orphans
+ * are evicted from the peer whose orphans weigh the most, so that a peer
+ * flooding us with orphans cannot push out the ones other peers sent.
  */
 class TxOrphanage {
 public:
+    struct PeerInfo {
+        size_t count{0};
+        int64_t weight{0};
+    };
+
+    /** Statistics about the orphanage, e.g. for RPC */
+    struct Info {
+        size_t count{0};
+        int64_t weight{0};
+        std::map<NodeId, PeerInfo> peers;
+        //! Orphans evicted to stay within the limits
+        uint64_t evicted{0};
+        //! Orphans that expired
+        uint64_t expired{0};
+        //! Orphans removed because they were included in or conflicted by a block
+        uint64_t erased_for_block{0};
+        //! Orphans reconsidered because a block confirmed one of their parents
+        uint64_t block_parent_arrivals{0};
+    };
+
     /** Add a new orphan transaction */
     bool AddTx(const CTransactionRef& tx, NodeId peer) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
 
@@ -41,13 +75,19 @@ public:
     /** Erase all orphans included in or invalidated by a new block */
     void EraseForBlock(const CBlock& block) LOCKS_EXCLUDED(::g_cs_orphans);
 
-    /** Limit the orphanage to the given maximum */
+    /** Limit the orphanage to the given maximum number of orphans, and to
+     * MAX_ORPHAN_TOTAL_WEIGHT and MAX_PEER_ORPHAN_WEIGHT */
     void LimitOrphans(unsigned int max_orphans) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
 
     /** Add any orphans that list a particular tx as a parent into a peer's work set
      * (ie orphans that may have found their final missing parent, and so should be reconsidered for the mempool) */
     void AddChildrenToWorkSet(const CTransaction& tx, std::set<uint256>& orphan_work_set) const EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
 
+    /** Get the orphans that spend outputs of a block's transactions, by the
+     * peer they were received from (ie orphans whose parents were not in our
+     * mempool, and that may have been confirmed by the block all at once) */
+    std::map<NodeId, std::set<uint256>> GetChildrenFromBlock(const CBlock& block) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
+
     /** Return how many entries exist in the orphange */
     size_t Size() LOCKS_EXCLUDED(::g_cs_orphans)
     {
@@ -55,12 +95,16 @@ public:
         return m_orphans.size();
     }
 
+    Info GetInfo() const LOCKS_EXCLUDED(::g_cs_orphans);
+
 protected:
     struct OrphanTx {
         CTransactionRef tx;
         NodeId fromPeer;
         int64_t nTimeExpire;
+        //! Position in the list of orphans received from fromPeer
         size_t list_pos;
+        int64_t weight;
     };
 
     /** Map from txid to orphan transaction record. Limited by
@@ -82,12 +126,29 @@ protected:
      *  to remove orphan transactions from the m_orphans */
     std::map<COutPoint, std::set<OrphanMap::iterator, IteratorComparator>> m_outpoint_to_orphan_it GUARDED_BY(g_cs_orphans);
 
-    /** Orphan transactions in vector for quick random eviction */
-    std::vector<OrphanMap::iterator> m_orphan_list GUARDED_BY(g_cs_orphans);
-
     /** Index from wtxid into the m_orphans to lookup orphan
      *  transactions using their witness ids. */
     std::map<uint256, OrphanMap::iterator> m_wtxid_to_orphan_it GUARDED_BY(g_cs_orphans);
+
+    struct PeerOrphans {
+        /** Orphan transactions received from the peer, for quick random eviction */
+        std::vector<OrphanMap::iterator> orphans;
+        int64_t weight{0};
+    };
+
+    /** The orphans received from each peer that has any */
+    std::map<NodeId, PeerOrphans> m_peer_orphans GUARDED_BY(g_cs_orphans);
+
+    /** Total weight of all orphans */
+    int64_t m_total_weight GUARDED_BY(g_cs_orphans){0};
+
+    uint64_t m_evicted GUARDED_BY(g_cs_orphans){0};
+    uint64_t m_expired GUARDED_BY(g_cs_orphans){0};
+    uint64_t m_erased_for_block GUARDED_BY(g_cs_orphans){0};
+    uint64_t m_block_parent_arrivals GUARDED_BY(g_cs_orphans){0};
+
+    /** Evict a random orphan of the given peer */
+    void EvictFromPeer(NodeId peer, FastRandomContext& rng) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
 };
 
 #endif // KOYOTECOIN_TXORPHANAGE_H
@@ -12,6 +12,7 @@
 #include <util/system.h>
 #include <util/time.h>
 
+#include <array>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -25,6 +26,11 @@
 #include <poll.h>
 #endif
 
+#ifdef USE_EPOLL
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
 static inline bool IOErrorIsPermanent(int err)
 {
     return err != WSAEAGAIN && err != WSAEINTR && err != WSAEWOULDBLOCK && err != WSAEINPROGRESS;
@@ -224,6 +230,145 @@ bool Sock::WaitMany(std::chrono::milliseconds timeout, EventsPerSock& events_per
 #endif /* USE_POLL */
 }
 
+SockWaitSet::SockWaitSet()
+{
+#ifdef USE_EPOLL
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll_fd == -1) {
+        LogPrintf("Unable to create epoll instance, falling back to poll: %s\n", NetworkErrorString(WSAGetLastError()));
+    }
+    m_use_epoll = m_epoll_fd != -1;
+#endif
+}
+
+SockWaitSet::~SockWaitSet()
+{
+#ifdef USE_EPOLL
+    if (m_epoll_fd != -1) {
+        close(m_epoll_fd);
+    }
+#endif
+}
+
+void SockWaitSet::FallBack()
+{
+#ifdef USE_EPOLL
+    for (const auto& [fd, entry] : m_socks) {
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+#endif
+    m_use_epoll = false;
+}
+
+void SockWaitSet::Set(std::shared_ptr<const Sock> sock, Sock::Event requested)
+{
+    LOCK(m_mutex);
+    const SOCKET fd{sock->Get()};
+    const auto [it, inserted] = m_socks.try_emplace(fd, std::move(sock), requested);
+    if (!inserted) {
+        if (it->second.second == requested) {
+            return;
+        }
+        it->second.second = requested;
+    }
+
+#ifdef USE_EPOLL
+    if (m_use_epoll) {
+        epoll_event ev{};
+        if (requested & Sock::RECV) {
+            ev.events |= EPOLLIN;
+        }
+        if (requested & Sock::SEND) {
+            ev.events |= EPOLLOUT;
+        }
+        ev.data.fd = fd;
+        if (epoll_ctl(m_epoll_fd, inserted ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &ev) == SOCKET_ERROR) {
+            LogPrintf("Unable to register socket with epoll, falling back to poll: %s\n", NetworkErrorString(WSAGetLastError()));
+            FallBack();
+        }
+    }
+#endif
+}
+
+void SockWaitSet::Remove(const Sock& sock)
+{
+    LOCK(m_mutex);
+    const auto it{m_socks.find(sock.Get())};
+    if (it == m_socks.end() || it->second.first.get() != &sock) {
+        return;
+    }
+#ifdef USE_EPOLL
+    if (m_use_epoll) {
+        // Deregister while we still keep the socket open.
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, it->first, nullptr);
+    }
+#endif
+    m_socks.erase(it);
+}
+
+bool SockWaitSet::Wait(std::chrono::milliseconds timeout, Sock::EventsPerSock& occurred)
+{
+    occurred.clear();
+
+    Sock::EventsPerSock events_per_sock;
+    {
+        LOCK(m_mutex);
+        if (m_socks.empty()) {
+            return false;
+        }
+        if (!m_use_epoll) {
+            for (const auto& [fd, entry] : m_socks) {
+                events_per_sock.emplace(entry.first, Sock::Events{entry.second});
+            }
+        }
+    }
+
+#ifdef USE_EPOLL
+    if (events_per_sock.empty()) {
+        // Level-triggered, so sockets that are ready beyond the first batch
+        // are reported by the next call.
+        std::array<epoll_event, 1024> ready;
+        const int num_ready{epoll_wait(m_epoll_fd, ready.data(), ready.size(), count_milliseconds(timeout))};
+        if (num_ready == SOCKET_ERROR) {
+            return false;
+        }
+
+        LOCK(m_mutex);
+        for (int i = 0; i < num_ready; ++i) {
+            // Skip sockets that were removed while waiting.
+            const auto it = m_socks.find(ready[i].data.fd);
+            if (it == m_socks.end()) {
+                continue;
+            }
+            auto& events = occurred.emplace(it->second.first, Sock::Events{it->second.second}).first->second;
+            if (ready[i].events & EPOLLIN) {
+                events.occurred |= Sock::RECV;
+            }
+            if (ready[i].events & EPOLLOUT) {
+                events.occurred |= Sock::SEND;
+            }
+            if (ready[i].events & (EPOLLERR | EPOLLHUP)) {
+                events.occurred |= Sock::ERR;
+            }
+        }
+
+        return true;
+    }
+#endif
+
+    if (!events_per_sock.begin()->first->WaitMany(timeout, events_per_sock)) {
+        return false;
+    }
+
+    for (const auto& [sock, events] : events_per_sock) {
+        if (events.occurred != 0) {
+            occurred.emplace(sock, events);
+        }
+    }
+
+    return true;
+}
+
 void Sock::SendComplete(const std::string& data,
                         std::chrono::milliseconds timeout,
                         CThreadInterrupt& interrupt) const
@@ -7,6 +7,7 @@
 #define KOYOTECOIN_UTIL_SOCK_H
 
 #include <compat/compat.h>
+#include <sync.h>
 #include <threadinterrupt.h>
 #include <util/time.h>
 
@@ -268,6 +269,68 @@ private:
     void Close();
 };
 
+/**
+ * A set of sockets to wait on for readiness, kept across waits.
+ *
+ * `Sock::WaitMany()` hands the whole set to poll(2) or select(2) on every
+ * call, which costs time in the number of sockets even if almost all of them
+ * are idle. Where epoll(7) is available, sockets are registered with the
+ * kernel when they are added, and only changes of the requested events are
+ * passed to it afterwards, so that a wait costs time in the number of ready
+ * sockets. Elsewhere, or if a socket cannot be registered, it falls back to
+ * `Sock::WaitMany()`.
+ *
+ * Sockets can be added, changed and removed from any thread, also while
+ * another one waits. They stay open at least until they are removed from the
+ * set, so that their descriptors are not reused while registered.
+ */
+class SockWaitSet
+{
+public:
+    SockWaitSet();
+    ~SockWaitSet();
+
+    SockWaitSet(const SockWaitSet&) = delete;
+    SockWaitSet& operator=(const SockWaitSet&) = delete;
+
+    /**
+     * Wait for the requested events on a socket, adding it to the set if it
+     * is not in it yet.
+     */
+    void Set(std::shared_ptr<const Sock> sock, Sock::Event requested) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Remove a socket from the set, if it is in it.
+     */
+    void Remove(const Sock& sock) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Wait for readiness of the sockets in the set.
+     * @param[in] timeout Wait this long for at least one of the requested events to occur.
+     * @param[out] occurred Set to the sockets on which events occurred (with `ERR` added
+     * as in `Sock::Wait()`). Idle sockets are left out.
+     * @return true on success (or timeout, if `occurred` is returned empty), false
+     * otherwise, including if the set is empty
+     */
+    [[nodiscard]] bool Wait(std::chrono::milliseconds timeout, Sock::EventsPerSock& occurred) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    //! epoll(7) instance, or -1 if not available. Only closed on destruction,
+    //! as another thread may be waiting on it.
+    int m_epoll_fd{-1};
+
+    Mutex m_mutex;
+
+    //! Whether the sockets are registered with m_epoll_fd, rather than passed to `Sock::WaitMany()`.
+    bool m_use_epoll GUARDED_BY(m_mutex){false};
+
+    //! Sockets in the set and the events requested for each, by descriptor.
+    std::unordered_map<SOCKET, std::pair<std::shared_ptr<const Sock>, Sock::Event>> m_socks GUARDED_BY(m_mutex);
+
+    /** Stop using epoll, for example because a socket cannot be registered. */
+    void FallBack() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+};
+
 /** Return readable error string for a network error code */
 std::string NetworkErrorString(int err);
 
@@ -13,6 +13,7 @@
 #include <chain.h>
 #include <chainparams.h>
 #include <checkqueue.h>
+#include <compressor.h>
 #include <consensus/amount.h>
 #include <consensus/consensus.h>
 #include <consensus/merkle.h>
@@ -23,6 +24,7 @@
 #include <flatfile.h>
 #include <fs.h>
 #include <hash.h>
+#include <inputfetcher.h>
 #include <logging.h>
 #include <logging/timer.h>
 #include <node/blockstorage.h>
@@ -66,6 +68,7 @@
 #include <string>
 
 using kernel::CCoinsStats;
+using kernel::CoinsStatsBuilder;
 using kernel::CoinStatsHashType;
 using kernel::ComputeUTXOStats;
 using kernel::LoadMempool;
@@ -78,10 +81,12 @@ using node::CBlockIndexWorkComparator;
 using node::fImporting;
 using node::fPruneMode;
 using node::fReindex;
-using node::ReadBlockFromDisk;
+using node::SNAPSHOT_CHUNK_HEADER_SIZE;
+using node::SNAPSHOT_CHUNK_MAX_COINS;
+using node::SNAPSHOT_METADATA_SIZE;
+using node::SNAPSHOT_VERSION;
+using node::SnapshotChunkHeader;
 using node::SnapshotMetadata;
-using node::UndoReadFromDisk;
-using node::UnlinkPrunedFiles;
 
 #define MICRO 0.000001
 #define MILLI 0.001
@@ -125,6 +130,7 @@ GlobalMutex g_best_block_mutex;
 std::condition_variable g_best_block_cv;
 uint256 g_best_block;
 bool g_parallel_script_checks{false};
+bool g_parallel_input_fetch{false};
 bool fCheckBlockIndex = false;
 bool fCheckpointsEnabled = DEFAULT_CHECKPOINTS_ENABLED;
 int64_t nMaxTipAge = DEFAULT_MAX_TIP_AGE;
@@ -157,6 +163,36 @@ bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
                        bool cacheFullScriptStore, PrecomputedTransactionData& txdata,
                        std::vector<CScriptCheck>* pvChecks = nullptr)
     EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+static bool VerifyInputScripts(const CTransaction& tx, TxValidationState& state, unsigned int flags,
+                               bool cacheSigStore, PrecomputedTransactionData& txdata,
+                               std::vector<CScriptCheck>* pvChecks = nullptr);
+static void AddToScriptExecutionCache(const CTransaction& tx, unsigned int flags) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+/**
+ * Verify the scripts of tx with the standard script flags, using check_scripts(state, flags). If
+ * they fail and tx has no witness, find out whether it is only missing its witness, and report
+ * that as TX_WITNESS_STRIPPED.
+ */
+template <typename F>
+static bool CheckStandardInputScripts(const CTransaction& tx, TxValidationState& state, F check_scripts)
+{
+    constexpr unsigned int scriptVerifyFlags = STANDARD_SCRIPT_VERIFY_FLAGS;
+
+    if (!check_scripts(state, scriptVerifyFlags)) {
+        // SCRIPT_VERIFY_CLEANSTACK requires SCRIPT_VERIFY_WITNESS, so we
+        // need to turn both off, and compare against just turning off CLEANSTACK
+        // to see if the failure is specifically due to witness validation.
+        TxValidationState state_dummy; // Want reported failures to be from first CheckInputScripts
+        if (!tx.HasWitness() && check_scripts(state_dummy, scriptVerifyFlags & ~(SCRIPT_VERIFY_WITNESS | SCRIPT_VERIFY_CLEANSTACK)) &&
+            !check_scripts(state_dummy, scriptVerifyFlags & ~SCRIPT_VERIFY_CLEANSTACK)) {
+            // Only the witness is missing, so the transaction itself may be fine.
+            state.Invalid(TxValidationResult::TX_WITNESS_STRIPPED,
+                          state.GetRejectReason(), state.GetDebugMessage());
+        }
+        return false;
+    }
+    return true;
+}
 
 bool CheckFinalTxAtTip(const CBlockIndex& active_chain_tip, const CTransaction& tx)
 {
@@ -286,6 +322,54 @@ static bool IsCurrentForFeeEstimation(Chainstate& active_chainstate) EXCLUSIVE_L
     return true;
 }
 
+static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+
+/**
+ * Verify the scripts of the transactions of disconnected blocks on the script
+ * check worker threads, before they are re-added to the mempool one at a time.
+ * The signatures end up in the signature cache, where AcceptToMemoryPool()
+ * then finds them. The transactions must be in topological order, since they
+ * may spend the outputs of earlier ones.
+ */
+static void PrecheckReorgTransactionScripts(const std::vector<CTransactionRef>& txs, CCoinsViewCache& coins_tip)
+    EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    AssertLockHeld(cs_main);
+    if (!g_parallel_script_checks || txs.empty()) return;
+
+    // Outputs of the transactions are added here, not to coins_tip.
+    CCoinsViewCache view{&coins_tip};
+    // The checks keep pointers to the precomputed data, which must not move
+    // until Wait() returns.
+    std::vector<PrecomputedTransactionData> txdata(txs.size());
+    // A transaction that fails must not keep the ones after it from getting
+    // their signatures cached.
+    CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue, /*run_all=*/true);
+    for (size_t i = 0; i < txs.size(); ++i) {
+        const CTransaction& tx{*txs[i]};
+        std::vector<CTxOut> spent_outputs;
+        spent_outputs.reserve(tx.vin.size());
+        for (const CTxIn& txin : tx.vin) {
+            const Coin& coin{view.AccessCoin(txin.prevout)};
+            if (coin.IsSpent()) break;
+            spent_outputs.push_back(coin.out);
+        }
+        AddCoins(view, tx, MEMPOOL_HEIGHT, /*check=*/true);
+        if (spent_outputs.size() < tx.vin.size()) continue;
+
+        txdata[i].Init(tx, std::move(spent_outputs));
+        std::vector<CScriptCheck> checks;
+        checks.reserve(tx.vin.size());
+        for (unsigned int j = 0; j < tx.vin.size(); ++j) {
+            checks.emplace_back(txdata[i].m_spent_outputs[j], tx, j, STANDARD_SCRIPT_VERIFY_FLAGS, /*cacheIn=*/true, &txdata[i]);
+        }
+        control.Add(checks);
+    }
+    // Failures are reported by AcceptToMemoryPool(), which checks every
+    // transaction again.
+    control.Wait();
+}
+
 void Chainstate::MaybeUpdateMempoolForReorg(
     DisconnectedBlockTransactions& disconnectpool,
     bool fAddToMempool)
@@ -301,6 +385,14 @@ void Chainstate::MaybeUpdateMempoolForReorg(
     // Iterate disconnectpool in reverse, so that we add transactions
     // back to the mempool starting with the earliest transaction that had
     // been previously seen in a block.
+    if (fAddToMempool) {
+        std::vector<CTransactionRef> txs;
+        txs.reserve(disconnectpool.queuedTx.size());
+        for (auto it = disconnectpool.queuedTx.get<insertion_order>().rbegin(); it != disconnectpool.queuedTx.get<insertion_order>().rend(); ++it) {
+            if (!(*it)->IsCoinBase()) txs.push_back(*it);
+        }
+        PrecheckReorgTransactionScripts(txs, CoinsTip());
+    }
     auto it = disconnectpool.queuedTx.get<insertion_order>().rbegin();
     while (it != disconnectpool.queuedTx.get<insertion_order>().rend()) {
         // ignore validation errors in resurrected transactions
@@ -461,11 +553,20 @@ public:
          * policies such as mempool min fee and min relay fee.
          */
         const bool m_package_feerates;
+        /** When true, don't verify the transaction's scripts, because they are known to have been
+         * verified under the current tip, e.g. when reloading our own persisted mempool.
+         */
+        const bool m_skip_script_checks;
+        /** If set, the result of verifying the scripts before mempool validation, see
+         * ChainstateManager::PrecheckTransactionScripts().
+         */
+        const PrecheckedScripts* const m_prechecked;
 
         /** Parameters for single transaction mempool validation. */
         static ATMPArgs SingleAccept(const CChainParams& chainparams, int64_t accept_time,
                                      bool bypass_limits, std::vector<COutPoint>& coins_to_uncache,
-                                     bool test_accept)
+                                     bool test_accept, bool skip_script_checks = false,
+                                     const PrecheckedScripts* prechecked = nullptr)
         {
             return ATMPArgs{
                 /* m_chainparams */ chainparams,
@@ -476,6 +577,8 @@ public:
                 /* m_allow_replacement */ true,
                 /* m_package_submission */ false,
                 /* m_package_feerates */ false,
+                /* m_skip_script_checks */ skip_script_checks,
+                /* m_prechecked */ prechecked,
             };
         }
 
@@ -492,6 +595,8 @@ public:
                 /* m_allow_replacement */ false,
                 /* m_package_submission */ false, // not submitting to mempool
                 /* m_package_feerates */ false,
+                /* m_skip_script_checks */ false,
+                /* m_prechecked */ nullptr,
             };
         }
 
@@ -508,6 +613,8 @@ public:
                 /* m_allow_replacement */ false,
                 /* m_package_submission */ true,
                 /* m_package_feerates */ true,
+                /* m_skip_script_checks */ false,
+                /* m_prechecked */ nullptr,
             };
         }
 
@@ -523,6 +630,8 @@ public:
                 /* m_allow_replacement */ true,
                 /* m_package_submission */ false,
                 /* m_package_feerates */ false, // only 1 transaction
+                /* m_skip_script_checks */ false,
+                /* m_prechecked */ nullptr,
             };
         }
 
@@ -536,7 +645,9 @@ public:
                  bool test_accept,
                  bool allow_replacement,
                  bool package_submission,
-                 bool package_feerates)
+                 bool package_feerates,
+                 bool skip_script_checks,
+                 const PrecheckedScripts* prechecked)
             : m_chainparams{chainparams},
               m_accept_time{accept_time},
               m_bypass_limits{bypass_limits},
@@ -544,7 +655,9 @@ public:
               m_test_accept{test_accept},
               m_allow_replacement{allow_replacement},
               m_package_submission{package_submission},
-              m_package_feerates{package_feerates}
+              m_package_feerates{package_feerates},
+              m_skip_script_checks{skip_script_checks},
+              m_prechecked{prechecked}
         {
         }
     };
@@ -626,12 +739,24 @@ private:
     // only invoke this on transactions that have otherwise passed policy checks.
     bool PolicyScriptChecks(const ATMPArgs& args, Workspace& ws) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
 
+    // Run the policy script checks of several transactions at once on the
+    // script check worker threads. Returns true only if all of them passed;
+    // on failure, or without worker threads, PolicyScriptChecks() has to be
+    // run on each transaction to find out which one failed and why.
+    bool ParallelPolicyScriptChecks(std::vector<Workspace>& workspaces) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
+
     // Re-run the script checks, using consensus flags, and try to cache the
     // result in the scriptcache. This should be done after
     // PolicyScriptChecks(). This requires that all inputs either be in our
     // utxo set or in the mempool.
     bool ConsensusScriptChecks(const ATMPArgs& args, Workspace& ws) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
 
+    // Whether the scripts were verified beforehand against the outputs the
+    // transaction spends now and the current tip's script flags, so that the
+    // result can be used instead of running PolicyScriptChecks() and
+    // ConsensusScriptChecks().
+    bool PrecheckApplies(const PrecheckedScripts& prechecked, const Workspace& ws) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
+
     // Try to add the transaction to the mempool, removing any conflicts first.
     // Returns true if the transaction is in the mempool after any size
     // limiting is performed, false otherwise.
@@ -923,6 +1048,12 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
         return state.Invalid(TxValidationResult::TX_CONSENSUS, "bad-txns-spends-conflicting-tx", *err_string);
     }
 
+    // If the mempool tracks clusters, the transaction must not make its cluster
+    // too expensive to linearize. Transactions it replaces don't count.
+    if (!m_pool.CheckClusterLimits({ws.m_ptx}, ws.m_iters_conflicting, errString)) {
+        return state.Invalid(TxValidationResult::TX_MEMPOOL_POLICY, "too-large-cluster", errString);
+    }
+
     m_rbf = !ws.m_conflicts.empty();
     return true;
 }
@@ -998,27 +1129,48 @@ bool MemPoolAccept::PolicyScriptChecks(const ATMPArgs& args, Workspace& ws)
     const CTransaction& tx = *ws.m_ptx;
     TxValidationState& state = ws.m_state;
 
-    constexpr unsigned int scriptVerifyFlags = STANDARD_SCRIPT_VERIFY_FLAGS;
-
     // Check input scripts and signatures.
     // This is done last to help prevent CPU exhaustion denial-of-service attacks.
-    if (!CheckInputScripts(tx, state, m_view, scriptVerifyFlags, true, false, ws.m_precomputed_txdata)) {
-        // SCRIPT_VERIFY_CLEANSTACK requires SCRIPT_VERIFY_WITNESS, so we
-        // need to turn both off, and compare against just turning off CLEANSTACK
-        // to see if the failure is specifically due to witness validation.
-        TxValidationState state_dummy; // Want reported failures to be from first CheckInputScripts
-        if (!tx.HasWitness() && CheckInputScripts(tx, state_dummy, m_view, scriptVerifyFlags & ~(SCRIPT_VERIFY_WITNESS | SCRIPT_VERIFY_CLEANSTACK), true, false, ws.m_precomputed_txdata) &&
-            !CheckInputScripts(tx, state_dummy, m_view, scriptVerifyFlags & ~SCRIPT_VERIFY_CLEANSTACK, true, false, ws.m_precomputed_txdata)) {
-            // Only the witness is missing, so the transaction itself may be fine.
-            state.Invalid(TxValidationResult::TX_WITNESS_STRIPPED,
-                          state.GetRejectReason(), state.GetDebugMessage());
-        }
-        return false; // state filled in by CheckInputScripts
-    }
+    return CheckStandardInputScripts(tx, state, [&](TxValidationState& check_state, unsigned int flags) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
+        return CheckInputScripts(tx, check_state, m_view, flags, true, false, ws.m_precomputed_txdata);
+    });
+}
+
+bool MemPoolAccept::PrecheckApplies(const PrecheckedScripts& prechecked, const Workspace& ws)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(m_pool.cs);
+    const CTransaction& tx = *ws.m_ptx;
 
+    if (prechecked.m_wtxid != tx.GetWitnessHash() || prechecked.m_spent_outputs.size() != tx.vin.size()) return false;
+    if (prechecked.m_script_flags != GetBlockScriptFlags(*m_active_chainstate.m_chain.Tip(), m_active_chainstate.m_chainman)) return false;
+    // PreChecks() put all spent coins into m_view.
+    for (size_t i = 0; i < tx.vin.size(); ++i) {
+        if (m_view.AccessCoin(tx.vin[i].prevout).out != prechecked.m_spent_outputs[i]) return false;
+    }
     return true;
 }
 
+bool MemPoolAccept::ParallelPolicyScriptChecks(std::vector<Workspace>& workspaces)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(m_pool.cs);
+    if (!g_parallel_script_checks) return false;
+
+    // The checks keep pointers to the workspaces' transactions and
+    // precomputed data, which must not move until Wait() returns.
+    CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+    for (Workspace& ws : workspaces) {
+        std::vector<CScriptCheck> checks;
+        TxValidationState state_dummy;
+        if (!CheckInputScripts(*ws.m_ptx, state_dummy, m_view, STANDARD_SCRIPT_VERIFY_FLAGS, true, false, ws.m_precomputed_txdata, &checks)) {
+            return false;
+        }
+        control.Add(checks);
+    }
+    return control.Wait();
+}
+
 bool MemPoolAccept::ConsensusScriptChecks(const ATMPArgs& args, Workspace& ws)
 {
     AssertLockHeld(cs_main);
@@ -1185,9 +1337,18 @@ MempoolAcceptResult MemPoolAccept::AcceptSingleTransaction(const CTransactionRef
 
     // Perform the inexpensive checks first and avoid hashing and signature verification unless
     // those checks pass, to mitigate CPU exhaustion denial-of-service attacks.
-    if (!PolicyScriptChecks(args, ws)) return MempoolAcceptResult::Failure(ws.m_state);
+    const bool prechecked{!args.m_skip_script_checks && args.m_prechecked && PrecheckApplies(*args.m_prechecked, ws)};
+    if (prechecked) {
+        // The scripts were already verified against the same outputs and flags.
+        if (!args.m_prechecked->m_state.IsValid()) {
+            ws.m_state = args.m_prechecked->m_state;
+            return MempoolAcceptResult::Failure(ws.m_state);
+        }
+    } else if (!args.m_skip_script_checks) {
+        if (!PolicyScriptChecks(args, ws)) return MempoolAcceptResult::Failure(ws.m_state);
 
-    if (!ConsensusScriptChecks(args, ws)) return MempoolAcceptResult::Failure(ws.m_state);
+        if (!ConsensusScriptChecks(args, ws)) return MempoolAcceptResult::Failure(ws.m_state);
+    }
 
     // Tx was accepted, but not added
     if (args.m_test_accept) {
@@ -1196,6 +1357,10 @@ MempoolAcceptResult MemPoolAccept::AcceptSingleTransaction(const CTransactionRef
 
     if (!Finalize(args, ws)) return MempoolAcceptResult::Failure(ws.m_state);
 
+    // Like ConsensusScriptChecks() does, cache the script execution for block
+    // validation, but only now that the transaction was accepted.
+    if (prechecked) AddToScriptExecutionCache(*ptx, args.m_prechecked->m_script_flags);
+
     GetMainSignals().TransactionAddedToMempool(ptx, m_pool.GetAndIncrementSequence());
 
     return MempoolAcceptResult::Success(std::move(ws.m_replaced_transactions), ws.m_vsize, ws.m_base_fees);
@@ -1256,8 +1421,11 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptMultipleTransactions(const std::
         return PackageMempoolAcceptResult(package_state, package_feerate, std::move(results));
     }
 
+    // Verify the scripts of all transactions in parallel first. Only if that
+    // fails are they checked one by one, which tells which transaction failed.
+    const bool scripts_ok{ParallelPolicyScriptChecks(workspaces)};
     for (Workspace& ws : workspaces) {
-        if (!PolicyScriptChecks(args, ws)) {
+        if (!scripts_ok && !PolicyScriptChecks(args, ws)) {
             // Exit early to avoid doing pointless work. Update the failed tx result; the rest are unfinished.
             package_state.Invalid(PackageValidationResult::PCKG_TX, "transaction failed");
             results.emplace(ws.m_ptx->GetWitnessHash(), MempoolAcceptResult::Failure(ws.m_state));
@@ -1417,7 +1585,8 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptPackage(const Package& package,
 } // namespace
 
 MempoolAcceptResult AcceptToMemoryPool(Chainstate& active_chainstate, const CTransactionRef& tx,
-                                       int64_t accept_time, bool bypass_limits, bool test_accept)
+                                       int64_t accept_time, bool bypass_limits, bool test_accept,
+                                       bool skip_script_checks, const PrecheckedScripts* prechecked)
     EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
 {
     AssertLockHeld(::cs_main);
@@ -1426,7 +1595,7 @@ MempoolAcceptResult AcceptToMemoryPool(Chainstate& active_chainstate, const CTra
     CTxMemPool& pool{*active_chainstate.GetMempool()};
 
     std::vector<COutPoint> coins_to_uncache;
-    auto args = MemPoolAccept::ATMPArgs::SingleAccept(chainparams, accept_time, bypass_limits, coins_to_uncache, test_accept);
+    auto args = MemPoolAccept::ATMPArgs::SingleAccept(chainparams, accept_time, bypass_limits, coins_to_uncache, test_accept, skip_script_checks, prechecked);
     const MempoolAcceptResult result = MemPoolAccept(pool, active_chainstate).AcceptSingleTransaction(tx, args);
     if (result.m_result_type != MempoolAcceptResult::ResultType::VALID) {
         // Remove coins that were not present in the coins cache before calling
@@ -1660,6 +1829,15 @@ bool CScriptCheck::operator()()
 static CuckooCache::cache<uint256, SignatureCacheHasher> g_scriptExecutionCache;
 static CSHA256 g_scriptExecutionCacheHasher;
 
+/** The entry of the script execution cache for the scripts of tx with the given flags. */
+static uint256 ScriptExecutionCacheEntry(const CTransaction& tx, unsigned int flags)
+{
+    uint256 hashCacheEntry;
+    CSHA256 hasher = g_scriptExecutionCacheHasher;
+    hasher.Write(tx.GetWitnessHash().begin(), 32).Write((unsigned char*)&flags, sizeof(flags)).Finalize(hashCacheEntry.begin());
+    return hashCacheEntry;
+}
+
 bool InitScriptExecutionCache(size_t max_size_bytes)
 {
     // Setup the salted hasher
@@ -1714,9 +1892,7 @@ bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
     // correct (ie that the transaction hash which is in tx's prevouts
     // properly commits to the scriptPubKey in the inputs view of that
     // transaction).
-    uint256 hashCacheEntry;
-    CSHA256 hasher = g_scriptExecutionCacheHasher;
-    hasher.Write(tx.GetWitnessHash().begin(), 32).Write((unsigned char*)&flags, sizeof(flags)).Finalize(hashCacheEntry.begin());
+    const uint256 hashCacheEntry{ScriptExecutionCacheEntry(tx, flags)};
     AssertLockHeld(cs_main); // TODO: Remove this requirement by making CuckooCache not require external locks
     if (g_scriptExecutionCache.contains(hashCacheEntry, !cacheFullScriptStore)) {
         return true;
@@ -1734,6 +1910,27 @@ bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
         }
         txdata.Init(tx, std::move(spent_outputs));
     }
+
+    if (!VerifyInputScripts(tx, state, flags, cacheSigStore, txdata, pvChecks)) return false;
+
+    if (cacheFullScriptStore && !pvChecks) {
+        // We executed all of the provided scripts, and were told to
+        // cache the result. Do so now.
+        g_scriptExecutionCache.insert(hashCacheEntry);
+    }
+
+    return true;
+}
+
+/**
+ * Verify the input scripts of tx against the spent outputs in txdata, like
+ * CheckInputScripts() but without consulting the script execution cache, so
+ * this does not need cs_main.
+ */
+static bool VerifyInputScripts(const CTransaction& tx, TxValidationState& state, unsigned int flags,
+                               bool cacheSigStore, PrecomputedTransactionData& txdata,
+                               std::vector<CScriptCheck>* pvChecks)
+{
     assert(txdata.m_spent_outputs.size() == tx.vin.size());
 
     for (unsigned int i = 0; i < tx.vin.size(); i++) {
@@ -1776,15 +1973,15 @@ bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
         }
     }
 
-    if (cacheFullScriptStore && !pvChecks) {
-        // We executed all of the provided scripts, and were told to
-        // cache the result. Do so now.
-        g_scriptExecutionCache.insert(hashCacheEntry);
-    }
-
     return true;
 }
 
+static void AddToScriptExecutionCache(const CTransaction& tx, unsigned int flags)
+{
+    AssertLockHeld(cs_main);
+    g_scriptExecutionCache.insert(ScriptExecutionCacheEntry(tx, flags));
+}
+
 bool AbortNode(BlockValidationState& state, const std::string& strMessage, const bilingual_str& userMessage)
 {
     AbortNode(strMessage, userMessage);
@@ -1834,7 +2031,7 @@ DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIn
     bool fClean = true;
 
     CBlockUndo blockUndo;
-    if (!UndoReadFromDisk(blockUndo, pindex)) {
+    if (!m_blockman.UndoReadFromDisk(blockUndo, pindex)) {
         error("DisconnectBlock(): failure reading undo data");
         return DISCONNECT_FAILED;
     }
@@ -1887,8 +2084,6 @@ DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIn
     return fClean ? DISCONNECT_OK : DISCONNECT_UNCLEAN;
 }
 
-static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
-
 void StartScriptCheckWorkerThreads(int threads_num)
 {
     scriptcheckqueue.StartWorkerThreads(threads_num);
@@ -1899,6 +2094,18 @@ void StopScriptCheckWorkerThreads()
     scriptcheckqueue.StopWorkerThreads();
 }
 
+static InputFetcher inputfetcher;
+
+void StartInputFetchWorkerThreads(int threads_num)
+{
+    inputfetcher.StartWorkerThreads(threads_num);
+}
+
+void StopInputFetchWorkerThreads()
+{
+    inputfetcher.StopWorkerThreads();
+}
+
 /**
  * Threshold condition checker that triggers when unknown versionbits are seen on the network.
  */
@@ -2431,7 +2638,7 @@ bool Chainstate::FlushStateToDisk(
                 if (fFlushForPrune) {
                     LOG_TIME_MILLIS_WITH_CATEGORY("unlink pruned files", BCLog::BENCH);
 
-                    UnlinkPrunedFiles(setFilesToPrune);
+                    m_blockman.UnlinkPrunedFiles(setFilesToPrune);
                 }
                 nLastWrite = nNow;
             }
@@ -2450,8 +2657,13 @@ bool Chainstate::FlushStateToDisk(
                     return AbortNode(state, "Disk space is too low!", _("Disk space is too low!"));
                 }
                 // Flush the chainstate (which may refer to block index entries).
-                if (!CoinsTip().Flush())
+                // Only empty the cache when it is over budget or a full flush
+                // was explicitly requested; periodic and prune-triggered writes
+                // just sync the dirty entries and keep the cache warm.
+                const bool empty_cache{(mode == FlushStateMode::ALWAYS) || fCacheLarge || fCacheCritical};
+                if (empty_cache ? !CoinsTip().Flush() : !CoinsTip().Sync()) {
                     return AbortNode(state, "Failed to write to coin database");
+                }
                 nLastFlush = nNow;
                 full_flush_completed = true;
                 TRACE5(utxocache, flush,
@@ -2593,7 +2805,7 @@ bool Chainstate::DisconnectTip(BlockValidationState& state, DisconnectedBlockTra
     // Read block from disk.
     std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
     CBlock& block = *pblock;
-    if (!ReadBlockFromDisk(block, pindexDelete, m_params.GetConsensus())) {
+    if (!m_blockman.ReadBlockFromDisk(block, pindexDelete, m_params.GetConsensus())) {
         return error("DisconnectTip(): Failed to read block");
     }
     // Apply the block atomically to the chain state.
@@ -2647,6 +2859,7 @@ bool Chainstate::DisconnectTip(BlockValidationState& state, DisconnectedBlockTra
 }
 
 static int64_t nTimeReadFromDiskTotal = 0;
+static int64_t nTimeFetchInputsTotal = 0;
 static int64_t nTimeConnectTotal = 0;
 static int64_t nTimeFlush = 0;
 static int64_t nTimeChainState = 0;
@@ -2712,7 +2925,7 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
     std::shared_ptr<const CBlock> pthisBlock;
     if (!pblock) {
         std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
-        if (!ReadBlockFromDisk(*pblockNew, pindexNew, m_params.GetConsensus())) {
+        if (!m_blockman.ReadBlockFromDisk(*pblockNew, pindexNew, m_params.GetConsensus())) {
             return AbortNode(state, "Failed to read block");
         }
         pthisBlock = pblockNew;
@@ -2726,6 +2939,15 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
     nTimeReadFromDiskTotal += nTime2 - nTime1;
     int64_t nTime3;
     LogPrint(BCLog::BENCH, "  - Load block from disk: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime2 - nTime1) * MILLI, nTimeReadFromDiskTotal * MICRO, nTimeReadFromDiskTotal * MILLI / nBlocksTotal);
+    if (g_parallel_input_fetch) {
+        // Warm the coins cache with the block's inputs, reading the missing
+        // ones from disk in parallel instead of one at a time in ConnectBlock.
+        inputfetcher.FetchInputs(CoinsTip(), CoinsDB(), blockConnecting);
+        const int64_t nTimeFetched{GetTimeMicros()};
+        nTimeFetchInputsTotal += nTimeFetched - nTime2;
+        LogPrint(BCLog::BENCH, "  - Fetch inputs: %.2fms [%.2fs (%.2fms/blk)] [%u hits, %u misses]\n", (nTimeFetched - nTime2) * MILLI, nTimeFetchInputsTotal * MICRO, nTimeFetchInputsTotal * MILLI / nBlocksTotal, inputfetcher.GetHits(), inputfetcher.GetMisses());
+        nTime2 = nTimeFetched;
+    }
     {
         CCoinsViewCache view(&CoinsTip());
         bool rv = ConnectBlock(blockConnecting, state, pindexNew, view);
@@ -3877,7 +4099,7 @@ bool ChainstateManager::ProcessNewBlock(const std::shared_ptr<const CBlock>& blo
     return true;
 }
 
-MempoolAcceptResult ChainstateManager::ProcessTransaction(const CTransactionRef& tx, bool test_accept)
+MempoolAcceptResult ChainstateManager::ProcessTransaction(const CTransactionRef& tx, bool test_accept, const PrecheckedScripts* prechecked)
 {
     AssertLockHeld(cs_main);
     Chainstate& active_chainstate = ActiveChainstate();
@@ -3886,11 +4108,95 @@ MempoolAcceptResult ChainstateManager::ProcessTransaction(const CTransactionRef&
         state.Invalid(TxValidationResult::TX_NO_MEMPOOL, "no-mempool");
         return MempoolAcceptResult::Failure(state);
     }
-    auto result = AcceptToMemoryPool(active_chainstate, tx, GetTime(), /*bypass_limits=*/false, test_accept);
+    auto result = AcceptToMemoryPool(active_chainstate, tx, GetTime(), /*bypass_limits=*/false, test_accept, /*skip_script_checks=*/false, prechecked);
     active_chainstate.GetMempool()->check(active_chainstate.CoinsTip(), active_chainstate.m_chain.Height() + 1);
     return result;
 }
 
+std::optional<PrecheckedScripts> ChainstateManager::PrecheckTransactionScripts(const CTransactionRef& ptx)
+{
+    const CTransaction& tx{*ptx};
+    TxValidationState state;
+    if (tx.IsCoinBase() || !CheckTransaction(tx, state)) return std::nullopt;
+
+    PrecheckedScripts result;
+    result.m_wtxid = tx.GetWitnessHash();
+    {
+        LOCK(cs_main);
+        const CTxMemPool* pool{ActiveChainstate().GetMempool()};
+        if (!pool) return std::nullopt;
+        std::string reason;
+        if (pool->m_require_standard && !IsStandardTx(tx, pool->m_max_datacarrier_bytes, pool->m_permit_bare_multisig, pool->m_dust_relay_feerate, reason)) return std::nullopt;
+
+        LOCK(pool->cs);
+        if (pool->exists(GenTxid::Txid(tx.GetHash()))) return std::nullopt;
+        // Leave conflicting transactions to AcceptToMemoryPool. Whether they
+        // replace anything depends on checks that are not worth repeating here.
+        for (const CTxIn& txin : tx.vin) {
+            if (pool->GetConflictTx(txin.prevout)) return std::nullopt;
+        }
+        CCoinsViewCache& coins_tip{ActiveChainstate().CoinsTip()};
+        CCoinsViewMemPool view_mempool{&coins_tip, *pool};
+        CCoinsViewCache view{&view_mempool};
+        // Like AcceptToMemoryPool, don't leave coins in the cache that were
+        // only loaded for this transaction.
+        std::vector<COutPoint> coins_to_uncache;
+        bool have_inputs{true};
+        for (const CTxIn& txin : tx.vin) {
+            if (!coins_tip.HaveCoinInCache(txin.prevout)) coins_to_uncache.push_back(txin.prevout);
+            if (!view.HaveCoin(txin.prevout)) {
+                have_inputs = false;
+                break;
+            }
+        }
+        for (const COutPoint& outpoint : coins_to_uncache) coins_tip.Uncache(outpoint);
+        if (!have_inputs) return std::nullopt;
+
+        if (pool->m_require_standard && (!AreInputsStandard(tx, view) || (tx.HasWitness() && !IsWitnessStandard(tx, view)))) return std::nullopt;
+        CAmount value_in{0};
+        result.m_spent_outputs.reserve(tx.vin.size());
+        for (const CTxIn& txin : tx.vin) {
+            result.m_spent_outputs.push_back(view.AccessCoin(txin.prevout).out);
+            value_in += result.m_spent_outputs.back().nValue;
+            if (!MoneyRange(result.m_spent_outputs.back().nValue) || !MoneyRange(value_in)) return std::nullopt;
+        }
+        if (value_in < tx.GetValueOut()) return std::nullopt;
+        const int64_t sigops_cost{GetTransactionSigOpCost(tx, view, STANDARD_SCRIPT_VERIFY_FLAGS)};
+        if (sigops_cost > MAX_STANDARD_TX_SIGOPS_COST) return std::nullopt;
+        const CTxMemPoolEntry entry{ptx, value_in - tx.GetValueOut(), /*time=*/0, /*entry_height=*/0, /*spends_coinbase=*/false, sigops_cost, LockPoints{}};
+        CAmount modified_fee{entry.GetFee()};
+        pool->ApplyDelta(tx.GetHash(), modified_fee);
+        if (modified_fee < pool->GetMinFee().GetFee(entry.GetTxSize()) || modified_fee < pool->m_min_relay_feerate.GetFee(entry.GetTxSize())) return std::nullopt;
+
+        // Nor verify the scripts of transactions that won't fit the package
+        // limits. Those that only fit by the CPFP carve-out are verified by
+        // AcceptToMemoryPool.
+        const CTxMemPool::Limits& limits{pool->m_limits};
+        CTxMemPool::setEntries ancestors;
+        std::string err_string;
+        if (!pool->CalculateMemPoolAncestors(entry, ancestors, limits.ancestor_count, limits.ancestor_size_vbytes,
+                                             limits.descendant_count, limits.descendant_size_vbytes, err_string) ||
+            !pool->CheckClusterLimits({ptx}, /*conflicts=*/{}, err_string)) {
+            return std::nullopt;
+        }
+
+        result.m_script_flags = GetBlockScriptFlags(*ActiveChain().Tip(), *this);
+    }
+
+    PrecomputedTransactionData txdata;
+    txdata.Init(tx, std::vector<CTxOut>{result.m_spent_outputs});
+    if (CheckStandardInputScripts(tx, result.m_state, [&](TxValidationState& check_state, unsigned int flags) {
+            return VerifyInputScripts(tx, check_state, flags, /*cacheSigStore=*/false, txdata);
+        })) {
+        // Also check against the tip's flags like ConsensusScriptChecks()
+        // does. If that fails but the standard flags passed, leave reporting
+        // the bug to AcceptToMemoryPool.
+        TxValidationState consensus_state;
+        if (!VerifyInputScripts(tx, consensus_state, result.m_script_flags, /*cacheSigStore=*/false, txdata)) return std::nullopt;
+    }
+    return result;
+}
+
 bool TestBlockValidity(BlockValidationState& state,
                        const CChainParams& chainparams,
                        Chainstate& chainstate,
@@ -3934,10 +4240,10 @@ void PruneBlockFilesManual(Chainstate& active_chainstate, int nManualPruneHeight
     }
 }
 
-void Chainstate::LoadMempool(const fs::path& load_path, FopenFn mockable_fopen_function)
+void Chainstate::LoadMempool(const fs::path& load_path, kernel::ImportMempoolOptions&& opts)
 {
     if (!m_mempool) return;
-    ::LoadMempool(*m_mempool, load_path, *this, mockable_fopen_function);
+    ::LoadMempool(*m_mempool, load_path, *this, std::move(opts));
     m_mempool->SetLoadTried(!ShutdownRequested());
 }
 
@@ -4026,7 +4332,7 @@ bool CVerifyDB::VerifyDB(
         }
         CBlock block;
         // check level 0: read from disk
-        if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+        if (!chainstate.m_blockman.ReadBlockFromDisk(block, pindex, consensus_params)) {
             return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
         }
         // check level 1: verify block validity
@@ -4038,7 +4344,7 @@ bool CVerifyDB::VerifyDB(
         if (nCheckLevel >= 2 && pindex) {
             CBlockUndo undo;
             if (!pindex->GetUndoPos().IsNull()) {
-                if (!UndoReadFromDisk(undo, pindex)) {
+                if (!chainstate.m_blockman.UndoReadFromDisk(undo, pindex)) {
                     return error("VerifyDB(): *** found bad undo data at %d, hash=%s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
                 }
             }
@@ -4080,7 +4386,7 @@ bool CVerifyDB::VerifyDB(
             uiInterface.ShowProgress(_("Verifying blocks…").translated, percentageDone, false);
             pindex = chainstate.m_chain.Next(pindex);
             CBlock block;
-            if (!ReadBlockFromDisk(block, pindex, consensus_params))
+            if (!chainstate.m_blockman.ReadBlockFromDisk(block, pindex, consensus_params))
                 return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
             if (!chainstate.ConnectBlock(block, state, pindex, coins)) {
                 return error("VerifyDB(): *** found unconnectable block at %d, hash=%s (%s)", pindex->nHeight, pindex->GetBlockHash().ToString(), state.ToString());
@@ -4101,7 +4407,7 @@ bool Chainstate::RollforwardBlock(const CBlockIndex* pindex, CCoinsViewCache& in
     AssertLockHeld(cs_main);
     // TODO: merge with ConnectBlock
     CBlock block;
-    if (!ReadBlockFromDisk(block, pindex, m_params.GetConsensus())) {
+    if (!m_blockman.ReadBlockFromDisk(block, pindex, m_params.GetConsensus())) {
         return error("ReplayBlock(): ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
     }
 
@@ -4153,7 +4459,7 @@ bool Chainstate::ReplayBlocks()
     while (pindexOld != pindexFork) {
         if (pindexOld->nHeight > 0) { // Never disconnect the genesis block.
             CBlock block;
-            if (!ReadBlockFromDisk(block, pindexOld, m_params.GetConsensus())) {
+            if (!m_blockman.ReadBlockFromDisk(block, pindexOld, m_params.GetConsensus())) {
                 return error("RollbackBlock(): ReadBlockFromDisk() failed at %d, hash=%s", pindexOld->nHeight, pindexOld->GetBlockHash().ToString());
             }
             LogPrintf("Rolling back %s (%i)\n", pindexOld->GetBlockHash().ToString(), pindexOld->nHeight);
@@ -4428,7 +4734,7 @@ void Chainstate::LoadExternalBlockFile(
                     while (range.first != range.second) {
                         std::multimap<uint256, FlatFilePos>::iterator it = range.first;
                         std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
-                        if (ReadBlockFromDisk(*pblockrecursive, it->second, m_params.GetConsensus())) {
+                        if (m_blockman.ReadBlockFromDisk(*pblockrecursive, it->second, m_params.GetConsensus())) {
                             LogPrint(BCLog::REINDEX, "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
                                      head.ToString());
                             LOCK(cs_main);
@@ -4881,17 +5187,303 @@ bool ChainstateManager::ActivateSnapshot(
     return true;
 }
 
-static void FlushSnapshotToDisk(CCoinsViewCache& coins_cache, bool snapshot_loaded)
+static void FlushSnapshotToDisk(CCoinsViewCache& coins_cache)
 {
     LOG_TIME_MILLIS_WITH_CATEGORY_MSG_ONCE(
-        strprintf("%s (%.2f MB)",
-                  snapshot_loaded ? "saving snapshot chainstate" : "flushing coins cache",
+        strprintf("saving snapshot chainstate (%.2f MB)",
                   coins_cache.DynamicMemoryUsage() / (1000 * 1000)),
         BCLog::LogFlags::ALL);
 
     coins_cache.Flush();
 }
 
+//! Coins of a UTXO snapshot that are read before they are deserialized and
+//! written together. Shutdown requests are checked between chunks.
+static constexpr uint64_t SNAPSHOT_CHUNK_COINS{120000};
+//! Coins of a chunk that are deserialized and written with one batch. In
+//! chunked snapshots, every chunk of the snapshot is a slice instead.
+static constexpr uint64_t SNAPSHOT_SLICE_COINS{4096};
+//! Largest serialized outpoint and coin: txid, index, code, amount, script size and script
+static constexpr uint64_t MAX_SNAPSHOT_COIN_SIZE{sizeof(uint256) + sizeof(uint32_t) + 5 + 10 + 5 + MAX_SCRIPT_SIZE};
+
+namespace {
+/** Reads from a snapshot file, keeping a copy of the bytes read. */
+class SnapshotRecorder
+{
+    AutoFile& m_file;
+    std::vector<unsigned char>& m_data;
+
+public:
+    SnapshotRecorder(AutoFile& file, std::vector<unsigned char>& data) : m_file{file}, m_data{data} {}
+
+    void read(Span<std::byte> dst)
+    {
+        m_file.read(dst);
+        m_data.insert(m_data.end(), UCharCast(dst.data()), UCharCast(dst.data() + dst.size()));
+    }
+
+    void ignore(size_t size)
+    {
+        const size_t pos{m_data.size()};
+        m_data.resize(pos + size);
+        m_file.read(AsWritableBytes(Span{m_data}.subspan(pos)));
+    }
+
+    template <typename T>
+    SnapshotRecorder& operator>>(T&& obj)
+    {
+        ::Unserialize(*this, obj);
+        return *this;
+    }
+};
+
+/**
+ * Read over an outpoint and its coin as serialized in a snapshot, only
+ * decoding the lengths, so that the expensive part of deserializing them can
+ * be done in parallel.
+ */
+void SkipSnapshotCoin(SnapshotRecorder& recorder)
+{
+    // COutPoint
+    recorder.ignore(sizeof(uint256) + sizeof(uint32_t));
+    // Coin
+    uint32_t code;
+    recorder >> VARINT(code);
+    uint64_t compressed_amount;
+    recorder >> VARINT(compressed_amount);
+    unsigned int script_size;
+    recorder >> VARINT(script_size);
+    if (script_size < ScriptCompression::nSpecialScripts) {
+        recorder.ignore(GetSpecialScriptSize(script_size));
+        return;
+    }
+    script_size -= ScriptCompression::nSpecialScripts;
+    // Outputs with larger scripts are unspendable, so they never make it into
+    // the UTXO set. Rejecting them also bounds what is buffered.
+    if (script_size > MAX_SCRIPT_SIZE) throw std::ios_base::failure("oversized script");
+    recorder.ignore(script_size);
+}
+
+struct SnapshotChunk {
+    //! Outpoints and coins as serialized in the snapshot
+    std::vector<unsigned char> data;
+    //! Where the coins of each slice start in data, followed by the end of data
+    std::vector<size_t> slice_offsets;
+    //! Number of coins in each slice
+    std::vector<uint32_t> slice_coins;
+    //! Hash of each slice as serialized, only for chunked snapshots
+    std::vector<uint256> slice_checksums;
+    //! Coins of each slice, sorted by outpoint
+    std::vector<std::vector<std::pair<COutPoint, Coin>>> slices;
+};
+} // namespace
+
+bool LoadSnapshotCoins(AutoFile& coins_file, const SnapshotMetadata& metadata, int base_height,
+                       CCoinsViewDB& coins_db, std::optional<CCoinsStats>& stats)
+{
+    const uint64_t coins_count{metadata.m_coins_count};
+    const size_t num_threads{size_t(std::max(GetNumCores(), 1))};
+    // Chunked snapshots say where their chunks end and what they hash to, so
+    // they can be verified and deserialized independently. Unchunked ones
+    // have to be read over coin by coin to find where slices end.
+    const bool chunked{metadata.m_version == SNAPSHOT_VERSION};
+    uint64_t chunks_read{0};
+    std::vector<uint64_t> chunk_offsets;
+    uint64_t offset{SNAPSHOT_METADATA_SIZE};
+
+    // The coins of a chunk are added to the statistics on their own thread
+    // while the next chunk is read, deserialized and written. The hash is a
+    // single stream, so it can't be split further.
+    CoinsStatsBuilder stats_builder{base_height, metadata.m_base_blockhash};
+    bool in_order{true};
+    std::thread stats_thread;
+    const auto join_stats_thread{[&] {
+        if (stats_thread.joinable()) stats_thread.join();
+    }};
+    SnapshotChunk chunks[2];
+
+    uint64_t coins_loaded{0};
+    for (size_t c = 0; chunked ? chunks_read < metadata.m_chunk_count : coins_loaded < coins_count; ++c) {
+        SnapshotChunk& chunk{chunks[c % 2]};
+        chunk.data.clear();
+        chunk.slice_offsets.clear();
+        chunk.slice_coins.clear();
+        chunk.slice_checksums.clear();
+        const uint64_t first_chunk{chunks_read};
+        uint64_t coins_read{0};
+        try {
+            if (chunked) {
+                for (; chunks_read < metadata.m_chunk_count && coins_read < SNAPSHOT_CHUNK_COINS; ++chunks_read) {
+                    SnapshotChunkHeader header;
+                    coins_file >> header;
+                    if (header.coins_count == 0 || header.coins_count > SNAPSHOT_CHUNK_MAX_COINS ||
+                        header.size > header.coins_count * MAX_SNAPSHOT_COIN_SIZE ||
+                        header.coins_count > coins_count - coins_loaded - coins_read) {
+                        LogPrintf("[snapshot] bad snapshot - invalid header of chunk %d\n", chunks_read);
+                        join_stats_thread();
+                        return false;
+                    }
+                    chunk_offsets.push_back(offset);
+                    offset += SNAPSHOT_CHUNK_HEADER_SIZE + header.size;
+                    chunk.slice_offsets.push_back(chunk.data.size());
+                    chunk.slice_coins.push_back(header.coins_count);
+                    chunk.slice_checksums.push_back(header.checksum);
+                    chunk.data.resize(chunk.data.size() + header.size);
+                    coins_file.read(AsWritableBytes(Span{chunk.data}.subspan(chunk.slice_offsets.back())));
+                    coins_read += header.coins_count;
+                }
+            } else {
+                SnapshotRecorder recorder{coins_file, chunk.data};
+                const uint64_t chunk_coins{std::min(SNAPSHOT_CHUNK_COINS, coins_count - coins_loaded)};
+                for (; coins_read < chunk_coins; ++coins_read) {
+                    if (coins_read % SNAPSHOT_SLICE_COINS == 0) {
+                        chunk.slice_offsets.push_back(chunk.data.size());
+                        chunk.slice_coins.push_back(0);
+                    }
+                    SkipSnapshotCoin(recorder);
+                    ++chunk.slice_coins.back();
+                }
+            }
+        } catch (const std::ios_base::failure&) {
+            LogPrintf("[snapshot] bad snapshot format or truncated snapshot after deserializing %d coins\n",
+                      coins_loaded + coins_read);
+            join_stats_thread();
+            return false;
+        }
+        chunk.slice_offsets.push_back(chunk.data.size());
+        // The previous user of this chunk's slices was joined before the
+        // previous chunk was handed to the statistics thread.
+        chunk.slices.resize(chunk.slice_coins.size());
+
+        std::atomic<size_t> next{0};
+        std::atomic<bool> failed{false};
+        const auto work{[&] {
+            for (size_t s; (s = next++) < chunk.slices.size() && !failed;) {
+                std::vector<std::pair<COutPoint, Coin>>& coins{chunk.slices[s]};
+                coins.clear();
+                const Span<const unsigned char> data{Span{chunk.data}.subspan(chunk.slice_offsets[s], chunk.slice_offsets[s + 1] - chunk.slice_offsets[s])};
+                if (chunked && Hash(data) != chunk.slice_checksums[s]) {
+                    LogPrintf("[snapshot] bad snapshot - checksum mismatch in chunk %d\n", first_chunk + s);
+                    failed = true;
+                    return;
+                }
+                SpanReader stream{SER_DISK, CLIENT_VERSION, data};
+                try {
+                    while (!stream.empty()) {
+                        auto& [outpoint, coin]{coins.emplace_back()};
+                        stream >> outpoint >> coin;
+                        if (coin.nHeight > base_height ||
+                            outpoint.n >= std::numeric_limits<decltype(outpoint.n)>::max() // Avoid integer wrap-around in coinstats.cpp:ApplyHash
+                        ) {
+                            LogPrintf("[snapshot] bad snapshot data after deserializing %d coins\n",
+                                      coins_loaded + std::accumulate(chunk.slice_coins.begin(), chunk.slice_coins.begin() + s, uint64_t{0}) + coins.size() - 1);
+                            failed = true;
+                            return;
+                        }
+                    }
+                } catch (const std::ios_base::failure&) {
+                    coins.clear();
+                }
+                if (coins.size() != chunk.slice_coins[s]) {
+                    LogPrintf("[snapshot] bad snapshot format in chunk %d\n", first_chunk + s);
+                    failed = true;
+                    return;
+                }
+                // Snapshots are written in database order, so this is usually
+                // a no-op, and the batch is in key order.
+                const auto by_outpoint{[](const auto& a, const auto& b) { return a.first < b.first; }};
+                if (!std::is_sorted(coins.begin(), coins.end(), by_outpoint)) {
+                    std::sort(coins.begin(), coins.end(), by_outpoint);
+                }
+                try {
+                    if (!coins_db.WriteCoins(coins)) failed = true;
+                } catch (const dbwrapper_error& e) {
+                    LogPrintf("[snapshot] failed to write coins: %s\n", e.what());
+                    failed = true;
+                }
+            }
+        }};
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < std::min(num_threads, chunk.slices.size()); ++i) {
+            threads.emplace_back(work);
+        }
+        work();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        if (failed) {
+            join_stats_thread();
+            return false;
+        }
+
+        join_stats_thread();
+        stats_thread = std::thread{[&stats_builder, &in_order, &slices = chunk.slices] {
+            for (auto& coins : slices) {
+                for (auto& [outpoint, coin] : coins) {
+                    if (in_order && !stats_builder.Add(outpoint, std::move(coin))) in_order = false;
+                }
+            }
+        }};
+
+        coins_loaded += coins_read;
+        if (coins_loaded / 1000000 != (coins_loaded - coins_read) / 1000000) {
+            LogPrintf("[snapshot] %d coins loaded (%.2f%%)\n",
+                      coins_loaded,
+                      static_cast<float>(coins_loaded) * 100 / static_cast<float>(coins_count));
+        }
+        if (ShutdownRequested()) {
+            join_stats_thread();
+            return false;
+        }
+    }
+    join_stats_thread();
+
+    if (chunked) {
+        if (coins_loaded != coins_count) {
+            LogPrintf("[snapshot] bad snapshot - %d coins in chunks, expected %d\n", coins_loaded, coins_count);
+            return false;
+        }
+        // The index, which is only needed to seek to chunks, has to match
+        // where they were found.
+        bool index_ok{metadata.m_index_offset == offset};
+        try {
+            for (size_t i = 0; index_ok && i < chunk_offsets.size(); ++i) {
+                uint64_t chunk_offset;
+                coins_file >> chunk_offset;
+                index_ok = chunk_offset == chunk_offsets[i];
+            }
+        } catch (const std::ios_base::failure&) {
+            index_ok = false;
+        }
+        if (!index_ok) {
+            LogPrintf("[snapshot] bad snapshot - chunk index does not match the chunks\n");
+            return false;
+        }
+    }
+
+    bool out_of_coins{false};
+    try {
+        uint8_t byte;
+        coins_file >> byte;
+    } catch (const std::ios_base::failure&) {
+        // We expect an exception since we should be out of coins.
+        out_of_coins = true;
+    }
+    if (!out_of_coins) {
+        LogPrintf("[snapshot] bad snapshot - data left over after deserializing %d coins\n",
+                  coins_count);
+        return false;
+    }
+
+    if (in_order) {
+        stats = stats_builder.Finalize();
+    } else {
+        LogPrintf("[snapshot] coins in snapshot are not sorted by txid\n");
+        stats.reset();
+    }
+    return true;
+}
+
 bool ChainstateManager::PopulateAndValidateSnapshot(
     Chainstate& snapshot_chainstate,
     AutoFile& coins_file,
@@ -4925,107 +5517,40 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
 
     const AssumeutxoData& au_data = *maybe_au_data;
 
-    COutPoint outpoint;
-    Coin coin;
-    const uint64_t coins_count = metadata.m_coins_count;
-    uint64_t coins_left = metadata.m_coins_count;
+    // As above, okay to immediately release cs_main here since no other context knows
+    // about the snapshot_chainstate.
+    CCoinsViewDB* snapshot_coinsdb = WITH_LOCK(::cs_main, return &snapshot_chainstate.CoinsDB());
 
     LogPrintf("[snapshot] loading coins from snapshot %s\n", base_blockhash.ToString());
-    int64_t coins_processed{0};
-
-    while (coins_left > 0) {
-        try {
-            coins_file >> outpoint;
-            coins_file >> coin;
-        } catch (const std::ios_base::failure&) {
-            LogPrintf("[snapshot] bad snapshot format or truncated snapshot after deserializing %d coins\n",
-                      coins_count - coins_left);
-            return false;
-        }
-        if (coin.nHeight > base_height ||
-            outpoint.n >= std::numeric_limits<decltype(outpoint.n)>::max() // Avoid integer wrap-around in coinstats.cpp:ApplyHash
-        ) {
-            LogPrintf("[snapshot] bad snapshot data after deserializing %d coins\n",
-                      coins_count - coins_left);
-            return false;
-        }
-
-        coins_cache.EmplaceCoinInternalDANGER(std::move(outpoint), std::move(coin));
-
-        --coins_left;
-        ++coins_processed;
-
-        if (coins_processed % 1000000 == 0) {
-            LogPrintf("[snapshot] %d coins loaded (%.2f%%, %.2f MB)\n",
-                      coins_processed,
-                      static_cast<float>(coins_processed) * 100 / static_cast<float>(coins_count),
-                      coins_cache.DynamicMemoryUsage() / (1000 * 1000));
-        }
-
-        // Batch write and flush (if we need to) every so often.
-        //
-        // If our average Coin size is roughly 41 bytes, checking every 120,000 coins
-        // means <5MB of memory imprecision.
-        if (coins_processed % 120000 == 0) {
-            if (ShutdownRequested()) {
-                return false;
-            }
 
-            const auto snapshot_cache_state = WITH_LOCK(::cs_main,
-                                                        return snapshot_chainstate.GetCoinsCacheSizeState());
-
-            if (snapshot_cache_state >= CoinsCacheSizeState::CRITICAL) {
-                // This is a hack - we don't know what the actual best block is, but that
-                // doesn't matter for the purposes of flushing the cache here. We'll set this
-                // to its correct value (`base_blockhash`) below after the coins are loaded.
-                coins_cache.SetBestBlock(GetRandHash());
-
-                // No need to acquire cs_main since this chainstate isn't being used yet.
-                FlushSnapshotToDisk(coins_cache, /*snapshot_loaded=*/false);
-            }
-        }
+    // The coins go straight to the database, so the cache stays empty.
+    std::optional<CCoinsStats> maybe_stats;
+    if (!LoadSnapshotCoins(coins_file, metadata, base_height, *snapshot_coinsdb, maybe_stats)) {
+        return false;
     }
 
-    // Important that we set this. This and the coins_cache accesses above are
-    // sort of a layer violation, but either we reach into the innards of
-    // CCoinsViewCache here or we have to invert some of the Chainstate to
-    // embed them in a snapshot-activation-specific CCoinsViewCache bulk load
-    // method.
+    // Important that we set this. This is sort of a layer violation, but
+    // either we reach into the innards of CCoinsViewCache here or we have to
+    // invert some of the Chainstate to embed them in a
+    // snapshot-activation-specific CCoinsViewCache bulk load method.
     coins_cache.SetBestBlock(base_blockhash);
 
-    bool out_of_coins{false};
-    try {
-        coins_file >> outpoint;
-    } catch (const std::ios_base::failure&) {
-        // We expect an exception since we should be out of coins.
-        out_of_coins = true;
-    }
-    if (!out_of_coins) {
-        LogPrintf("[snapshot] bad snapshot - coins left over after deserializing %d coins\n",
-                  coins_count);
-        return false;
-    }
-
-    LogPrintf("[snapshot] loaded %d (%.2f MB) coins from snapshot %s\n",
-              coins_count,
-              coins_cache.DynamicMemoryUsage() / (1000 * 1000),
+    LogPrintf("[snapshot] loaded %d coins from snapshot %s\n",
+              metadata.m_coins_count,
               base_blockhash.ToString());
 
     // No need to acquire cs_main since this chainstate isn't being used yet.
-    FlushSnapshotToDisk(coins_cache, /*snapshot_loaded=*/true);
+    FlushSnapshotToDisk(coins_cache);
 
     assert(coins_cache.GetBestBlock() == base_blockhash);
 
-    auto breakpoint_fnc = [] { /* TODO insert breakpoint here? */ };
-
-    // As above, okay to immediately release cs_main here since no other context knows
-    // about the snapshot_chainstate.
-    CCoinsViewDB* snapshot_coinsdb = WITH_LOCK(::cs_main, return &snapshot_chainstate.CoinsDB());
-
-    const std::optional<CCoinsStats> maybe_stats = ComputeUTXOStats(CoinStatsHashType::HASH_SERIALIZED, snapshot_coinsdb, m_blockman, breakpoint_fnc);
-    if (!maybe_stats.has_value()) {
-        LogPrintf("[snapshot] failed to generate coins stats\n");
-        return false;
+    if (!maybe_stats) {
+        auto breakpoint_fnc = [] { /* TODO insert breakpoint here? */ };
+        maybe_stats = ComputeUTXOStats(CoinStatsHashType::HASH_SERIALIZED, snapshot_coinsdb, m_blockman, breakpoint_fnc);
+        if (!maybe_stats.has_value()) {
+            LogPrintf("[snapshot] failed to generate coins stats\n");
+            return false;
+        }
     }
 
     // Assert that the deserialized chainstate contents match the expected assumeutxo value.
@@ -19,6 +19,7 @@
 #include <deploymentstatus.h>
 #include <fs.h>
 #include <kernel/chainstatemanager_opts.h>
+#include <kernel/mempool_persist.h>
 #include <node/blockstorage.h>
 #include <policy/feerate.h>
 #include <policy/packages.h>
@@ -53,6 +54,9 @@ struct DisconnectedBlockTransactions;
 struct PrecomputedTransactionData;
 struct LockPoints;
 struct AssumeutxoData;
+namespace kernel {
+struct CCoinsStats;
+} // namespace kernel
 namespace node {
 class SnapshotMetadata;
 } // namespace node
@@ -64,6 +68,10 @@ struct Params;
 static const int MAX_SCRIPTCHECK_THREADS = 15;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/** Maximum number of dedicated input-prefetching threads allowed */
+static const int MAX_INPUTFETCH_THREADS = 16;
+/** -inputfetchthreads default (number of input-prefetching threads, 0 = disabled) */
+static const int DEFAULT_INPUTFETCH_THREADS = 0;
 static const int64_t DEFAULT_MAX_TIP_AGE = 24 * 60 * 60;
 static const bool DEFAULT_CHECKPOINTS_ENABLED = true;
 static const bool DEFAULT_TXINDEX = false;
@@ -101,6 +109,10 @@ extern uint256 g_best_block;
  * False indicates all script checking is done on the main threadMessageHandler thread.
  */
 extern bool g_parallel_script_checks;
+/** Whether there are dedicated threads prefetching block inputs from the coins database.
+ * False indicates ConnectBlock() reads missing inputs one at a time as it needs them.
+ */
+extern bool g_parallel_input_fetch;
 extern bool fCheckBlockIndex;
 extern bool fCheckpointsEnabled;
 /** If the tip is older than this (in seconds), the node is considered to be in initial block download. */
@@ -119,6 +131,10 @@ extern const std::vector<std::string> CHECKLEVEL_DOC;
 void StartScriptCheckWorkerThreads(int threads_num);
 /** Stop all of the script checking worker threads */
 void StopScriptCheckWorkerThreads();
+/** Run instances of input prefetching worker threads */
+void StartInputFetchWorkerThreads(int threads_num);
+/** Stop all of the input prefetching worker threads */
+void StopInputFetchWorkerThreads();
 
 CAmount GetBlockSubsidy(int nHeight, const Consensus::Params& consensusParams);
 
@@ -232,6 +248,23 @@ struct PackageMempoolAcceptResult {
         : m_tx_results{{wtxid, result}} {}
 };
 
+/**
+ * Result of verifying the scripts of a transaction without holding cs_main, see
+ * ChainstateManager::PrecheckTransactionScripts(). Mempool acceptance uses it
+ * instead of verifying the scripts again, as long as the transaction still
+ * spends the same outputs and the tip's script flags didn't change.
+ */
+struct PrecheckedScripts {
+    //! The transaction whose scripts were verified
+    uint256 m_wtxid;
+    //! The outputs it spent when they were verified
+    std::vector<CTxOut> m_spent_outputs;
+    //! The script flags of the tip they were verified against, besides the standard flags
+    unsigned int m_script_flags{0};
+    //! Whether the scripts are valid, or why not
+    TxValidationState m_state;
+};
+
 /**
  * Try to add a transaction to the mempool. This is an internal function and is exposed only for testing.
  * Client code should use ChainstateManager::ProcessTransaction()
@@ -242,11 +275,17 @@ struct PackageMempoolAcceptResult {
  *                                It is also used to determine when the entry expires.
  * @param[in]  bypass_limits      When true, don't enforce mempool fee and capacity limits.
  * @param[in]  test_accept        When true, run validation checks but don't submit to mempool.
+ * @param[in]  skip_script_checks When true, don't verify the scripts. Only for transactions whose
+ *                                scripts were verified under the current tip and script flags.
+ * @param[in]  prechecked         If set, the result of verifying the scripts of tx beforehand, which
+ *                                is used instead of verifying them again if it still applies.
  *
  * @returns a MempoolAcceptResult indicating whether the transaction was accepted/rejected with reason.
  */
 MempoolAcceptResult AcceptToMemoryPool(Chainstate& active_chainstate, const CTransactionRef& tx,
-                                       int64_t accept_time, bool bypass_limits, bool test_accept)
+                                       int64_t accept_time, bool bypass_limits, bool test_accept,
+                                       bool skip_script_checks = false,
+                                       const PrecheckedScripts* prechecked = nullptr)
     EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
 /**
@@ -713,7 +752,7 @@ public:
     void CheckBlockIndex();
 
     /** Load the persisted mempool from disk */
-    void LoadMempool(const fs::path& load_path, fsbridge::FopenFn mockable_fopen_function = fsbridge::fopen);
+    void LoadMempool(const fs::path& load_path, kernel::ImportMempoolOptions&& opts = {});
 
     /** Update the chain tip based on database information, i.e. CoinsTip()'s best block. */
     bool LoadChainTip() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
@@ -873,7 +912,9 @@ private:
 public:
     using Options = kernel::ChainstateManagerOpts;
 
-    explicit ChainstateManager(Options options) : m_options{std::move(options)}
+    explicit ChainstateManager(Options options, node::BlockManager::Options blockman_options)
+        : m_options{std::move(options)},
+          m_blockman{std::move(blockman_options)}
     {
         Assert(m_options.adjusted_time_callback);
     }
@@ -1033,10 +1074,26 @@ public:
      *
      * @param[in]  tx              The transaction to submit for mempool acceptance.
      * @param[in]  test_accept     When true, run validation checks but don't submit to mempool.
+     * @param[in]  prechecked      If set, the result of PrecheckTransactionScripts() for tx.
      */
-    [[nodiscard]] MempoolAcceptResult ProcessTransaction(const CTransactionRef& tx, bool test_accept = false)
+    [[nodiscard]] MempoolAcceptResult ProcessTransaction(const CTransactionRef& tx, bool test_accept = false,
+                                                         const PrecheckedScripts* prechecked = nullptr)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /**
+     * Verify the scripts of a transaction against a snapshot of the coins it
+     * spends, holding cs_main only while taking the snapshot. Passing the
+     * result to ProcessTransaction() lets it skip verifying the scripts under
+     * cs_main, whether they turned out valid or not. Nothing is stored in the
+     * signature or script caches; that only happens once the transaction is
+     * accepted.
+     *
+     * @returns nullopt, without verifying anything, if the transaction fails
+     *          the cheaper mempool policy checks or package limits, or
+     *          conflicts with a mempool transaction.
+     */
+    std::optional<PrecheckedScripts> PrecheckTransactionScripts(const CTransactionRef& tx) LOCKS_EXCLUDED(cs_main);
+
     //! Load the block tree and coins database from disk, initializing state if we're running with -reindex
     bool LoadBlockIndex() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
@@ -1087,4 +1144,19 @@ bool DeploymentEnabled(const ChainstateManager& chainman, DEP dep)
  */
 const AssumeutxoData* ExpectedAssumeutxo(const int height, const CChainParams& params);
 
+/**
+ * Write the coins of a UTXO snapshot straight to a coins database, bypassing
+ * its cache. Chunks of coins are deserialized and written in parallel, and
+ * the coins are hashed while they are loaded.
+ *
+ * @param[in] coins_file   The snapshot, positioned after its metadata.
+ * @param[in] base_height  Height of the snapshot's base block; no coin may be younger.
+ * @param[out] stats       The HASH_SERIALIZED statistics of the coins, or
+ *                         nullopt if they weren't sorted by txid, in which case
+ *                         they must be computed from the database.
+ * @returns false if the snapshot is malformed or contains an invalid coin.
+ */
+bool LoadSnapshotCoins(AutoFile& coins_file, const node::SnapshotMetadata& metadata, int base_height,
+                       CCoinsViewDB& coins_db, std::optional<kernel::CCoinsStats>& stats);
+
 #endif // KOYOTECOIN_VALIDATION_H
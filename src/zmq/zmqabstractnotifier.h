@@ -7,6 +7,7 @@
 #define KOYOTECOIN_ZMQ_ZMQABSTRACTNOTIFIER_H
 
 
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -14,7 +15,7 @@ class CBlockIndex;
 class CTransaction;
 class CZMQAbstractNotifier;
 
-using CZMQNotifierFactory = std::unique_ptr<CZMQAbstractNotifier> (*)();
+using CZMQNotifierFactory = std::function<std::unique_ptr<CZMQAbstractNotifier>()>;
 
 class CZMQAbstractNotifier
 {
@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023-2023 The Koyotecoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test loading a UTXO snapshot written by dumptxoutset with loadtxoutset.
+
+The regtest chain parameters commit to the UTXO set of a chain of 199 blocks
+mined to raw(51) at a fixed mock time. The set's hash also covers the base
+block hash, so the blocks' timestamps must be the same on every run.
+"""
+import shutil
+from pathlib import Path
+
+from test_framework.test_framework import KoyotecoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_raises_rpc_error,
+)
+
+SNAPSHOT_BASE_HEIGHT = 199
+# Shortly after the regtest genesis block
+SNAPSHOT_MOCKTIME = 1672773307 + 600
+SNAPSHOT_HASH = 'b3b33b135ceef5f57043e91168d2ca657ad41efeafbd7233b5e90fad4cf61f07'
+# Magic bytes, version, base block hash, coin count, chunk count, index offset
+SNAPSHOT_METADATA_SIZE = 5 + 2 + 32 + 3 * 8
+# Coin count, size, checksum
+SNAPSHOT_CHUNK_HEADER_SIZE = 2 * 4 + 32
+
+
+class AssumeutxoTest(KoyotecoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+
+    def setup_network(self):
+        # The nodes stay disconnected, so that the second one only learns
+        # about the blocks' headers.
+        self.setup_nodes()
+
+    def run_test(self):
+        n0, n1 = self.nodes
+
+        self.log.info(f"Dump snapshots at heights {SNAPSHOT_BASE_HEIGHT} and {SNAPSHOT_BASE_HEIGHT + 1}")
+        n0.setmocktime(SNAPSHOT_MOCKTIME)
+        self.generatetodescriptor(n0, SNAPSHOT_BASE_HEIGHT, 'raw(51)', sync_fun=self.no_op)
+        dump = n0.dumptxoutset('utxos.dat')
+        assert_equal(dump['base_height'], SNAPSHOT_BASE_HEIGHT)
+        assert_equal(dump['coins_written'], SNAPSHOT_BASE_HEIGHT)
+        assert_equal(dump['txoutset_hash'], SNAPSHOT_HASH)
+        assert_equal(dump['nchaintx'], SNAPSHOT_BASE_HEIGHT + 1)
+        expected_utxo_info = n0.gettxoutsetinfo()
+        self.generatetodescriptor(n0, 1, 'raw(51)', sync_fun=self.no_op)
+        uncommitted_dump = n0.dumptxoutset('uncommitted_utxos.dat')
+
+        self.log.info("Reject a snapshot whose base block header is unknown")
+        assert_raises_rpc_error(-5, f"Block header of the snapshot base {dump['base_hash']} not found",
+                                n1.loadtxoutset, dump['path'])
+
+        for height in range(1, SNAPSHOT_BASE_HEIGHT + 2):
+            n1.submitheader(n0.getblockheader(n0.getblockhash(height), False))
+
+        self.log.info("Reject a snapshot at a height without assumeutxo commitment")
+        assert_raises_rpc_error(-1, f"No assumeutxo commitment for snapshots at height {SNAPSHOT_BASE_HEIGHT + 1}",
+                                n1.loadtxoutset, uncommitted_dump['path'])
+
+        self.log.info("Reject a snapshot with a malleated coin")
+        bad_path = Path(n1.datadir) / self.chain / 'bad_utxos.dat'
+        shutil.copyfile(dump['path'], bad_path)
+        with open(bad_path, 'r+b') as f:
+            f.seek(SNAPSHOT_METADATA_SIZE + SNAPSHOT_CHUNK_HEADER_SIZE + 40)
+            byte = f.read(1)
+            f.seek(-1, 1)
+            f.write(bytes([byte[0] ^ 1]))
+        assert_raises_rpc_error(-32603, "Unable to load UTXO snapshot", n1.loadtxoutset, str(bad_path))
+        assert_equal(n1.getblockcount(), 0)
+
+        self.log.info("Load the snapshot and check its UTXO set")
+        loaded = n1.loadtxoutset(dump['path'])
+        assert_equal(loaded['coins_loaded'], SNAPSHOT_BASE_HEIGHT)
+        assert_equal(loaded['tip_hash'], dump['base_hash'])
+        assert_equal(loaded['base_height'], SNAPSHOT_BASE_HEIGHT)
+        assert_equal(n1.getbestblockhash(), dump['base_hash'])
+        utxo_info = n1.gettxoutsetinfo()
+        assert_equal(utxo_info['hash_serialized_2'], SNAPSHOT_HASH)
+        for key in ['height', 'bestblock', 'txouts', 'transactions', 'total_amount']:
+            assert_equal(utxo_info[key], expected_utxo_info[key])
+
+        self.log.info("Reject loading a second snapshot")
+        assert_raises_rpc_error(-32603, "Unable to load UTXO snapshot", n1.loadtxoutset, dump['path'])
+
+
+if __name__ == '__main__':
+    AssumeutxoTest().main()
@@ -124,5 +124,36 @@ class AddrTest(KoyotecoinTestFramework):
         assert(set(last_response_on_onion_bind1) != set(addr_receiver_onion1.get_received_addrs()))
         assert(set(last_response_on_onion_bind2) != set(addr_receiver_onion2.get_received_addrs()))
 
+        self.log.info('Serve concurrent addr requests from several message handler threads')
+        self.restart_node(0, extra_args=self.extra_args[0] + ["-msghandthreads=4"])
+        assert(len(self.nodes[0].getnodeaddresses(0)) > int(MAX_ADDR_TO_SEND / (MAX_PCT_ADDR_TO_SEND / 100)))
+        # Peers are spread over the threads by id, so the requests of
+        # consecutive peers on the same bind hit the shared cache from
+        # different threads.
+        receivers = {}
+        for port in [None, self.onion_port1, self.onion_port2]:
+            kwargs = {} if port is None else {"dstport": port}
+            receivers[port] = [self.nodes[0].add_p2p_connection(AddrReceiver(), **kwargs) for _ in range(8)]
+        for receiver in sum(receivers.values(), []):
+            receiver.send_message(msg_getaddr())
+        for receiver in sum(receivers.values(), []):
+            receiver.sync_with_ping()
+
+        # Trigger responses
+        cur_mock_time = int(time.time()) + 5 * 60
+        self.nodes[0].setmocktime(cur_mock_time)
+        responses = {}
+        for port, bind_receivers in receivers.items():
+            for receiver in bind_receivers:
+                receiver.wait_until(receiver.addr_received)
+            responses[port] = [receiver.get_received_addrs() for receiver in bind_receivers]
+            # All peers on a bind got the same cached response
+            for response in responses[port]:
+                assert_equal(len(response), MAX_ADDR_TO_SEND)
+                assert_equal(response, responses[port][0])
+        assert(responses[None][0] != responses[self.onion_port1][0])
+        assert(responses[None][0] != responses[self.onion_port2][0])
+        assert(responses[self.onion_port1][0] != responses[self.onion_port2][0])
+
 if __name__ == '__main__':
     AddrTest().main()
@@ -220,6 +220,7 @@ BASE_SCRIPTS = [
     'p2p_invalid_messages.py',
     'p2p_invalid_tx.py',
     'feature_assumevalid.py',
+    'feature_assumeutxo.py',
     'example_test.py',
     'wallet_txn_doublespend.py --legacy-wallet',
     'wallet_multisig_descriptor_pskt.py',